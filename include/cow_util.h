@@ -0,0 +1,171 @@
+#ifndef COW_UTIL_H
+#define COW_UTIL_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "common_util.h"
+
+/**
+ * copy-on-write 快照共用的版本管理：
+ *
+ * 建立快照只遞增全域世代並登記快照的根容器，不複製任何資料，
+ * 容器在快照之後第一次寫入前，把目前的狀態凍結成一個版本(只複製容器的描述，陣列、元素與快照共用)，
+ * 之後寫入時才複製碰到的陣列與元素，被移除的元素交給仍可能讀到它的版本保管，
+ * 讀取端以 CowUtil_SetReadGeneration 進入快照後，每個容器各自以 CowUtil_Resolve 找到快照當下的版本，
+ * 快照結束後，不再被任何快照需要的版本在下一次寫入時釋放
+ *
+ * 寫入端對同一棵容器樹必須是單一執行緒(或由呼叫端加鎖)，建立快照時也不可同時寫入，
+ * 讀取端可以在任何執行緒讀取快照，不需與寫入端同步
+ */
+
+/**
+ * 凍結的版本，由容器的描述、可讀取的快照世代範圍與保管的元素組成
+ */
+typedef struct CowUtil_Version CowUtil_Version;
+
+/**
+ * 容器提供的回呼，owner 為容器本身
+ *
+ * freeze: 複製目前的容器描述作為凍結的版本，陣列與容器共用，回傳版本資料
+ * release: 釋放版本資料，陣列仍與容器共用時交還給容器，不可釋放
+ * drop: 釋放版本保管的元素
+ */
+typedef struct CowUtil_Ops
+{
+    void* (*freeze)(void *owner);
+    void (*release)(void *owner, void *data);
+    void (*drop)(void *owner, void *ptr);
+} CowUtil_Ops;
+
+/**
+ * 每個容器一份的版本狀態
+ */
+typedef struct CowUtil_State
+{
+    pthread_mutex_t lock;
+    /**
+     * 最近一次檢查快照時的全域世代，與全域世代相同時寫入不需加鎖
+     */
+    _Atomic uint64_t checked;
+    /**
+     * 目前的狀態從哪個世代開始可被快照讀取
+     */
+    uint64_t from;
+    /**
+     * 每凍結一次遞增，元素放入時記下當時的值，用以判定元素是否與版本共用
+     */
+    int epoch;
+    /**
+     * 凍結後尚未修改，再次凍結時直接延長最新的版本
+     */
+    bool frozen;
+    /**
+     * 由新到舊串接的版本
+     */
+    CowUtil_Version *newest;
+    /**
+     * 容納此容器的上層容器，用以判定快照是否包含此容器，
+     * 共用的子樹可以同時放在多個上層容器中，第二個之後的記錄放在 more_parents，
+     * 同一個上層容器放入幾次就記錄幾次，由全域的快照鎖保護
+     */
+    struct CowUtil_State *parent;
+    struct CowUtil_State **more_parents;
+    int more_count;
+    int more_capacity;
+    /**
+     * 容器內容的結構雜湊值(GenericType_Hash)，0 代表尚未計算或已失效，
+     * 有效時其中所有子容器的雜湊值也都有效，內容修改時連同所有上層容器一併失效
+     */
+    _Atomic uint64_t hash;
+} CowUtil_State;
+
+void CowUtil_Init(CowUtil_State *state);
+
+/**
+ * 容器解構前呼叫，釋放所有版本與其保管的元素，須在容器釋放自己的陣列之前呼叫
+ */
+void CowUtil_Destroy(CowUtil_State *state, const CowUtil_Ops *ops, void *owner);
+
+/**
+ * 記錄容器放入上層容器，回傳加入後的記錄數量，會形成循環時忽略並回傳 0，
+ * 每次成功加入都需要對應一次 CowUtil_RemoveParent，記錄超過一筆時才會配置記憶體
+ */
+int CowUtil_AddParent(CowUtil_State *state, CowUtil_State *parent);
+
+/**
+ * 容器從上層容器移除時呼叫，只移除一筆記錄
+ */
+void CowUtil_RemoveParent(CowUtil_State *state, CowUtil_State *parent);
+
+/**
+ * 以 root 為根建立快照，回傳快照的世代
+ */
+uint64_t CowUtil_BeginSnapshot(CowUtil_State *root);
+
+/**
+ * 結束快照，之後的寫入會釋放不再需要的版本
+ */
+void CowUtil_EndSnapshot(uint64_t generation);
+
+/**
+ * 目前執行緒讀取的快照世代，0 代表讀取目前的資料
+ */
+uint64_t CowUtil_ReadGeneration(void);
+
+void CowUtil_SetReadGeneration(uint64_t generation);
+
+/**
+ * 每次寫入(或取得可修改的元素)前呼叫，
+ * 全域世代改變後才會加鎖：釋放不再需要的版本，有快照需要目前的狀態時先凍結
+ */
+void CowUtil_PrepareWrite(CowUtil_State *state, const CowUtil_Ops *ops, void *owner);
+
+/**
+ * 使容器與所有上層容器記下的雜湊值失效，遇到已失效的容器就停止，已失效時不需加鎖
+ */
+void CowUtil_InvalidateHash(CowUtil_State *state);
+
+/**
+ * 取得記下的雜湊值，0 代表沒有
+ */
+static inline uint64_t CowUtil_CachedHash(CowUtil_State *state)
+{
+    return atomic_load_explicit(&(state->hash), memory_order_acquire);
+}
+
+/**
+ * 記下雜湊值，hash 不可為 0，須在子容器的雜湊值都已記下之後呼叫
+ */
+static inline void CowUtil_SetCachedHash(CowUtil_State *state, uint64_t hash)
+{
+    atomic_store_explicit(&(state->hash), hash, memory_order_release);
+}
+
+/**
+ * 實際修改容器前呼叫，之後再次凍結時會建立新的版本，記下的雜湊值失效
+ */
+static inline void CowUtil_MarkModified(CowUtil_State *state)
+{
+    state->frozen = false;
+    if (atomic_load_explicit(&(state->hash), memory_order_relaxed)) CowUtil_InvalidateHash(state);
+}
+
+/**
+ * 放入時記下 epoch 的元素是否仍與最新的版本共用，CowUtil_PrepareWrite 之後才可呼叫
+ */
+bool CowUtil_IsShared(CowUtil_State *state, int epoch);
+
+/**
+ * 移除元素，仍與版本共用時交給最新的版本保管，否則立即以 drop 釋放
+ */
+void CowUtil_Retire(CowUtil_State *state, const CowUtil_Ops *ops, void *owner, void *ptr, int epoch);
+
+/**
+ * 找到快照 generation 讀取的版本，回傳 freeze 產生的版本資料，
+ * 容器在快照之後尚未寫入時先凍結目前的狀態，找不到時回傳 NULL
+ */
+void* CowUtil_Resolve(CowUtil_State *state, const CowUtil_Ops *ops, void *owner, uint64_t generation);
+
+#endif
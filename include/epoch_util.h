@@ -0,0 +1,58 @@
+#ifndef EPOCH_UTIL_H
+#define EPOCH_UTIL_H
+
+/**
+ * 以世代(epoch)延後釋放記憶體的工具，讓讀取端不需要任何鎖：
+ *
+ * 讀取端在 EpochUtil_Enter、EpochUtil_Exit 之間存取共用資料，這段期間只寫入自己執行緒的世代紀錄，
+ * 寫入端把資料從共用結構中拿掉之後，不直接釋放，而是呼叫 EpochUtil_Retire 交給本工具，
+ * 等到所有讀取端都離開拿掉當下的世代，才會真正呼叫釋放函式
+ */
+
+/**
+ * 延後釋放時呼叫的函式
+ */
+typedef void (*EpochUtil_FreeFn)(void *ptr);
+
+/**
+ * 進入讀取區段，可以巢狀呼叫，不會阻塞
+ */
+void EpochUtil_Enter(void);
+
+/**
+ * 離開讀取區段，離開後不可再使用區段中取得的共用資料
+ */
+void EpochUtil_Exit(void);
+
+/**
+ * 登記一塊已從共用結構中拿掉的記憶體，所有讀取端離開目前世代後以 free_fn 釋放，
+ * 也會順便嘗試推進世代並釋放已到期的記憶體
+ */
+void EpochUtil_Retire(void *ptr, EpochUtil_FreeFn free_fn);
+
+/**
+ * 同 EpochUtil_Retire，並記下登記這塊記憶體的共用結構 owner，
+ * 讓 owner 解構時可以用 EpochUtil_FreeOwned 只處理自己登記的記憶體
+ */
+void EpochUtil_RetireOwned(const void *owner, void *ptr, EpochUtil_FreeFn free_fn);
+
+/**
+ * 立即釋放 owner 登記且尚未釋放的記憶體，不等待世代推進，也不受其他共用結構登記的記憶體影響，
+ * 呼叫端須保證已沒有讀取端能存取 owner 的共用資料(例如 owner 解構時)，可在讀取區段中呼叫
+ */
+void EpochUtil_FreeOwned(const void *owner);
+
+/**
+ * 嘗試推進世代並釋放已到期的記憶體，不會阻塞，
+ * 回傳仍在等待釋放的數量
+ */
+int EpochUtil_Reclaim(void);
+
+/**
+ * 等待目前為止登記的記憶體全部釋放(包含所有共用結構登記的)，
+ * 會等待正在讀取區段中的其他執行緒，不可在讀取區段中呼叫，其他執行緒持續登記時可能一直無法返回，
+ * 只需要處理單一共用結構時改用 EpochUtil_FreeOwned
+ */
+void EpochUtil_Synchronize(void);
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef GENERIC_ARENA_H
+#define GENERIC_ARENA_H
+
+#include <stddef.h>
+
+/**
+ * 區塊配置器(arena)，從整塊的記憶體依序切出小塊空間，不支援個別釋放，
+ * 解構或重設時才一次釋放所有區塊，適合建立後很快就整個丟棄的資料，
+ * 例如每個請求建立一次的文件樹
+ *
+ * 以 New_GenericTable_InArena、New_GenericList_InArena 建構的容器，
+ * 其映射物件、key、值與容器本身都配置在 arena 中，
+ * 對這些容器呼叫 Delete_GenericTable、Delete_GenericList 不會釋放任何記憶體
+ */
+typedef struct GenericArena GenericArena;
+
+/**
+ * 解構或重設 arena 時呼叫的清理函式
+ */
+typedef void (*GenericArena_CleanupFn)(void *ptr);
+
+/**
+ * 建構預設區塊大小的 arena
+ */
+GenericArena* New_GenericArena(void);
+
+/**
+ * 建構指定區塊大小的 arena，超過區塊大小四分之一的配置會獨立使用一個區塊
+ */
+GenericArena* New_GenericArena_WithChunkSize(size_t chunk_size);
+
+/**
+ * 解構 arena，依登記的相反順序呼叫清理函式後，釋放所有區塊
+ * **p_arena: arena 自身的位址指標 ex: &arena
+ */
+void Delete_GenericArena(GenericArena **p_arena);
+
+/**
+ * 呼叫清理函式並丟棄所有配置，保留第一個區塊重複使用，
+ * 重設前在 arena 中建構的容器都不可再使用
+ */
+void GenericArena_Reset(GenericArena *arena);
+
+/**
+ * 配置 size 個位元組，對齊 16 個位元組，內容未初始化
+ */
+void* GenericArena_Alloc(GenericArena *arena, size_t size);
+
+/**
+ * 配置 size 個位元組並清為 0
+ */
+void* GenericArena_Calloc(GenericArena *arena, size_t size);
+
+/**
+ * 在 arena 中複製字串
+ */
+char* GenericArena_StrDup(GenericArena *arena, const char *str);
+
+/**
+ * 登記解構或重設 arena 時要呼叫的清理函式，
+ * 用來釋放放入 arena 容器中、但不是配置在 arena 中的物件
+ */
+void GenericArena_AddCleanup(GenericArena *arena, GenericArena_CleanupFn cleanup, void *ptr);
+
+/**
+ * 取得目前已配置的位元組數量(含對齊)
+ */
+size_t GenericArena_BytesUsed(GenericArena *arena);
+
+#endif
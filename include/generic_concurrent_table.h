@@ -0,0 +1,126 @@
+#ifndef GENERIC_CONCURRENT_TABLE_H
+#define GENERIC_CONCURRENT_TABLE_H
+
+#include "generic_table.h"
+
+struct GenericList;
+struct GenericType;
+
+/**
+ * 多執行緒共用的映射表，依 key 的雜湊值分散到多個分片(shard)，
+ * 每個分片是一個獨立的 GenericTable，並各自擁有一把讀寫鎖，
+ * 不同分片的操作互不阻擋，同一分片的查找可以同時進行
+ */
+typedef struct GenericConcurrentTable GenericConcurrentTable;
+
+/**
+ * 走訪時的回呼函式，回呼期間持有該分片的讀取鎖，
+ * 不可在回呼中修改同一個 GenericConcurrentTable
+ */
+typedef void (*GenericConcurrentTable_Visitor)(const char *key, struct GenericType *value, void *context);
+
+/**
+ * 建構指定分片數量的映射表，分片數量會進位到 2 的次方，
+ * shard_count <= 0 時使用預設數量
+ */
+GenericConcurrentTable* New_GenericConcurrentTable(int shard_count);
+
+/**
+ * 建構映射表，每個分片都以 options 建構，
+ * options 中的 rehash_on_lookup 一律關閉，查找才能在讀取鎖內同時進行
+ */
+GenericConcurrentTable* New_GenericConcurrentTable_WithOptions(int shard_count, const GenericTableOptions *options);
+
+/**
+ * 解構映射表，呼叫時不可有其他執行緒仍在使用
+ * **p_table: 映射表自身的位址指標 ex: &table
+ */
+void Delete_GenericConcurrentTable(GenericConcurrentTable **p_table);
+
+/**
+ * 映射表新增物件的泛型方法，
+ * 當 key 已存在時，會更新原本映射的物件
+ */
+#define GenericConcurrentTable_Add(table, key, value) _Generic((value),\
+    const char*: GenericConcurrentTable_Add_Str,\
+    char*: GenericConcurrentTable_Add_Str,\
+    int: GenericConcurrentTable_Add_Int,\
+    long: GenericConcurrentTable_Add_Long,\
+    double: GenericConcurrentTable_Add_Double,\
+    float: GenericConcurrentTable_Add_Float,\
+    GenericTable*: GenericConcurrentTable_Add_Table,\
+    struct GenericList*: GenericConcurrentTable_Add_List\
+)(table, key, value)
+
+void GenericConcurrentTable_Add_Str(GenericConcurrentTable *table, const char *key, const char *value);
+
+void GenericConcurrentTable_Add_Int(GenericConcurrentTable *table, const char *key, int value);
+
+void GenericConcurrentTable_Add_Long(GenericConcurrentTable *table, const char *key, long value);
+
+void GenericConcurrentTable_Add_Double(GenericConcurrentTable *table, const char *key, double value);
+
+void GenericConcurrentTable_Add_Float(GenericConcurrentTable *table, const char *key, float value);
+
+void GenericConcurrentTable_Add_Table(GenericConcurrentTable *table, const char *key, GenericTable *value);
+
+void GenericConcurrentTable_Add_List(GenericConcurrentTable *table, const char *key, struct GenericList *value);
+
+/**
+ * 查找字串，回傳的是複製品，使用完後需自行 free，
+ * 如 key 不存在，或查找出的值並非字串，將回傳 NULL
+ */
+char* GenericConcurrentTable_Find_Str(GenericConcurrentTable *table, const char *key);
+
+/**
+ * 查找整數並寫入 out，
+ * 如 key 不存在，或查找出的值並非整數，將回傳 false 且不修改 out
+ */
+bool GenericConcurrentTable_Find_Int(GenericConcurrentTable *table, const char *key, int *out);
+
+/**
+ * 查找長整數並寫入 out，
+ * 如 key 不存在，或查找出的值並非長整數，將回傳 false 且不修改 out
+ */
+bool GenericConcurrentTable_Find_Long(GenericConcurrentTable *table, const char *key, long *out);
+
+/**
+ * 查找雙經度浮點數並寫入 out，
+ * 如 key 不存在，或查找出的值並非雙經度浮點數，將回傳 false 且不修改 out
+ */
+bool GenericConcurrentTable_Find_Double(GenericConcurrentTable *table, const char *key, double *out);
+
+/**
+ * 查找單經度浮點數並寫入 out，
+ * 如 key 不存在，或查找出的值並非單經度浮點數，將回傳 false 且不修改 out
+ */
+bool GenericConcurrentTable_Find_Float(GenericConcurrentTable *table, const char *key, float *out);
+
+/**
+ * 在持有讀取鎖的情況下，以 key 對應的物件呼叫 reader，
+ * 適合讀取映射表、動態陣列等無法複製的值，key 不存在時回傳 false
+ */
+bool GenericConcurrentTable_Read(GenericConcurrentTable *table, const char *key, GenericConcurrentTable_Visitor reader, void *context);
+
+/**
+ * 移除映射表中 key 對應到的物件
+ */
+void GenericConcurrentTable_Delete(GenericConcurrentTable *table, const char *key);
+
+/**
+ * 在映射表中查找 key 是否存在
+ */
+bool GenericConcurrentTable_HasKey(GenericConcurrentTable *table, const char *key);
+
+/**
+ * 取得映射表當前物件數量，逐一鎖定各分片加總，
+ * 其他執行緒同時修改時，結果只代表呼叫期間的某個近似值
+ */
+int GenericConcurrentTable_Size(GenericConcurrentTable *table);
+
+/**
+ * 依序走訪每個分片中的所有物件，走訪一個分片時持有該分片的讀取鎖
+ */
+void GenericConcurrentTable_ForEach(GenericConcurrentTable *table, GenericConcurrentTable_Visitor visitor, void *context);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef GENERIC_DEDUP_H
+#define GENERIC_DEDUP_H
+
+#include <stddef.h>
+
+#include "generic_table.h"
+#include "generic_list.h"
+
+/**
+ * 結構去重(hash-consing)：把內容相同的映射表、動態陣列合併為同一個以參考計數共用的節點
+ *
+ * 由上而下走訪容器樹，每個子容器以結構雜湊值(GenericType_Hash)與
+ * GenericType_Equals 找出先前登記過、內容相同的節點，找到時以該節點取代(遞增參考計數)，
+ * 原本的子樹遞減參考計數後釋放，不必再走訪，找不到時先去重其中的子容器再登記為新的節點
+ *
+ * 同一個 GenericDedup 可以依序套用在多份文件上，後來的文件與先前的文件共用相同的子樹，
+ * 登記的節點由 GenericDedup 持有一個參考，載入完成後即可解構 GenericDedup，已共用的節點不受影響
+ *
+ * 注意：
+ * 1. 去重後的子樹由多個上層容器共用，經由任一個上層容器就地修改，其他上層容器也會看到，
+ *    去重後的文件應視為不可變，需要修改時改以新的映射表、動態陣列取代整個子樹
+ * 2. 字串值不在 arena 中時已經由字串池共用，不需再去重，arena 中的映射表、動態陣列與其子樹不會去重
+ * 3. 根容器本身不會被取代，只有其中的子容器會
+ * 4. 快照中不可呼叫，呼叫時不可同時讀寫這棵容器樹
+ */
+typedef struct GenericDedup GenericDedup;
+
+GenericDedup* New_GenericDedup(void);
+
+/**
+ * 釋放登記的節點(遞減參考計數)，已共用的節點仍由各個上層容器持有
+ * **p_dedup: 自身的位址指標 ex: &dedup
+ */
+void Delete_GenericDedup(GenericDedup **p_dedup);
+
+/**
+ * 去重 table 中的所有子容器，回傳這次省下的估計位元組數
+ */
+size_t GenericDedup_Table(GenericDedup *dedup, GenericTable *table);
+
+/**
+ * 去重 list 中的所有子容器，回傳這次省下的估計位元組數
+ */
+size_t GenericDedup_List(GenericDedup *dedup, GenericList *list);
+
+/**
+ * 累計省下的估計位元組數：被取代的子樹中每個映射表、動態陣列(GenericTable_BytesUsed、GenericList_BytesUsed)的總和，
+ * 被取代的節點仍被其他地方參考時實際上不會釋放，不含 GenericDedup 登記表本身佔用的記憶體
+ */
+size_t GenericDedup_BytesSaved(GenericDedup *dedup);
+
+/**
+ * 累計被取代為共用節點的子容器數量
+ */
+int GenericDedup_SharedCount(GenericDedup *dedup);
+
+/**
+ * 登記的不重複節點數量
+ */
+int GenericDedup_UniqueCount(GenericDedup *dedup);
+
+#endif
@@ -7,16 +7,70 @@ typedef struct GenericList GenericList;
 
 struct GenericType;
 
+struct GenericArena;
+
+struct CowUtil_State;
+
 GenericList* New_GenericList();
 
+/**
+ * 在 arena 中建構動態陣列，元素與其值都從 arena 配置
+ */
+GenericList* New_GenericList_InArena(struct GenericArena *arena);
+
+/**
+ * 取得動態陣列所在的 arena，不在 arena 中時回傳 NULL
+ */
+struct GenericArena* GenericList_GetArena(GenericList *list);
+
+/**
+ * 解構動態陣列，在 arena 中的動態陣列不會釋放任何記憶體，
+ * 以 GenericList_Retain 增加過參考時只減少參考計數
+ */
 void Delete_GenericList(GenericList **p_list);
 
+/**
+ * 增加參考計數，回傳 list 本身，每次 Retain 都需要對應一次 Delete_GenericList，
+ * 也用來把同一個動態陣列放入多個上層容器，不需複製
+ */
+GenericList* GenericList_Retain(GenericList *list);
+
+/**
+ * 取得動態陣列的快照版本狀態，供 GenericType 連結上層容器使用
+ */
+struct CowUtil_State* GenericList_GetCowState(GenericList *list);
+
+/**
+ * 取得元素，回傳的元素可以就地修改，
+ * 元素仍與快照共用時會先換成複製的元素，在快照中(GenericTableSnapshot_Begin 之後)讀取快照當下的元素
+ */
 struct GenericType* GenericList_At(GenericList *list, int index);
 
+/**
+ * 取得元素，只供讀取，不會複製仍與快照共用的元素，也不會清除記下的雜湊值，
+ * 在快照中讀取快照當下的元素，需要修改元素時改用 GenericList_At
+ */
+struct GenericType* GenericList_Get(GenericList *list, int index);
+
 int GenericList_Size(GenericList *list);
 
 bool GenericList_IsEmpty(GenericList *list);
 
+/**
+ * 動態陣列本身、元素陣列與元素(不含字串與巢狀容器)佔用的估計位元組數
+ */
+size_t GenericList_BytesUsed(GenericList *list);
+
+/**
+ * 動態陣列內容的結構雜湊值，與元素順序有關，同 GenericType_Hash
+ */
+uint64_t GenericList_Hash(GenericList *list);
+
+/**
+ * 兩個動態陣列是否長度相同且每個位置的元素相等(GenericType_Equals)
+ */
+bool GenericList_Equals(GenericList *list1, GenericList *list2);
+
 #define GenericList_Add(list, val) _Generic((val),\
     char*: GenericList_Add_Str,\
     const char*: GenericList_Add_Str,\
@@ -38,8 +92,15 @@ void GenericList_Add_Float(GenericList *list, float val);
 
 void GenericList_Add_Double(GenericList *list, double val);
 
+/**
+ * 放入映射表，動態陣列取得 val 的一個參考，共用的子樹先以 GenericTable_Retain 增加參考，
+ * 規則同 GenericTable_Add_Table
+ */
 void GenericList_Add_Table(GenericList *list, GenericTable *val);
 
+/**
+ * 放入動態陣列，規則同 GenericList_Add_Table，共用時以 GenericList_Retain 增加參考
+ */
 void GenericList_Add_List(GenericList *list, GenericList *val);
 
 /**
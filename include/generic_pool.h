@@ -0,0 +1,61 @@
+#ifndef GENERIC_POOL_H
+#define GENERIC_POOL_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/**
+ * 固定大小物件的池(slab)配置器：
+ * 從 64KB 的 slab 依序切出相同大小的物件，物件之間沒有 malloc 的標頭，
+ * 釋放的物件放回目前執行緒的 free list，配置、釋放大多只讀寫執行緒自己的 free list，不需加鎖，
+ * 執行緒的 free list 用完或過長時才加鎖，與池共用的 free list 整批交換，
+ * 執行緒結束時把 free list 交還給池
+ *
+ * slab 不會歸還給系統，池佔用的記憶體為同時存在的物件數量的最高值，
+ * GenericType、GenericTableItem、GenericList 各使用一個池
+ *
+ * 編譯時定義 GENERIC_POOL_DISABLE 時直接使用 malloc、free，
+ * 方便以 AddressSanitizer、valgrind 檢查個別物件的越界存取與洩漏
+ */
+typedef struct GenericPool
+{
+    size_t object_size;
+    /**
+     * 第一次使用時取得的編號，對應每個執行緒各自的 free list，0 代表尚未取得，-1 代表池的數量已達上限，改用 malloc
+     */
+    _Atomic int id;
+    pthread_mutex_t lock;
+    /**
+     * 各執行緒交還、尚未取走的物件
+     */
+    void *free_list;
+    int free_count;
+    /**
+     * 配置過的 slab，以 slab 開頭的指標串接
+     */
+    void *slabs;
+    size_t bytes_reserved;
+} GenericPool;
+
+/**
+ * 靜態初始化池 ex: static GenericPool pool = GENERIC_POOL_INIT(sizeof(Item));
+ */
+#define GENERIC_POOL_INIT(size) { (size), 0, PTHREAD_MUTEX_INITIALIZER, NULL, 0, NULL, 0 }
+
+/**
+ * 配置一個物件，內容未初始化
+ */
+void* GenericPool_Alloc(GenericPool *pool);
+
+/**
+ * 釋放 GenericPool_Alloc 配置的物件，可以在配置以外的執行緒釋放
+ */
+void GenericPool_Free(GenericPool *pool, void *ptr);
+
+/**
+ * 取得池向系統配置的 slab 位元組數，定義 GENERIC_POOL_DISABLE 時為 0
+ */
+size_t GenericPool_BytesReserved(GenericPool *pool);
+
+#endif
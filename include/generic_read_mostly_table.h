@@ -0,0 +1,128 @@
+#ifndef GENERIC_READ_MOSTLY_TABLE_H
+#define GENERIC_READ_MOSTLY_TABLE_H
+
+#include "generic_table.h"
+
+struct GenericList;
+struct GenericType;
+
+/**
+ * 讀多寫少的映射表，適合設定、路由等極少修改的資料：
+ *
+ * 查找完全不取鎖、不會等待，即使寫入端正在擴充容器也一樣，
+ * 寫入端之間以互斥鎖排隊，每次寫入都建立新的映射物件，以原子操作替換後再發布，
+ * 被替換、刪除的映射物件與舊容器透過 epoch_util 延後到沒有讀取端使用時才釋放
+ */
+typedef struct GenericReadMostlyTable GenericReadMostlyTable;
+
+/**
+ * 建構映射表，雜湊函式為 HashUtil_WyHash，種子為 HashUtil_ProcessSeed()
+ */
+GenericReadMostlyTable* New_GenericReadMostlyTable(void);
+
+/**
+ * 建構映射表，只使用 options 中的 bucket_size、load_factor、hash_fn、seed，
+ * options 為 NULL 時等同 New_GenericReadMostlyTable
+ */
+GenericReadMostlyTable* New_GenericReadMostlyTable_WithOptions(const GenericTableOptions *options);
+
+/**
+ * 解構映射表，呼叫時不可有其他執行緒仍在使用，
+ * 這個映射表延後釋放的記憶體一併釋放，不會等待其他映射表的讀取端，可在其他映射表的讀取區段中呼叫
+ * **p_table: 映射表自身的位址指標 ex: &table
+ */
+void Delete_GenericReadMostlyTable(GenericReadMostlyTable **p_table);
+
+/**
+ * 映射表新增物件的泛型方法，
+ * 當 key 已存在時，會以新的映射物件取代原本的映射物件，
+ * 映射表、動態陣列的所有權會交給本映射表，加入後不可再修改
+ */
+#define GenericReadMostlyTable_Add(table, key, value) _Generic((value),\
+    const char*: GenericReadMostlyTable_Add_Str,\
+    char*: GenericReadMostlyTable_Add_Str,\
+    int: GenericReadMostlyTable_Add_Int,\
+    long: GenericReadMostlyTable_Add_Long,\
+    double: GenericReadMostlyTable_Add_Double,\
+    float: GenericReadMostlyTable_Add_Float,\
+    GenericTable*: GenericReadMostlyTable_Add_Table,\
+    struct GenericList*: GenericReadMostlyTable_Add_List\
+)(table, key, value)
+
+void GenericReadMostlyTable_Add_Str(GenericReadMostlyTable *table, const char *key, const char *value);
+
+void GenericReadMostlyTable_Add_Int(GenericReadMostlyTable *table, const char *key, int value);
+
+void GenericReadMostlyTable_Add_Long(GenericReadMostlyTable *table, const char *key, long value);
+
+void GenericReadMostlyTable_Add_Double(GenericReadMostlyTable *table, const char *key, double value);
+
+void GenericReadMostlyTable_Add_Float(GenericReadMostlyTable *table, const char *key, float value);
+
+void GenericReadMostlyTable_Add_Table(GenericReadMostlyTable *table, const char *key, GenericTable *value);
+
+void GenericReadMostlyTable_Add_List(GenericReadMostlyTable *table, const char *key, struct GenericList *value);
+
+/**
+ * 移除映射表中 key 對應到的物件
+ */
+void GenericReadMostlyTable_Delete(GenericReadMostlyTable *table, const char *key);
+
+/**
+ * 進入讀取區段，之後以 GenericReadMostlyTable_Find 取得的物件，
+ * 在呼叫 GenericReadMostlyTable_ReadEnd 之前都不會被釋放，可以巢狀呼叫
+ */
+void GenericReadMostlyTable_ReadBegin(GenericReadMostlyTable *table);
+
+/**
+ * 離開讀取區段
+ */
+void GenericReadMostlyTable_ReadEnd(GenericReadMostlyTable *table);
+
+/**
+ * 查找 key 對應的物件，必須在讀取區段中呼叫，物件為唯讀，
+ * 如 key 不存在，將回傳 NULL
+ */
+struct GenericType* GenericReadMostlyTable_Find(GenericReadMostlyTable *table, const char *key);
+
+/**
+ * 查找字串，回傳的是複製品，使用完後需自行 free，
+ * 如 key 不存在，或查找出的值並非字串，將回傳 NULL
+ */
+char* GenericReadMostlyTable_Find_Str(GenericReadMostlyTable *table, const char *key);
+
+/**
+ * 查找整數並寫入 out，
+ * 如 key 不存在，或查找出的值並非整數，將回傳 false 且不修改 out
+ */
+bool GenericReadMostlyTable_Find_Int(GenericReadMostlyTable *table, const char *key, int *out);
+
+/**
+ * 查找長整數並寫入 out，
+ * 如 key 不存在，或查找出的值並非長整數，將回傳 false 且不修改 out
+ */
+bool GenericReadMostlyTable_Find_Long(GenericReadMostlyTable *table, const char *key, long *out);
+
+/**
+ * 查找雙經度浮點數並寫入 out，
+ * 如 key 不存在，或查找出的值並非雙經度浮點數，將回傳 false 且不修改 out
+ */
+bool GenericReadMostlyTable_Find_Double(GenericReadMostlyTable *table, const char *key, double *out);
+
+/**
+ * 查找單經度浮點數並寫入 out，
+ * 如 key 不存在，或查找出的值並非單經度浮點數，將回傳 false 且不修改 out
+ */
+bool GenericReadMostlyTable_Find_Float(GenericReadMostlyTable *table, const char *key, float *out);
+
+/**
+ * 在映射表中查找 key 是否存在
+ */
+bool GenericReadMostlyTable_HasKey(GenericReadMostlyTable *table, const char *key);
+
+/**
+ * 取得映射表當前物件數量
+ */
+int GenericReadMostlyTable_Size(GenericReadMostlyTable *table);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef GENERIC_STRING_H
+#define GENERIC_STRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * 不可變、以參考計數共用的字串，建構時記下長度與雜湊值，之後不需再以 strlen 或雜湊函式計算
+ *
+ * 所有字串都經過全域的字串池(intern)，內容相同的字串在同一時間只會有一份，
+ * 因此兩個 GenericString 相等若且唯若指標相同，
+ * 最後一個參考釋放時才從字串池移除並釋放記憶體
+ *
+ * 字串池依雜湊值分成多個分片，每個分片各自加鎖，多個執行緒可以同時建構、釋放字串，
+ * 只有參考計數可能歸零時才需要加鎖，其餘的遞增、遞減都是原子操作
+ *
+ * GenericType 的字串值(不在 arena 中時)使用 GenericString，
+ * 相同的字串值在映射表、動態陣列之間只存一份，複製物件也只遞增參考計數
+ */
+typedef struct GenericString GenericString;
+
+/**
+ * 取得與 str 內容相同的字串，已存在時遞增參考計數後回傳，不存在時複製一份放入字串池，
+ * len 為 str 的長度，str 不需以 '\0' 結尾，回傳的字串需以 Delete_GenericString 釋放
+ */
+GenericString* GenericString_Intern(const char *str, size_t len);
+
+/**
+ * 同 GenericString_Intern，hash 為呼叫端已算好的 GenericString_HashOf(str, len)，不再重新計算
+ */
+GenericString* GenericString_InternHashed(const char *str, size_t len, uint64_t hash);
+
+/**
+ * 遞增參考計數，回傳 str 本身
+ */
+GenericString* GenericString_Retain(GenericString *str);
+
+/**
+ * 遞減參考計數，歸零時從字串池移除並釋放
+ * **p_str: 字串自身的位址指標 ex: &str
+ */
+void Delete_GenericString(GenericString **p_str);
+
+/**
+ * 以 '\0' 結尾的字串內容，與 GenericString 共用，不可修改
+ */
+const char* GenericString_Chars(const GenericString *str);
+
+/**
+ * 由 GenericString_Chars 回傳的指標取回字串本身
+ */
+GenericString* GenericString_FromChars(const char *chars);
+
+int GenericString_Length(const GenericString *str);
+
+/**
+ * 建構時算好的雜湊值，等於 GenericString_HashOf(GenericString_Chars(str), GenericString_Length(str))
+ */
+uint64_t GenericString_Hash(const GenericString *str);
+
+/**
+ * 字串池使用的雜湊函式：HashUtil_WyHash 搭配 HashUtil_ProcessSeed()，
+ * 與預設建構的映射表相同，映射表可以直接使用字串的雜湊值
+ */
+uint64_t GenericString_HashOf(const char *str, size_t len);
+
+/**
+ * 字串池中的字串數量
+ */
+size_t GenericString_InternedCount(void);
+
+#endif
@@ -1,19 +1,22 @@
 #ifndef GENERIC_TABLE_H
 #define GENERIC_TABLE_H
 
+#include <stdint.h>
+#include <stddef.h>
+
 #include "common_util.h"
 #include "generic_type_enum.h"
 
 struct GenericList;
+struct GenericType;
+struct GenericArena;
+struct CowUtil_State;
 
 /**
  * 映射表的私有屬性，裡面的屬性：
  * 
- * int bucket_size:
- * 雜湊映射表的容器大小
- *
  * int resize_threshold:
- * 重構臨界點，用以判定容器是否擴充、縮減
+ * 重構臨界點(百分比)，佔用的位置(含已棄用的位置)超過時擴充，實際物件低於四分之一時縮減
  *
  * int item_count:
  * 實際存在的映射物件(被標記為'已棄用'物件不算在內)，會隨著刪除方法而減少
@@ -21,8 +24,18 @@ struct GenericList;
  * int modified_count:
  * 成功新增、刪除的計數，不會隨著刪除方法而減少
  *
- * GenericTableItem **items:
- * 承裝映射物件的容器
+ * GenericTableHashFn hash_fn, uint64_t seed:
+ * 雜湊函式與種子
+ *
+ * GenericTableProbing probing:
+ * 探測方式，群組探測或 Robin Hood 探測
+ *
+ * _GenericTableBucket buckets:
+ * 承裝映射物件的容器(大小、控制位元組、映射物件)
+ *
+ * _GenericTableBucket old_buckets, int rehash_index:
+ * 漸進式重構時尚未搬移完畢的舊容器，以及下一個要搬移的位置，
+ * 每次新增、刪除、查找都會搬移一小段，查找時新舊容器都會檢查
  */
 typedef struct GenericTable_Private GenericTable_Private;
 
@@ -34,7 +47,91 @@ typedef struct GenericTable
 } GenericTable;
 
 /**
- * 建構映射表，大小、負載係數都是預設的
+ * 映射表計算 key 雜湊值的函式，
+ * key_len 為 key 的字串長度，seed 為建構映射表時指定的種子，
+ * 可直接使用 hash_util.h 中的 HashUtil_WyHash、HashUtil_Fnv1aHash 等函式
+ */
+typedef uint64_t (*GenericTableHashFn)(const char *key, size_t key_len, uint64_t seed);
+
+/**
+ * 映射表的探測方式
+ *
+ * GENERIC_TABLE_PROBE_GROUP:
+ * 預設，以 16 個位置為一組，透過控制位元組一次比對整組，刪除時留下已刪除標記
+ *
+ * GENERIC_TABLE_PROBE_ROBIN_HOOD:
+ * 逐一位置線性探測，離起始位置較遠的物件優先佔位，探測長度的變異小，
+ * 刪除時把後方物件往前移，不留下已刪除標記，適合大小固定但頻繁新增、刪除的情境
+ */
+typedef enum GenericTableProbing
+{
+    GENERIC_TABLE_PROBE_GROUP,
+    GENERIC_TABLE_PROBE_ROBIN_HOOD
+} GenericTableProbing;
+
+/**
+ * 映射表容器大小的取法
+ *
+ * GENERIC_TABLE_SIZE_PRIME:
+ * 預設，大小取自預先計算的質數階梯，以 fastmod 乘法計算起始位置，雜湊函式分布不佳時也較能分散
+ *
+ * GENERIC_TABLE_SIZE_POW2:
+ * 大小為 2 的次方，以乘法雜湊取高位元計算起始位置，最快，但每次擴充都是兩倍
+ */
+typedef enum GenericTableSizing
+{
+    GENERIC_TABLE_SIZE_PRIME,
+    GENERIC_TABLE_SIZE_POW2
+} GenericTableSizing;
+
+/**
+ * 建構映射表的選項，先以 GenericTable_DefaultOptions 取得預設值再修改需要的欄位
+ *
+ * int bucket_size: 初始容器大小
+ * int load_factor: 負載係數(百分比)，佔用的位置超過時擴充容器，須介於 1 到 99，超出範圍時使用預設值
+ * GenericTableHashFn hash_fn: 雜湊函式，NULL 時使用 HashUtil_WyHash
+ * uint64_t seed: 傳給雜湊函式的種子
+ * GenericTableProbing probing: 探測方式
+ * bool rehash_on_lookup: 查找時是否順便搬移漸進式重構的舊容器，預設開啟，
+ *     關閉後查找不會修改映射表，多個執行緒可以在讀取鎖內同時查找
+ * GenericTableSizing sizing: 容器大小的取法
+ * bool ordered: 是否保持插入順序，預設關閉，
+ *     開啟後映射物件依插入順序緊密排列，容器每個位置只存放 4 個位元組的位置編號，
+ *     迭代器與 JsonSerializer 會依插入順序輸出，更新既有的 key 不會改變順序，
+ *     重構時一次完成，不會分批搬移
+ * bool auto_shrink: 刪除後物件過少時是否自動縮減容器，預設開啟，
+ *     新增、刪除交替頻繁時可關閉，避免反覆擴充、縮減，需要時再呼叫 GenericTable_ShrinkToFit
+ * struct GenericArena *arena: 配置映射表與其內容的 arena，預設為 NULL(使用 malloc)
+ * int build_threads: GenericTable_FromArrays 使用的執行緒數量，預設為 1，
+ *     key 太少或在 arena 中時不會平行，保持插入順序時只平行計算雜湊值與建構值，放入仍依序進行
+ * bool intern_keys: 放不進映射物件的長 key 是否從全域的字串池(GenericString)取得，預設關閉，
+ *     開啟後相同的長 key 在所有開啟此選項的映射表之間只存一份，適合大量重複 key 的資料，
+ *     短 key 原本就存放在映射物件中，不受影響，在 arena 中時忽略
+ */
+typedef struct GenericTableOptions
+{
+    int bucket_size;
+    int load_factor;
+    GenericTableHashFn hash_fn;
+    uint64_t seed;
+    GenericTableProbing probing;
+    bool rehash_on_lookup;
+    GenericTableSizing sizing;
+    bool ordered;
+    bool auto_shrink;
+    struct GenericArena *arena;
+    int build_threads;
+    bool intern_keys;
+} GenericTableOptions;
+
+/**
+ * 取得預設的建構選項
+ */
+GenericTableOptions GenericTable_DefaultOptions(void);
+
+/**
+ * 建構映射表，大小、負載係數都是預設的，
+ * 雜湊函式為 HashUtil_WyHash，種子為每個行程隨機產生的 HashUtil_ProcessSeed()
  */
 GenericTable* New_GenericTable(void);
 
@@ -49,14 +146,67 @@ GenericTable* New_GenericTable_WithBucketSize(int size);
 GenericTable* New_GenericTable_WithBucketSizeAndLoadFactor(int size, int load_factor);
 
 /**
- * 解構映射表
+ * 建構指定預設大小、負載係數、雜湊函式與種子的映射表，
+ * hash_fn 為 NULL 時使用 HashUtil_WyHash
+ */
+GenericTable* New_GenericTable_WithHasher(int size, int load_factor, GenericTableHashFn hash_fn, uint64_t seed);
+
+/**
+ * 依照建構選項建構映射表，options 為 NULL 時等同 New_GenericTable
+ */
+GenericTable* New_GenericTable_WithOptions(const GenericTableOptions *options);
+
+/**
+ * 在 arena 中建構映射表，映射物件、key、值都從 arena 配置，
+ * 解構時不需逐一釋放，由 Delete_GenericArena 或 GenericArena_Reset 一次釋放
+ */
+GenericTable* New_GenericTable_InArena(struct GenericArena *arena);
+
+/**
+ * 取得映射表所在的 arena，不在 arena 中時回傳 NULL
+ */
+struct GenericArena* GenericTable_GetArena(GenericTable *table);
+
+/**
+ * 由 n 組 key、值一次建構映射表，比逐一呼叫 GenericTable_Add_* 快：
+ * 容器大小一次決定不需重構，先整批計算雜湊值，映射物件與較長的 key 各自配置在一塊連續記憶體，
+ * options->build_threads 大於 1 時依起始位置把容器切成區段，由多個執行緒同時放入
+ *
+ * keys: n 個 key，不可為 NULL
+ * values: n 個值，與 New_GenericType_InArena 相同，為字串、映射表、動態陣列本身，或指向數值的指標，
+ *     型別為 GEN_TYPE_NULL 時可為 NULL，映射表、動態陣列交由建構的映射表解構
+ * types: n 個值的型別
+ * options: 建構選項，NULL 時使用預設值，bucket_size 不足以放入 n 個 key 時自動加大
+ *
+ * 重複的 key 以最後一組為準，保持插入順序時順序為第一次出現的位置，
+ * 連續記憶體中的映射物件刪除後不會立即釋放，映射表解構時才一起釋放
+ */
+GenericTable* GenericTable_FromArrays(
+    const char **keys, const void **values, const GenericTypeEnum *types, int n, const GenericTableOptions *options
+);
+
+/**
+ * 解構映射表，在 arena 中的映射表不會釋放任何記憶體，
+ * 以 GenericTable_Retain 增加過參考(含快照)時只減少參考計數
  * **table: 映射表自身的位址指標 ex: &table
  */
 void Delete_GenericTable(GenericTable **table);
 
+/**
+ * 增加參考計數，回傳 table 本身，每次 Retain 都需要對應一次 Delete_GenericTable，
+ * 也用來把同一個子樹放入多個上層容器：GenericTable_Add(parent, "config", GenericTable_Retain(shared))
+ */
+GenericTable* GenericTable_Retain(GenericTable *table);
+
+/**
+ * 取得映射表的快照版本狀態，供 GenericType 連結上層容器使用
+ */
+struct CowUtil_State* GenericTable_GetCowState(GenericTable *table);
+
 /**
  * 映射表新增物件的泛型方法，
- * 當 key 已存在時，會更新原本映射的物件
+ * 當 key 已存在時，會以 GenericType_Set_* 就地更新原本映射的物件，
+ * 型別相同的數值不會配置任何記憶體，之前取得的值指標仍然有效
  */
 #define GenericTable_Add(table, key, value) _Generic((value),\
     const char*: GenericTable_Add_Str,\
@@ -79,19 +229,41 @@ void GenericTable_Add_Double(GenericTable *table, const char *key, double value)
 
 void GenericTable_Add_Float(GenericTable *table, const char *key, float value);
 
+/**
+ * 放入映射表，映射表取得 value 的一個參考，值被取代或映射表解構時釋放此參考，
+ * 同一個子樹放入多個上層容器時不會複製，每多放一次先以 GenericTable_Retain 增加一個參考，
+ * 最後一個上層容器釋放時才解構子樹，
+ * 修改共用的子樹時所有上層容器都會看到，任一上層容器的快照都包含子樹當下的內容
+ */
 void GenericTable_Add_Table(GenericTable *table, const char *key, GenericTable *value);
 
+/**
+ * 放入動態陣列，規則同 GenericTable_Add_Table，共用時以 GenericList_Retain 增加參考
+ */
 void GenericTable_Add_List(GenericTable *table, const char *key, struct GenericList *value);
 
+/**
+ * 取得 key 對應的值，key 不存在時先放入型別為 GEN_TYPE_NULL 的值，
+ * 回傳的值可直接以 GenericType_Set_* 寫入或修改，不需再呼叫 GenericTable_Add_*，
+ * 在 key 被刪除或映射表解構前都有效，
+ * p_inserted 可為 NULL，不為 NULL 時帶回 key 是否為新放入的
+ *
+ * GenericType *count = GenericTable_GetOrInsert(table, word, &inserted);
+ * if (inserted) GenericType_Set_Int(count, 1); else (*GenericType_GetInt(count))++;
+ */
+struct GenericType* GenericTable_GetOrInsert(GenericTable *table, const char *key, bool *p_inserted);
+
 /**
  * 在映射表中查找字串指標，
- * 如 key 不存在，或查找出的值並非字串，將回傳 NULL
+ * 如 key 不存在，或查找出的值並非字串，將回傳 NULL，
+ * 字串與其他相同的字串值共用(GenericString)，不可修改，需要改變時以 GenericTable_Add 寫入新的字串
  */
-char* GenericTable_Find_Str(GenericTable *table, const char *key);
+const char* GenericTable_Find_Str(GenericTable *table, const char *key);
 
 /**
  * 在映射表中查找整數指標，
- * 如 key 不存在，或查找出的值並非整數，將回傳 NULL
+ * 如 key 不存在，或查找出的值並非整數，將回傳 NULL，
+ * 數值的 GenericTable_Find_* 回傳的指標可以就地修改，值仍與快照共用時會先換成複製的值
  */
 int* GenericTable_Find_Int(GenericTable *table, const char *key);
 
@@ -125,7 +297,8 @@ GenericTable* GenericTable_Find_Table(GenericTable *table, const char *key);
 GenericTypeEnum GenericTable_ValueType(GenericTable *table, const char *key);
 
 /**
- * 移除映射表中 key 對應到的物件，並將對應的位置標記為已棄用
+ * 移除映射表中 key 對應到的物件，
+ * 預設的探測方式會將對應的位置標記為已棄用，Robin Hood 探測方式則會把後方物件往前移
  */
 void GenericTable_Delete(GenericTable *table, const char *key);
 
@@ -134,6 +307,117 @@ void GenericTable_Delete(GenericTable *table, const char *key);
  */
 bool GenericTable_HasKey(GenericTable *table, const char *key);
 
+/**
+ * 預留足夠放入 count 個物件的容器，之後放入 count 個物件都不會重構，
+ * 自動縮減也不會小於預留的大小，直到呼叫 GenericTable_ShrinkToFit
+ */
+void GenericTable_Reserve(GenericTable *table, int count);
+
+/**
+ * 取消預留的大小，立即把容器縮減到剛好放得下目前的物件，並清除已刪除的位置
+ */
+void GenericTable_ShrinkToFit(GenericTable *table);
+
+/**
+ * 取得目前容器的位置數量
+ */
+int GenericTable_Capacity(GenericTable *table);
+
+/**
+ * 批次查找 n 個 key，結果依序寫入 out_values，key 不存在時為 NULL，
+ * 會先計算所有 key 的雜湊值並預取記憶體，再一起比對，
+ * 一次需要查找大量 key 時比逐一呼叫 GenericTable_Find_* 快，
+ * 取得的值(與迭代器、cursor 取得的值相同)可能與快照共用，只供讀取
+ */
+void GenericTable_FindMany(GenericTable *table, const char **keys, int n, struct GenericType **out_values);
+
+/**
+ * 批次查找 n 個 key 是否存在，結果依序寫入 out_results
+ */
+void GenericTable_HasKeyMany(GenericTable *table, const char **keys, int n, bool *out_results);
+
+/**
+ * 查找 key 時需要探測的群組數量(每個群組 16 個位置)，
+ * Robin Hood 探測方式則為位置數量，
+ * 不論 key 是否存在，最少為 1，可用來評估雜湊函式的分布
+ */
+int GenericTable_ProbeLength(GenericTable *table, const char *key);
+
+/**
+ * 探測長度直方圖的格數，第 i 格為探測長度 i + 1 的數量，最後一格包含更長的探測
+ */
+#define GENERIC_TABLE_PROBE_HISTOGRAM_SIZE 16
+
+/**
+ * 映射表的統計資料，由 GenericTable_GetStats、GenericTable_GetDeepStats 填入，
+ * 探測長度的單位與 GenericTable_ProbeLength 相同(群組探測為群組數，Robin Hood 探測為位置數)
+ *
+ * int capacity, old_capacity: 目前容器與重構中舊容器的位置數量，沒有進行中的重構時 old_capacity 為 0
+ * int item_count: 實際存在的映射物件數量
+ * int tombstones: 目前容器中標記為已刪除的位置數量，Robin Hood 探測恆為 0
+ * int modified_count: 上次重構後成功新增、刪除的次數
+ * double load_factor: 目前容器佔用的位置(含已刪除的位置)比例
+ * int grow_count, shrink_count, rehash_count: 擴充、縮減、以相同大小重構(清除已刪除的位置)的次數
+ * long resize_nanos: 重構與搬移舊容器累計花費的時間(奈秒)
+ * size_t bytes_used: 映射表本身、容器、映射物件(連同值本身，不含字串與巢狀容器)與 key 佔用的估計位元組數，
+ *                   GenericTable_GetStats 只計入存放在映射物件中的短 key，GenericTable_GetDeepStats 另外計入較長的 key
+ *
+ * 以下只由 GenericTable_GetDeepStats 填入，GenericTable_GetStats 皆為 0：
+ * int hit_histogram[]: 查找每個已存在的 key 需要的探測長度分布
+ * int miss_histogram[]: 從每個起始位置查找不存在的 key 需要的探測長度分布
+ * double average_hit_probe, average_miss_probe: 平均探測長度
+ * int max_probe: 已存在的 key 中最長的探測長度
+ *
+ * 以下計數只在編譯時定義 GENERIC_TABLE_ENABLE_STATS 才會累計，否則 counters_enabled 為 false 且皆為 0，
+ * 以原子操作累加，多個執行緒在讀取鎖內同時查找時也不會遺失：
+ * long find_count, find_hit_count: 查找次數與找到的次數(含批次查找)
+ * long probe_count: 查找、新增時探測的群組數(Robin Hood 探測為位置數)
+ * long insert_count, update_count: 新增 key 與更新既有 key 的次數
+ */
+typedef struct GenericTableStats
+{
+    int capacity;
+    int old_capacity;
+    int item_count;
+    int tombstones;
+    int modified_count;
+    double load_factor;
+    int grow_count;
+    int shrink_count;
+    int rehash_count;
+    long resize_nanos;
+    size_t bytes_used;
+    int hit_histogram[GENERIC_TABLE_PROBE_HISTOGRAM_SIZE];
+    int miss_histogram[GENERIC_TABLE_PROBE_HISTOGRAM_SIZE];
+    double average_hit_probe;
+    double average_miss_probe;
+    int max_probe;
+    bool counters_enabled;
+    long find_count;
+    long find_hit_count;
+    long probe_count;
+    long insert_count;
+    long update_count;
+} GenericTableStats;
+
+/**
+ * 取得映射表的統計資料，不含探測長度的分布，
+ * O(1)，不會修改映射表，也不會配置記憶體，可以頻繁收集
+ */
+void GenericTable_GetStats(GenericTable *table, GenericTableStats *stats);
+
+/**
+ * 同 GenericTable_GetStats，並走訪整個容器一次填入探測長度的分布，與容器大小成正比，
+ * 不會修改映射表(也不會累計查找計數)，呼叫時不可同時寫入，適合調整負載係數時偶爾收集
+ */
+void GenericTable_GetDeepStats(GenericTable *table, GenericTableStats *stats);
+
+/**
+ * 映射表本身、容器、映射物件(連同值本身，不含字串與巢狀容器)與 key 佔用的估計位元組數，
+ * 同 GenericTableStats 的 bytes_used，不需走訪容器
+ */
+size_t GenericTable_BytesUsed(GenericTable *table);
+
 /**
  * 取得映射表當前物件數量
  */
@@ -145,6 +429,16 @@ int GenericTable_Size(GenericTable *table);
  */
 bool GenericTable_IsEmpty(GenericTable *table);
 
+/**
+ * 映射表內容的結構雜湊值，與插入順序、容器大小、雜湊函式無關，同 GenericType_Hash
+ */
+uint64_t GenericTable_Hash(GenericTable *table);
+
+/**
+ * 兩個映射表是否有相同的 key 且對應的值相等(GenericType_Equals)，與插入順序無關
+ */
+bool GenericTable_Equals(GenericTable *table1, GenericTable *table2);
+
 struct GenericType;
 
 char* GenericTableItem_GetKey(GenericTableItem *item);
@@ -152,7 +446,9 @@ char* GenericTableItem_GetKey(GenericTableItem *item);
 struct GenericType* GenericTableItem_GetValue(GenericTableItem *item);
 
 /**
- * GenericTable 專用的迭代器，使用完後必須呼叫 Delete_GenericTableIterator 解構
+ * GenericTable 專用的迭代器，使用完後必須呼叫 Delete_GenericTableIterator 解構，
+ * 保持插入順序的映射表依插入順序迭代，否則順序不固定，
+ * 建構時會配置並複製所有映射物件的指標，不需要快照時請改用 GenericTable_Begin
  */
 typedef struct GenericTableIterator GenericTableIterator;
 
@@ -164,4 +460,97 @@ GenericTableItem* GenericTableIterator_Next(GenericTableIterator *iterator);
 
 void Delete_GenericTableIterator(GenericTableIterator **p_iterator);
 
+/**
+ * 直接走訪容器的輕量迭代器，放在堆疊上即可，不需配置記憶體也不需解構，
+ * 欄位只供內部使用，不應直接修改
+ *
+ * GenericTable_Cursor cursor = GenericTable_Begin(table);
+ * const char *key;
+ * GenericType *value;
+ * while (GenericTable_Next(&cursor, &key, &value)) { ... }
+ */
+typedef struct GenericTable_Cursor
+{
+    GenericTable *table;
+    /**
+     * 下一個要檢查的位置
+     */
+    int index;
+    /**
+     * 正在走訪的容器：目前的容器、重構中的舊容器或已結束
+     */
+    int phase;
+    /**
+     * 開始迭代時映射表的容器配置版本
+     */
+    unsigned int layout_version;
+    bool invalidated;
+} GenericTable_Cursor;
+
+/**
+ * 取得指向第一個映射物件的 cursor，保持插入順序的映射表依插入順序迭代，否則順序不固定，
+ * 查找時會搬移舊容器的映射表(rehash_on_lookup)，會先一次搬完進行中的重構
+ *
+ * 迭代期間可以查找，也可以更新既有 key 的值(當次取得的 value 會被釋放)，
+ * 但新增、刪除 key 或重構之後，GenericTable_Next 一律回傳 false，
+ * 並可由 GenericTable_CursorInvalidated 得知迭代是被中斷而非走訪完畢
+ */
+GenericTable_Cursor GenericTable_Begin(GenericTable *table);
+
+/**
+ * 移動到下一個映射物件，把 key 與值寫入 p_key、p_value (可為 NULL)，
+ * 沒有下一個映射物件，或映射表在迭代期間被修改時回傳 false
+ */
+bool GenericTable_Next(GenericTable_Cursor *cursor, const char **p_key, struct GenericType **p_value);
+
+/**
+ * cursor 是否因為映射表在迭代期間被修改而中斷
+ */
+bool GenericTable_CursorInvalidated(const GenericTable_Cursor *cursor);
+
+typedef void (*GenericTable_ValueFn)(struct GenericType *value, void *arg);
+
+/**
+ * 以可修改的指標走訪每個值，順序不固定，值仍與快照共用時先換成複製的值，
+ * fn 可以就地修改、取代值(例如 GenericType_Set_Table)，但不可新增、刪除此映射表的 key，
+ * 快照中不可呼叫
+ */
+void GenericTable_ForEachValue(GenericTable *table, GenericTable_ValueFn fn, void *arg);
+
+/**
+ * 映射表樹(含巢狀的映射表、動態陣列)的唯讀快照，以 copy-on-write 與映射表共用結構：
+ * 建立快照不複製任何資料，之後每個映射表、動態陣列第一次寫入時才凍結並複製自己的容器陣列，
+ * 被更新、刪除的映射物件交給快照保管，快照解構後釋放
+ *
+ * 在 GenericTableSnapshot_Begin、GenericTableSnapshot_End 之間，目前執行緒讀取的是快照當下的內容，
+ * 可在其他執行緒讀取(例如 JsonSerializer 輸出)，不會阻塞寫入端，期間不可寫入任何映射表、動態陣列
+ *
+ * GenericTable *root = GenericTableSnapshot_Begin(snapshot);
+ * char *json = JsonSerializer_TableToStr(root);
+ * GenericTableSnapshot_End(snapshot);
+ */
+typedef struct GenericTableSnapshot GenericTableSnapshot;
+
+/**
+ * 建立快照，O(1)，呼叫時不可同時寫入這棵映射表樹，
+ * 快照持有映射表的參考，映射表在快照解構前不會被釋放，
+ * 快照之前取得的 GenericType 指標(FindMany、cursor)在快照之後不可用來寫入
+ */
+GenericTableSnapshot* GenericTable_Snapshot(GenericTable *table);
+
+/**
+ * 目前執行緒進入快照，回傳快照的映射表，不可巢狀呼叫
+ */
+GenericTable* GenericTableSnapshot_Begin(GenericTableSnapshot *snapshot);
+
+/**
+ * 目前執行緒離開快照，之後不可再使用快照中取得的指標
+ */
+void GenericTableSnapshot_End(GenericTableSnapshot *snapshot);
+
+/**
+ * 解構快照，釋放只有快照還在使用的版本與映射物件，不可有執行緒仍在讀取
+ */
+void Delete_GenericTableSnapshot(GenericTableSnapshot **p_snapshot);
+
 #endif
\ No newline at end of file
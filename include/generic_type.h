@@ -8,10 +8,33 @@
 
 typedef struct GenericType GenericType;
 
+/**
+ * 物件本身佔用的最大位元組數，容器把物件與自己的記憶體配置在一起時使用
+ */
+#define GENERIC_TYPE_SIZE 24
+
 void Delete_GenericType(GenericType **ptr_obj);
 
 struct GenericList;// prevent recursive import
 
+struct GenericArena;
+
+struct CowUtil_State;
+
+struct GenericString;
+
+/**
+ * 容器內所有物件共用的環境，由容器持有，物件只存一個指向它的指標
+ *
+ * struct GenericArena *arena: 配置物件與其值的 arena，NULL 代表以 malloc 配置
+ * struct CowUtil_State *owner: 容器的快照版本狀態
+ */
+typedef struct GenericTypeContext
+{
+    struct GenericArena *arena;
+    struct CowUtil_State *owner;
+} GenericTypeContext;
+
 #define New_GenericType(val) _Generic((val), \
     char*: New_Str_GenericType,\
     const char*: New_Str_GenericType,\
@@ -37,9 +60,34 @@ GenericType* New_Table_GenericType(GenericTable *value);
 
 GenericType* New_List_GenericType(struct GenericList *value);
 
-
-char* GenericType_GetStr(GenericType *gen_type);
-
+/**
+ * 建構尚未放入值的物件(GEN_TYPE_NULL)，之後以 GenericType_Set_* 寫入
+ */
+GenericType* New_Null_GenericType(void);
+
+/**
+ * 在 arena 中建構物件，value 為字串、映射表、動態陣列本身，或指向數值的指標，
+ * 數值與字串會複製到 arena 中，type 為 GEN_TYPE_NULL 時 value 為 NULL，
+ * 不在 arena 中的映射表、動態陣列會交由 arena 在解構時一併解構
+ */
+GenericType* New_GenericType_InArena(struct GenericArena *arena, GenericTypeEnum type, const void *value);
+
+
+/**
+ * 不在 arena 中的字串與其他相同的字串值共用(GenericString)，不可修改，
+ * 型別改變或物件解構後失效，型別不符時回傳 NULL
+ */
+const char* GenericType_GetStr(GenericType *gen_type);
+
+/**
+ * 取得字串值的 GenericString，不遞增參考計數，型別不符或物件在 arena 中時回傳 NULL
+ */
+struct GenericString* GenericType_GetString(GenericType *gen_type);
+
+/**
+ * 數值直接存放在物件中，回傳的指標指向物件內部，可就地讀寫，
+ * 型別改變或物件解構後失效，型別不符時回傳 NULL
+ */
 int* GenericType_GetInt(GenericType *gen_type);
 
 long* GenericType_GetLong(GenericType *gen_type);
@@ -56,6 +104,115 @@ GenericTypeEnum GenericType_GetType(GenericType *gen_type);
 
 bool GenericType_IsType(GenericType *gen_type, GenericTypeEnum type);
 
+/**
+ * 就地修改物件的值的泛型方法，
+ * 型別相同時直接覆寫原本的值，不會配置記憶體，
+ * 字串不在 arena 中時改為參考字串池中相同的字串，在 arena 中時只在新字串較長時重新配置，
+ * 型別不同時釋放原本的值(含映射表、動態陣列)再放入新的值，
+ * arena 中的物件會從同一個 arena 配置新的值
+ */
+#define GenericType_Set(gen_type, value) _Generic((value),\
+    const char*: GenericType_Set_Str,\
+    char*: GenericType_Set_Str,\
+    int: GenericType_Set_Int,\
+    long: GenericType_Set_Long,\
+    double: GenericType_Set_Double,\
+    float: GenericType_Set_Float,\
+    GenericTable*: GenericType_Set_Table,\
+    struct GenericList*: GenericType_Set_List,\
+    struct GenericString*: GenericType_Set_String\
+)(gen_type, value)
+
+/**
+ * 放入字串，不在 arena 中時從字串池取得相同的字串，在 arena 中時複製一份，
+ * value 可以是物件目前字串中的一部分
+ */
+void GenericType_Set_Str(GenericType *gen_type, const char *value);
+
+/**
+ * 放入 GenericString，物件取得 value 的一個參考，在 arena 中時複製內容後釋放 value
+ */
+void GenericType_Set_String(GenericType *gen_type, struct GenericString *value);
+
+void GenericType_Set_Int(GenericType *gen_type, int value);
+
+void GenericType_Set_Long(GenericType *gen_type, long value);
+
+void GenericType_Set_Double(GenericType *gen_type, double value);
+
+void GenericType_Set_Float(GenericType *gen_type, float value);
+
+/**
+ * 放入映射表，物件取得映射表的一個參考，與目前的映射表相同時不做任何事，
+ * 同一個映射表放入多個物件時，每多放一次先以 GenericTable_Retain 增加一個參考
+ */
+void GenericType_Set_Table(GenericType *gen_type, GenericTable *value);
+
+/**
+ * 放入動態陣列，物件取得動態陣列的一個參考，與目前的動態陣列相同時不做任何事，
+ * 同一個動態陣列放入多個物件時，每多放一次先以 GenericList_Retain 增加一個參考
+ */
+void GenericType_Set_List(GenericType *gen_type, struct GenericList *value);
+
+/**
+ * 映射表、動態陣列放入物件時呼叫，記下所在容器的環境與當時的 epoch，
+ * 物件中的映射表、動態陣列也會以此容器為上層容器(取代物件原本所在的容器)，context 的 arena 須與物件相同
+ */
+void GenericType_SetOwner(GenericType *gen_type, const GenericTypeContext *context, int epoch);
+
+int GenericType_GetEpoch(GenericType *gen_type);
+
+/**
+ * 物件本身的大小，等於 GENERIC_TYPE_SIZE
+ */
+size_t GenericType_Sizeof(void);
+
+/**
+ * 在容器提供的記憶體中建構 GEN_TYPE_NULL 的物件，記憶體至少 GENERIC_TYPE_SIZE 個位元組並對齊指標，
+ * 之後放入的值從 context 的 arena 配置，Delete_GenericType 只釋放值，記憶體本身由容器釋放
+ */
+GenericType* GenericType_InitAt(void *storage, const GenericTypeContext *context, int epoch);
+
+/**
+ * 把 src 的值移到 dest，dest 原本的值先釋放，src 轉為 GEN_TYPE_NULL，
+ * 兩者須在同一個 arena 中(或都不在 arena 中)
+ */
+void GenericType_Move(GenericType *dest, GenericType *src);
+
+/**
+ * 以 src 的值取代 dest 的值，數值複製一份，字串、映射表、動態陣列共用(遞增參考計數)，
+ * 字串在 arena 中時複製一份
+ */
+void GenericType_Assign(GenericType *dest, GenericType *src);
+
+/**
+ * 複製物件，規則同 GenericType_Assign，
+ * arena 中的物件從同一個 arena 配置，快照寫入前以此複製仍與版本共用的物件
+ */
+GenericType* GenericType_Clone(GenericType *gen_type);
+
+/**
+ * 深層比較兩個物件的值：型別不同即不相等，字串比較內容，數值以 == 比較，
+ * 映射表比較 key 與對應的值(與插入順序無關)，動態陣列依序比較每個元素，
+ * 容器先比較大小，兩者都已記下雜湊值(GenericType_Hash)且不同時直接回傳 false，
+ * 共用的子樹(同一個映射表、動態陣列)直接視為相等
+ */
 bool GenericType_Equals(GenericType *gen_type1, GenericType *gen_type2);
 
+/**
+ * 值的結構雜湊值，GenericType_Equals 相等的物件雜湊值一定相同，
+ * 只在同一個行程內有效(字串的雜湊使用 HashUtil_ProcessSeed)
+ *
+ * 映射表、動態陣列算過後把雜湊值記在容器上，之後沒有修改的子樹不再重算，
+ * 容器的新增、刪除與 GenericType_Set_* 等修改會使容器與所有上層容器記下的值失效，
+ * 每秒比對大型文件是否改變時，通常只需重算修改過的路徑
+ *
+ * 注意：
+ * 1. GenericTable_Find_*、GenericList_At 取得可修改的指標時即使雜湊值失效，
+ *    經由游標、迭代器取得的值直接寫入數值不會使雜湊值失效，須改用 GenericType_Set_*
+ * 2. 計算期間不可同時寫入這棵容器樹
+ * 3. 快照中(GenericTableSnapshot_Begin 之後)每次都重新計算，不記下雜湊值
+ */
+uint64_t GenericType_Hash(GenericType *gen_type);
+
 #endif 
\ No newline at end of file
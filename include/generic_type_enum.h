@@ -9,7 +9,11 @@ typedef enum GenericTypeEnum
     GEN_TYPE_FLOAT, 
     GEN_TYPE_DOUBLE, 
     GEN_TYPE_TABLE, 
-    GEN_TYPE_LIST
+    GEN_TYPE_LIST,
+    /**
+     * 尚未放入值，GenericTable_GetOrInsert 新放入的 key 在寫入前為此型別
+     */
+    GEN_TYPE_NULL
 } GenericTypeEnum;
 
 #endif
\ No newline at end of file
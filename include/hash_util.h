@@ -0,0 +1,34 @@
+#ifndef HASH_UTIL_H
+#define HASH_UTIL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * wyhash 演算法的字串雜湊，速度快且分布均勻，
+ * 不同的 seed 會得到完全不同的雜湊序列
+ */
+uint64_t HashUtil_WyHash(const char *key, size_t key_len, uint64_t seed);
+
+/**
+ * FNV-1a 字串雜湊，實作簡單，作為比較基準
+ */
+uint64_t HashUtil_Fnv1aHash(const char *key, size_t key_len, uint64_t seed);
+
+/**
+ * 舊版 GenericTable 使用的位移、互斥或雜湊，
+ * 前綴相同的 key 容易聚集，保留作為比較基準，不使用 seed
+ */
+uint64_t HashUtil_LegacyHash(const char *key, size_t key_len, uint64_t seed);
+
+/**
+ * 每個行程啟動後隨機產生一次的種子，同一個行程內固定不變
+ */
+uint64_t HashUtil_ProcessSeed(void);
+
+/**
+ * 把兩個 64 位元的雜湊值混合成一個，與參數順序有關，供組合結構的雜湊值使用
+ */
+uint64_t HashUtil_Mix(uint64_t a, uint64_t b);
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef NUMBER_UTIL_H
 #define NUMBER_UTIL_H
 
+#include <stdint.h>
+
 static int NUMBER_UTIL_INT_MAX = 0xFFFFFFFF / 2;
 static long NUMBER_UTIL_LONG_MAX = 0xFFFFFFFFFFFFFFFF / 2;
 
@@ -8,4 +10,29 @@ long NumberUtil_NextPowerOf_2(int input);
 
 long NumberUtil_NextPrime(int input);
 
+/**
+ * 質數與其 fastmod 常數(UINT64_MAX / prime + 1)，
+ * 以 NumberUtil_FastMod 取餘數時不需要除法指令
+ */
+typedef struct NumberUtil_FastModPrime
+{
+    int prime;
+    uint64_t magic;
+} NumberUtil_FastModPrime;
+
+/**
+ * 在預先計算的質數階梯中，取得大於等於 input 的最小質數，
+ * 超過階梯最大值(Integer 的最大正整數)時回傳最大值
+ */
+NumberUtil_FastModPrime NumberUtil_LadderPrime(int input);
+
+/**
+ * Lemire fastmod，以乘法計算 input % divisor，magic 為 UINT64_MAX / divisor + 1
+ */
+static inline uint32_t NumberUtil_FastMod(uint32_t input, uint64_t magic, uint32_t divisor)
+{
+    uint64_t low_bits = magic * input;
+    return (uint32_t) (((__uint128_t) low_bits * divisor) >> 64);
+}
+
 #endif
\ No newline at end of file
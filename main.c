@@ -9,10 +9,11 @@
 #include "include/generic_list.h"
 #include "include/generic_table.h"
 #include "include/generic_type.h"
+#include "include/generic_string.h"
 #include "include/string_builder.h"
 #include "include/common_util.h"
 
-GenericTypeEnum _TypeOf(char *val)
+GenericTypeEnum _TypeOf(const char *val)
 {
     GenericTypeEnum result;
     bool is_num = true;
@@ -78,17 +79,22 @@ void _PrintTable(GenericTable *table)
 }
 
 #define BUF_SIZE 1000
-char* _ReadInput(char *in_buf)
+/**
+ * 讀取一行輸入，指令與 key 大多重複，從字串池取得而不另外複製
+ */
+GenericString* _ReadInput(char *in_buf)
 {
     fgets(in_buf, BUF_SIZE, stdin);
-    in_buf[strcspn(in_buf, "\n")] = '\0';
-    return strdup(in_buf);
+    size_t len = strcspn(in_buf, "\n");
+    in_buf[len] = '\0';
+    return GenericString_Intern(in_buf, len);
 }
 
-void _PutItem(GenericTable *table, char *key, char *in_buf)
+void _PutItem(GenericTable *table, const char *key, char *in_buf)
 {
     s_out("value:");
-    char *val = _ReadInput(in_buf);
+    GenericString *input = _ReadInput(in_buf);
+    const char *val = GenericString_Chars(input);
 
     switch (_TypeOf(val)) 
     {
@@ -108,35 +114,34 @@ void _PutItem(GenericTable *table, char *key, char *in_buf)
         case GEN_TYPE_LIST:
             break;
         default:
-            free(val);
-            break;;
+            break;
     }
 
-    free(val);
+    Delete_GenericString(&input);
 }
 
-void _FindItem(GenericTable *table, char *key)
+void _FindItem(GenericTable *table, const char *key)
 {
-    void *item;
+    const void *item;
     s_out_f("type: %d", GenericTable_ValueType(table, key));
     switch (GenericTable_ValueType(table, key))
     {
         case GEN_TYPE_STR:
         {
             item = GenericTable_Find_Str(table, key);
-            s_out_f("%s", ((char*) item));
+            s_out_f("%s", ((const char*) item));
             break;
         }
         case GEN_TYPE_INT:
         {
             item = GenericTable_Find_Int(table, key);
-            s_out_f("%d", *((int*) item));
+            s_out_f("%d", *((const int*) item));
             break;
         }
         case GEN_TYPE_DOUBLE:
         {
             item = GenericTable_Find_Double(table, key);
-            s_out_f("%f", *((double*) item));
+            s_out_f("%f", *((const double*) item));
             break;
         }
         default:
@@ -174,7 +179,7 @@ void _Init_action_map()
     GenericTable_Add(_cmd_table, CMD_HELP, ACT_HELP);
 }
 
-char* _ReadKey(char *in_buf)
+GenericString* _ReadKey(char *in_buf)
 {
     s_out("key name:");
     return _ReadInput(in_buf);
@@ -182,10 +187,11 @@ char* _ReadKey(char *in_buf)
 
 void _IncreaseValue(GenericTable *table, char *in_buf)
 {
-    char *key, *val;
-    key = _ReadKey(in_buf);
+    GenericString *key_str = _ReadKey(in_buf);
     s_out("value:");
-    val = _ReadInput(in_buf);
+    GenericString *val_str = _ReadInput(in_buf);
+    const char *key = GenericString_Chars(key_str);
+    const char *val = GenericString_Chars(val_str);
     switch (_TypeOf(val))
     {
         case GEN_TYPE_INT:
@@ -196,9 +202,9 @@ void _IncreaseValue(GenericTable *table, char *in_buf)
                 s_out_f("the type of \"%s\" is not integer", key);
                 break;
             }
+            // 查找回傳的指標指向映射表中的值，直接修改即可，不需再放回映射表
             *num += atoi(val);
             s_out_f("result: %d", *num);
-            GenericTable_Add_Int(table, key, *num);
             break;
         }
         case GEN_TYPE_DOUBLE:
@@ -211,20 +217,13 @@ void _IncreaseValue(GenericTable *table, char *in_buf)
             }
             *num += atof(val);
             s_out_f("result: %f", *num);
-            GenericTable_Add_Double(table, key, *num);
             break;
         }
         default:
             break;
     }
-    if (key) 
-    {
-        free(key);
-    }
-    if (val) 
-    {
-        free(val);
-    }
+    Delete_GenericString(&key_str);
+    Delete_GenericString(&val_str);
 }
 
 void _help()
@@ -237,7 +236,7 @@ void _help()
     s_out("exit: exit the application");
 }
 
-int _Pending_action(char *cmd)
+int _Pending_action(const char *cmd)
 {
     int *act = GenericTable_Find_Int(_cmd_table, cmd);
     if (!act)
@@ -251,16 +250,16 @@ int main(int argc, char **argv)
 {
     _Init_action_map();
     _PrintTable(_cmd_table);
-    char *in_buf = (char*) calloc(100, sizeof(char));
+    char *in_buf = (char*) calloc(BUF_SIZE, sizeof(char));
     GenericTable *table = New_GenericTable();
     int action;
     s_out("Welcome, please type command below, or type 'help' for more info.");
     while (true)
     {
         printf(">");
-        char *cmd, *key;
+        GenericString *cmd, *key;
         cmd = _ReadInput(in_buf);
-        action = _Pending_action(cmd);
+        action = _Pending_action(GenericString_Chars(cmd));
         switch (action) 
         {
             case ACT_EXIT:
@@ -268,18 +267,18 @@ int main(int argc, char **argv)
                 break;
             case ACT_DEL:
                 key = _ReadKey(in_buf);
-                GenericTable_Delete(table, key);
-                free(key);
+                GenericTable_Delete(table, GenericString_Chars(key));
+                Delete_GenericString(&key);
                 break;
             case ACT_SET:
                 key = _ReadKey(in_buf);
-                _PutItem(table, key, in_buf);
-                free(key);
+                _PutItem(table, GenericString_Chars(key), in_buf);
+                Delete_GenericString(&key);
                 break;
             case ACT_GET:
                 key = _ReadKey(in_buf);
-                _FindItem(table, key);
-                free(key);
+                _FindItem(table, GenericString_Chars(key));
+                Delete_GenericString(&key);
                 break;
             case ACT_SHOW:
                 _PrintTable(table);
@@ -294,10 +293,7 @@ int main(int argc, char **argv)
                 break;
         }
 
-        if (cmd) 
-        {
-            free(cmd);
-        }
+        Delete_GenericString(&cmd);
         
         if (action == ACT_EXIT) 
         {
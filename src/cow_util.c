@@ -0,0 +1,408 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "../include/common_util.h"
+#include "../include/cow_util.h"
+
+// ================================================================================
+// Private Properties
+// ================================================================================
+/**
+ * 版本保管的元素，epoch 為元素放入容器時的值
+ */
+typedef struct _CowRetired
+{
+    void *ptr;
+    int epoch;
+    struct _CowRetired *next;
+} _CowRetired;
+
+struct CowUtil_Version
+{
+    void *data;
+    /**
+     * 可讀取此版本的快照世代範圍 [from, until]
+     */
+    uint64_t from;
+    uint64_t until;
+    /**
+     * 凍結時容器的 epoch，放入時 epoch 不大於此值的元素都與此版本共用
+     */
+    int epoch;
+    _CowRetired *retired;
+    CowUtil_Version *older;
+};
+
+/**
+ * 存活中的快照
+ */
+typedef struct _CowSnapshot
+{
+    uint64_t generation;
+    CowUtil_State *root;
+} _CowSnapshot;
+
+/**
+ * 全域世代，建立、結束快照時遞增，從 1 開始，0 代表不在快照中
+ */
+static _Atomic uint64_t _generation = 1;
+
+static pthread_mutex_t _snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _CowSnapshot *_snapshots = NULL;
+
+static int _snapshot_count = 0;
+
+static int _snapshot_capacity = 0;
+
+static _Thread_local uint64_t _read_generation = 0;
+
+/**
+ * root 是否為 state 本身或其上層容器，須持有 _snapshot_lock，
+ * 共用的子樹有多個上層容器，任一條路徑到達 root 即可
+ */
+static bool _IsAncestor(CowUtil_State *state, CowUtil_State *root)
+{
+    while (state != root)
+    {
+        if (!state->parent) return false;
+
+        for (int i = 0; i < state->more_count; i++)
+        {
+            if (_IsAncestor(state->more_parents[i], root)) return true;
+        }
+        state = state->parent;
+    }
+    return true;
+}
+
+/**
+ * 由 state 往上使雜湊值失效，須持有 _snapshot_lock，
+ * 有效的容器中所有子容器都有效，已失效的容器其上層容器也一定已失效，不需再往上
+ */
+static void _InvalidateHash(CowUtil_State *state)
+{
+    while (state && atomic_load_explicit(&(state->hash), memory_order_relaxed))
+    {
+        atomic_store_explicit(&(state->hash), 0, memory_order_release);
+        for (int i = 0; i < state->more_count; i++)
+        {
+            _InvalidateHash(state->more_parents[i]);
+        }
+        state = state->parent;
+    }
+}
+
+/**
+ * 是否有世代在 [from, until] 之間、且包含此容器的快照
+ */
+static bool _AnyAlive(CowUtil_State *state, uint64_t from, uint64_t until)
+{
+    if (from > until) return false;
+
+    bool alive = false;
+    pthread_mutex_lock(&_snapshot_lock);
+    for (int i = 0; i < _snapshot_count && !alive; i++)
+    {
+        _CowSnapshot *snapshot = &(_snapshots[i]);
+        alive = snapshot->generation >= from && snapshot->generation <= until
+            && _IsAncestor(state, snapshot->root);
+    }
+    pthread_mutex_unlock(&_snapshot_lock);
+    return alive;
+}
+
+/**
+ * 凍結目前的狀態供世代小於 generation 的快照讀取，須持有 state->lock，
+ * 凍結後尚未修改時直接延長最新的版本，不重複凍結
+ */
+static void _Freeze(CowUtil_State *state, const CowUtil_Ops *ops, void *owner, uint64_t generation)
+{
+    if (state->frozen && state->newest)
+    {
+        state->newest->until = generation - 1;
+    }
+    else
+    {
+        CowUtil_Version *version = (CowUtil_Version*) malloc(sizeof(CowUtil_Version));
+        version->data = ops->freeze(owner);
+        version->from = state->from;
+        version->until = generation - 1;
+        version->epoch = state->epoch;
+        version->retired = NULL;
+        version->older = state->newest;
+        state->newest = version;
+        state->epoch++;
+        state->frozen = true;
+    }
+    state->from = generation;
+}
+
+/**
+ * 拿掉不再被任何快照需要的版本，須持有 state->lock，
+ * 版本保管的元素仍與較舊的版本共用時轉交給較舊的版本，
+ * 拿掉的版本與要釋放的元素由 p_versions、p_retired 帶回，解鎖後才釋放
+ */
+static void _Prune(CowUtil_State *state, CowUtil_Version **p_versions, _CowRetired **p_retired)
+{
+    CowUtil_Version **link = &(state->newest);
+    while (*link)
+    {
+        CowUtil_Version *version = *link;
+        if (_AnyAlive(state, version->from, version->until))
+        {
+            link = &(version->older);
+            continue;
+        }
+
+        // 拿掉的是目前狀態的版本，之後凍結需要建立新的版本
+        if (link == &(state->newest)) state->frozen = false;
+        *link = version->older;
+
+        CowUtil_Version *older = version->older;
+        _CowRetired *retired = version->retired;
+        while (retired)
+        {
+            _CowRetired *next = retired->next;
+            if (older && older->epoch >= retired->epoch)
+            {
+                retired->next = older->retired;
+                older->retired = retired;
+            }
+            else
+            {
+                retired->next = *p_retired;
+                *p_retired = retired;
+            }
+            retired = next;
+        }
+        version->older = *p_versions;
+        *p_versions = version;
+    }
+}
+
+static void _Release(const CowUtil_Ops *ops, void *owner, CowUtil_Version *versions, _CowRetired *retired)
+{
+    while (retired)
+    {
+        _CowRetired *next = retired->next;
+        ops->drop(owner, retired->ptr);
+        free(retired);
+        retired = next;
+    }
+    while (versions)
+    {
+        CowUtil_Version *next = versions->older;
+        ops->release(owner, versions->data);
+        free(versions);
+        versions = next;
+    }
+}
+
+// ================================================================================
+// Public properties
+// ================================================================================
+void CowUtil_Init(CowUtil_State *state)
+{
+    pthread_mutex_init(&(state->lock), NULL);
+    atomic_init(&(state->checked), 0);
+    state->from = atomic_load(&_generation);
+    state->epoch = 0;
+    state->frozen = false;
+    state->newest = NULL;
+    state->parent = NULL;
+    state->more_parents = NULL;
+    state->more_count = 0;
+    state->more_capacity = 0;
+    atomic_init(&(state->hash), 0);
+}
+
+void CowUtil_Destroy(CowUtil_State *state, const CowUtil_Ops *ops, void *owner)
+{
+    _CowRetired *retired = NULL;
+    for (CowUtil_Version *version = state->newest; version; version = version->older)
+    {
+        while (version->retired)
+        {
+            _CowRetired *node = version->retired;
+            version->retired = node->next;
+            node->next = retired;
+            retired = node;
+        }
+    }
+    _Release(ops, owner, state->newest, retired);
+    state->newest = NULL;
+    pthread_mutex_destroy(&(state->lock));
+    free(state->more_parents);
+    state->more_parents = NULL;
+    state->more_count = 0;
+}
+
+int CowUtil_AddParent(CowUtil_State *state, CowUtil_State *parent)
+{
+    pthread_mutex_lock(&_snapshot_lock);
+    if (_IsAncestor(parent, state))
+    {
+        pthread_mutex_unlock(&_snapshot_lock);
+        s_out_err("CowUtil_AddParent would create a cycle");
+        return 0;
+    }
+    if (!state->parent)
+    {
+        state->parent = parent;
+        pthread_mutex_unlock(&_snapshot_lock);
+        return 1;
+    }
+
+    if (state->more_count == state->more_capacity)
+    {
+        int capacity = state->more_capacity ? state->more_capacity * 2 : 4;
+        state->more_parents = (CowUtil_State**) realloc(state->more_parents, (size_t) capacity * sizeof(CowUtil_State*));
+        state->more_capacity = capacity;
+    }
+    state->more_parents[state->more_count++] = parent;
+    int count = state->more_count + 1;
+    pthread_mutex_unlock(&_snapshot_lock);
+    return count;
+}
+
+void CowUtil_RemoveParent(CowUtil_State *state, CowUtil_State *parent)
+{
+    pthread_mutex_lock(&_snapshot_lock);
+    int found = state->parent == parent ? state->more_count : -1;
+    for (int i = 0; i < state->more_count && found < 0; i++)
+    {
+        if (state->more_parents[i] == parent) found = i;
+    }
+    if (found >= 0)
+    {
+        // 移除的是第一筆時，由最後一筆遞補
+        CowUtil_State *last = state->more_count ? state->more_parents[state->more_count - 1] : NULL;
+        if (found == state->more_count)
+            state->parent = last;
+        else
+            state->more_parents[found] = last;
+        if (state->more_count) state->more_count--;
+    }
+    // 不再共用時釋放，arena 中的子樹不會呼叫 CowUtil_Destroy
+    if (!state->more_count && state->more_parents)
+    {
+        free(state->more_parents);
+        state->more_parents = NULL;
+        state->more_capacity = 0;
+    }
+    pthread_mutex_unlock(&_snapshot_lock);
+}
+
+void CowUtil_InvalidateHash(CowUtil_State *state)
+{
+    if (!atomic_load_explicit(&(state->hash), memory_order_relaxed)) return;
+
+    pthread_mutex_lock(&_snapshot_lock);
+    _InvalidateHash(state);
+    pthread_mutex_unlock(&_snapshot_lock);
+}
+
+uint64_t CowUtil_BeginSnapshot(CowUtil_State *root)
+{
+    pthread_mutex_lock(&_snapshot_lock);
+    if (_snapshot_count == _snapshot_capacity)
+    {
+        int capacity = _snapshot_capacity ? _snapshot_capacity * 2 : 8;
+        _snapshots = (_CowSnapshot*) realloc(_snapshots, (size_t) capacity * sizeof(_CowSnapshot));
+        _snapshot_capacity = capacity;
+    }
+    uint64_t generation = atomic_load(&_generation);
+    _snapshots[_snapshot_count].generation = generation;
+    _snapshots[_snapshot_count].root = root;
+    _snapshot_count++;
+    atomic_store(&_generation, generation + 1);
+    pthread_mutex_unlock(&_snapshot_lock);
+    return generation;
+}
+
+void CowUtil_EndSnapshot(uint64_t generation)
+{
+    pthread_mutex_lock(&_snapshot_lock);
+    for (int i = 0; i < _snapshot_count; i++)
+    {
+        if (_snapshots[i].generation != generation) continue;
+
+        _snapshots[i] = _snapshots[_snapshot_count - 1];
+        _snapshot_count--;
+        break;
+    }
+    // 讓每個容器下一次寫入時重新檢查，釋放不再需要的版本
+    atomic_fetch_add(&_generation, 1);
+    pthread_mutex_unlock(&_snapshot_lock);
+}
+
+uint64_t CowUtil_ReadGeneration(void)
+{
+    return _read_generation;
+}
+
+void CowUtil_SetReadGeneration(uint64_t generation)
+{
+    _read_generation = generation;
+}
+
+void CowUtil_PrepareWrite(CowUtil_State *state, const CowUtil_Ops *ops, void *owner)
+{
+    uint64_t generation = atomic_load_explicit(&_generation, memory_order_acquire);
+    if (atomic_load_explicit(&(state->checked), memory_order_acquire) == generation) return;
+
+    CowUtil_Version *versions = NULL;
+    _CowRetired *retired = NULL;
+    pthread_mutex_lock(&(state->lock));
+    _Prune(state, &versions, &retired);
+    if (_AnyAlive(state, state->from, generation - 1))
+        _Freeze(state, ops, owner, generation);
+    else
+        state->from = generation;
+    atomic_store_explicit(&(state->checked), generation, memory_order_release);
+    pthread_mutex_unlock(&(state->lock));
+
+    _Release(ops, owner, versions, retired);
+}
+
+bool CowUtil_IsShared(CowUtil_State *state, int epoch)
+{
+    return state->newest && state->newest->epoch >= epoch;
+}
+
+void CowUtil_Retire(CowUtil_State *state, const CowUtil_Ops *ops, void *owner, void *ptr, int epoch)
+{
+    CowUtil_Version *newest = state->newest;
+    if (!newest || newest->epoch < epoch)
+    {
+        ops->drop(owner, ptr);
+        return;
+    }
+
+    _CowRetired *retired = (_CowRetired*) malloc(sizeof(_CowRetired));
+    retired->ptr = ptr;
+    retired->epoch = epoch;
+    retired->next = newest->retired;
+    newest->retired = retired;
+}
+
+void* CowUtil_Resolve(CowUtil_State *state, const CowUtil_Ops *ops, void *owner, uint64_t generation)
+{
+    void *data = NULL;
+    pthread_mutex_lock(&(state->lock));
+    // 快照之後尚未寫入，寫入端不會同時修改，直接凍結目前的狀態
+    if (generation >= state->from) _Freeze(state, ops, owner, atomic_load(&_generation));
+
+    for (CowUtil_Version *version = state->newest; version; version = version->older)
+    {
+        if (generation < version->from || generation > version->until) continue;
+
+        data = version->data;
+        break;
+    }
+    pthread_mutex_unlock(&(state->lock));
+    return data;
+}
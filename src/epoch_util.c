@@ -0,0 +1,215 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "../include/epoch_util.h"
+
+// ================================================================================
+// Private Properties
+// ================================================================================
+/**
+ * 每個執行緒一筆的世代紀錄，執行緒結束後標記為未使用，讓之後的執行緒重複利用，
+ * state 為 0 時代表不在讀取區段，否則為 (進入時的世代 << 1) | 1
+ */
+typedef struct _EpochRecord
+{
+    _Atomic uint64_t state;
+    atomic_bool in_use;
+    int nesting;
+    struct _EpochRecord *next;
+} _EpochRecord;
+
+typedef struct _RetiredNode
+{
+    /**
+     * 登記這塊記憶體的共用結構，可為 NULL
+     */
+    const void *owner;
+    void *ptr;
+    EpochUtil_FreeFn free_fn;
+    uint64_t epoch;
+    struct _RetiredNode *next;
+} _RetiredNode;
+
+static _Atomic uint64_t _global_epoch = 1;
+
+static _Atomic(_EpochRecord*) _records = NULL;
+
+static _Thread_local _EpochRecord *_local_record = NULL;
+
+static pthread_once_t _key_once = PTHREAD_ONCE_INIT;
+
+static pthread_key_t _record_key;
+
+/**
+ * 等待釋放的記憶體，依登記順序串接，只有寫入端會碰到，以互斥鎖保護
+ */
+static pthread_mutex_t _retired_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _RetiredNode *_retired_head = NULL;
+
+static _RetiredNode *_retired_tail = NULL;
+
+static int _retired_count = 0;
+
+static void _ReleaseRecord(void *ptr)
+{
+    _EpochRecord *record = (_EpochRecord*) ptr;
+    atomic_store_explicit(&(record->state), 0, memory_order_release);
+    atomic_store_explicit(&(record->in_use), 0, memory_order_release);
+}
+
+static void _CreateKey(void)
+{
+    pthread_key_create(&_record_key, _ReleaseRecord);
+}
+
+static _EpochRecord* _GetRecord(void)
+{
+    if (_local_record) return _local_record;
+
+    pthread_once(&_key_once, _CreateKey);
+    for (_EpochRecord *record = atomic_load(&_records); record; record = record->next)
+    {
+        _Bool expected = 0;
+        if (!atomic_load_explicit(&(record->in_use), memory_order_relaxed)
+            && atomic_compare_exchange_strong(&(record->in_use), &expected, 1))
+        {
+            _local_record = record;
+            break;
+        }
+    }
+    if (!_local_record)
+    {
+        _EpochRecord *record = (_EpochRecord*) malloc(sizeof(_EpochRecord));
+        atomic_init(&(record->state), 0);
+        atomic_init(&(record->in_use), 1);
+        record->next = atomic_load(&_records);
+        while (!atomic_compare_exchange_weak(&_records, &(record->next), record));
+        _local_record = record;
+    }
+    _local_record->nesting = 0;
+    pthread_setspecific(_record_key, _local_record);
+    return _local_record;
+}
+
+/**
+ * 所有在讀取區段中的執行緒都已看見目前世代時，才能推進世代
+ */
+static uint64_t _TryAdvance(void)
+{
+    uint64_t epoch = atomic_load(&_global_epoch);
+    for (_EpochRecord *record = atomic_load(&_records); record; record = record->next)
+    {
+        uint64_t state = atomic_load(&(record->state));
+        if ((state & 1) && (state >> 1) != epoch) return epoch;
+    }
+    if (atomic_compare_exchange_strong(&_global_epoch, &epoch, epoch + 1)) return epoch + 1;
+    return epoch;
+}
+
+static void _FreeNode(_RetiredNode *node)
+{
+    _retired_count--;
+    node->free_fn(node->ptr);
+    free(node);
+}
+
+/**
+ * 在世代 e 登記的記憶體，世代推進到 e + 2 時，已沒有讀取端可能持有，
+ * 呼叫前須持有 _retired_lock，回傳後 _retired_lock 仍持有
+ */
+static void _FreeExpired(uint64_t epoch)
+{
+    while (_retired_head && _retired_head->epoch + 2 <= epoch)
+    {
+        _RetiredNode *node = _retired_head;
+        _retired_head = node->next;
+        if (!_retired_head) _retired_tail = NULL;
+        _FreeNode(node);
+    }
+}
+
+// ================================================================================
+// Public properties
+// ================================================================================
+void EpochUtil_Enter(void)
+{
+    _EpochRecord *record = _GetRecord();
+    if (record->nesting++ > 0) return;
+    uint64_t epoch = atomic_load(&_global_epoch);
+    atomic_store(&(record->state), (epoch << 1) | 1);
+    // 宣告進入後才能讀取共用資料，避免讀取被重排到宣告之前
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void EpochUtil_Exit(void)
+{
+    _EpochRecord *record = _local_record;
+    if (--record->nesting > 0) return;
+    atomic_store_explicit(&(record->state), 0, memory_order_release);
+}
+
+void EpochUtil_Retire(void *ptr, EpochUtil_FreeFn free_fn)
+{
+    EpochUtil_RetireOwned(NULL, ptr, free_fn);
+}
+
+void EpochUtil_RetireOwned(const void *owner, void *ptr, EpochUtil_FreeFn free_fn)
+{
+    if (!ptr) return;
+    _RetiredNode *node = (_RetiredNode*) malloc(sizeof(_RetiredNode));
+    node->owner = owner;
+    node->ptr = ptr;
+    node->free_fn = free_fn;
+    node->next = NULL;
+
+    pthread_mutex_lock(&_retired_lock);
+    node->epoch = atomic_load(&_global_epoch);
+    if (_retired_tail) _retired_tail->next = node;
+    else _retired_head = node;
+    _retired_tail = node;
+    _retired_count++;
+    _FreeExpired(_TryAdvance());
+    pthread_mutex_unlock(&_retired_lock);
+}
+
+void EpochUtil_FreeOwned(const void *owner)
+{
+    if (!owner) return;
+    pthread_mutex_lock(&_retired_lock);
+    _RetiredNode *prev = NULL;
+    _RetiredNode *node = _retired_head;
+    while (node)
+    {
+        _RetiredNode *next = node->next;
+        if (node->owner != owner)
+        {
+            prev = node;
+            node = next;
+            continue;
+        }
+        if (prev) prev->next = next;
+        else _retired_head = next;
+        if (_retired_tail == node) _retired_tail = prev;
+        _FreeNode(node);
+        node = next;
+    }
+    pthread_mutex_unlock(&_retired_lock);
+}
+
+int EpochUtil_Reclaim(void)
+{
+    pthread_mutex_lock(&_retired_lock);
+    _FreeExpired(_TryAdvance());
+    int count = _retired_count;
+    pthread_mutex_unlock(&_retired_lock);
+    return count;
+}
+
+void EpochUtil_Synchronize(void)
+{
+    while (EpochUtil_Reclaim() > 0) sched_yield();
+}
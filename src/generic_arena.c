@@ -0,0 +1,191 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/generic_arena.h"
+#include "../include/common_util.h"
+
+// ================================================================================
+// Private Properties
+// ================================================================================
+static const size_t _DEFAULT_CHUNK_SIZE = 0x10000;
+
+#define _ALIGNMENT 16
+
+/**
+ * 一個區塊，資料緊接在結構之後
+ */
+typedef struct _ArenaChunk
+{
+    struct _ArenaChunk *next;
+    size_t size;
+    size_t used;
+} _ArenaChunk;
+
+typedef struct _ArenaCleanup
+{
+    struct _ArenaCleanup *next;
+    GenericArena_CleanupFn cleanup;
+    void *ptr;
+} _ArenaCleanup;
+
+struct GenericArena
+{
+    size_t chunk_size;
+    /**
+     * 目前切割中的區塊，鏈結串列的開頭，最後一個為第一個配置的區塊
+     */
+    _ArenaChunk *current;
+    /**
+     * 獨立配置的大區塊
+     */
+    _ArenaChunk *large;
+    /**
+     * 清理函式，最新登記的在開頭
+     */
+    _ArenaCleanup *cleanups;
+    size_t bytes_used;
+};
+
+static inline size_t _AlignUp(size_t size)
+{
+    return (size + _ALIGNMENT - 1) & ~((size_t) _ALIGNMENT - 1);
+}
+
+static inline char* _ChunkData(_ArenaChunk *chunk)
+{
+    return (char*) chunk + _AlignUp(sizeof(_ArenaChunk));
+}
+
+static _ArenaChunk* _New_Chunk(size_t size, _ArenaChunk *next)
+{
+    _ArenaChunk *chunk = (_ArenaChunk*) malloc(_AlignUp(sizeof(_ArenaChunk)) + size);
+    if (!chunk)
+    {
+        s_out_err("malloc GenericArena chunk failed");
+        return NULL;
+    }
+    chunk->next = next;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+static void _Free_Chunks(_ArenaChunk *chunk, _ArenaChunk *stop)
+{
+    while (chunk != stop)
+    {
+        _ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+static void _RunCleanups(GenericArena *arena)
+{
+    _ArenaCleanup *node = arena->cleanups;
+    arena->cleanups = NULL;
+    for (; node; node = node->next)
+    {
+        node->cleanup(node->ptr);
+    }
+}
+
+// ================================================================================
+// Public properties
+// ================================================================================
+GenericArena* New_GenericArena(void)
+{
+    return New_GenericArena_WithChunkSize(_DEFAULT_CHUNK_SIZE);
+}
+
+GenericArena* New_GenericArena_WithChunkSize(size_t chunk_size)
+{
+    if (chunk_size < 0x100) chunk_size = 0x100;
+    GenericArena *arena = (GenericArena*) malloc(sizeof(GenericArena));
+    arena->chunk_size = _AlignUp(chunk_size);
+    arena->current = _New_Chunk(arena->chunk_size, NULL);
+    arena->large = NULL;
+    arena->cleanups = NULL;
+    arena->bytes_used = 0;
+    return arena;
+}
+
+void Delete_GenericArena(GenericArena **p_arena)
+{
+    GenericArena *arena = *p_arena;
+    _RunCleanups(arena);
+    _Free_Chunks(arena->current, NULL);
+    _Free_Chunks(arena->large, NULL);
+    free(arena);
+    *p_arena = NULL;
+}
+
+void GenericArena_Reset(GenericArena *arena)
+{
+    _RunCleanups(arena);
+    _Free_Chunks(arena->large, NULL);
+    arena->large = NULL;
+
+    // 只保留第一個配置的區塊
+    _ArenaChunk *first = arena->current;
+    while (first->next) first = first->next;
+    _Free_Chunks(arena->current, first);
+    first->used = 0;
+    arena->current = first;
+    arena->bytes_used = 0;
+}
+
+void* GenericArena_Alloc(GenericArena *arena, size_t size)
+{
+    size = _AlignUp(size ? size : 1);
+    arena->bytes_used += size;
+
+    if (size > arena->chunk_size / 4)
+    {
+        _ArenaChunk *chunk = _New_Chunk(size, arena->large);
+        if (!chunk) return NULL;
+        chunk->used = size;
+        arena->large = chunk;
+        return _ChunkData(chunk);
+    }
+
+    _ArenaChunk *chunk = arena->current;
+    if (chunk->used + size > chunk->size)
+    {
+        chunk = _New_Chunk(arena->chunk_size, chunk);
+        if (!chunk) return NULL;
+        arena->current = chunk;
+    }
+    void *ptr = _ChunkData(chunk) + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+void* GenericArena_Calloc(GenericArena *arena, size_t size)
+{
+    void *ptr = GenericArena_Alloc(arena, size);
+    if (ptr) memset(ptr, 0, size);
+    return ptr;
+}
+
+char* GenericArena_StrDup(GenericArena *arena, const char *str)
+{
+    size_t len = strlen(str) + 1;
+    char *dest = (char*) GenericArena_Alloc(arena, len);
+    if (dest) memcpy(dest, str, len);
+    return dest;
+}
+
+void GenericArena_AddCleanup(GenericArena *arena, GenericArena_CleanupFn cleanup, void *ptr)
+{
+    _ArenaCleanup *node = (_ArenaCleanup*) GenericArena_Alloc(arena, sizeof(_ArenaCleanup));
+    node->cleanup = cleanup;
+    node->ptr = ptr;
+    node->next = arena->cleanups;
+    arena->cleanups = node;
+}
+
+size_t GenericArena_BytesUsed(GenericArena *arena)
+{
+    return arena->bytes_used;
+}
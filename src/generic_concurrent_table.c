@@ -0,0 +1,272 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../include/generic_concurrent_table.h"
+#include "../include/generic_table.h"
+#include "../include/generic_type.h"
+#include "../include/common_util.h"
+#include "../include/hash_util.h"
+
+// ================================================================================
+// Private Properties
+// ================================================================================
+// 分片對齊 cache line，避免不同分片的鎖互相干擾(false sharing)
+#define _CACHE_LINE 64
+
+static const int _DEFAULT_SHARD_COUNT = 0X40;
+
+typedef struct _GenericTableShard
+{
+    pthread_rwlock_t lock;
+    GenericTable *table;
+} __attribute__((aligned(_CACHE_LINE))) _GenericTableShard;
+
+struct GenericConcurrentTable
+{
+    int shard_count;
+    /**
+     * 分片數量減一，shard_count 為 2 的次方，以位元運算取代取餘數
+     */
+    int shard_mask;
+    /**
+     * 選擇分片用的種子
+     */
+    uint64_t seed;
+    _GenericTableShard *shards;
+};
+
+static inline _GenericTableShard* _ShardOf(GenericConcurrentTable *table, const char *key)
+{
+    // 以分片自己的種子另外雜湊一次，分片內的映射表查找時會再雜湊一次，
+    // 分片的映射表可由選項指定雜湊函式與種子，無法共用同一個雜湊值
+    uint64_t hash = HashUtil_WyHash(key, strlen(key), table->seed);
+    return &(table->shards[(hash >> 32) & table->shard_mask]);
+}
+
+static inline _GenericTableShard* _ReadLock(GenericConcurrentTable *table, const char *key)
+{
+    _GenericTableShard *shard = _ShardOf(table, key);
+    pthread_rwlock_rdlock(&(shard->lock));
+    return shard;
+}
+
+static inline _GenericTableShard* _WriteLock(GenericConcurrentTable *table, const char *key)
+{
+    _GenericTableShard *shard = _ShardOf(table, key);
+    pthread_rwlock_wrlock(&(shard->lock));
+    return shard;
+}
+
+static inline void _Unlock(_GenericTableShard *shard)
+{
+    pthread_rwlock_unlock(&(shard->lock));
+}
+
+/**
+ * 持有分片讀鎖時查找 type 型別的值，找不到或型別不符時回傳 NULL
+ *
+ * 不可使用 GenericTable_Find_*：回傳可修改指標的查找是寫入路徑，只能在寫鎖下呼叫，
+ * GenericTable_FindMany 只讀取映射表，多個讀者可以同時呼叫
+ */
+static GenericType* _FindValue(_GenericTableShard *shard, const char *key, GenericTypeEnum type)
+{
+    GenericType *value = NULL;
+    GenericTable_FindMany(shard->table, &key, 1, &value);
+    return value && GenericType_IsType(value, type) ? value : NULL;
+}
+
+// ================================================================================
+// Public properties
+// ================================================================================
+GenericConcurrentTable* New_GenericConcurrentTable(int shard_count)
+{
+    return New_GenericConcurrentTable_WithOptions(shard_count, NULL);
+}
+
+GenericConcurrentTable* New_GenericConcurrentTable_WithOptions(int shard_count, const GenericTableOptions *options)
+{
+    if (shard_count <= 0) shard_count = _DEFAULT_SHARD_COUNT;
+    int count = 1;
+    while (count < shard_count) count <<= 1;
+
+    GenericTableOptions shard_options = options ? *options : GenericTable_DefaultOptions();
+    shard_options.rehash_on_lookup = false;
+    // arena 不是執行緒安全的，分片一律以 malloc 配置
+    shard_options.arena = NULL;
+
+    GenericConcurrentTable *table = (GenericConcurrentTable*) malloc(sizeof(GenericConcurrentTable));
+    table->shard_count = count;
+    table->shard_mask = count - 1;
+    table->seed = HashUtil_ProcessSeed() ^ 0x9e3779b97f4a7c15ull;
+    table->shards = (_GenericTableShard*) aligned_alloc(_CACHE_LINE, sizeof(_GenericTableShard) * count);
+    for (int i = 0; i < count; i++)
+    {
+        pthread_rwlock_init(&(table->shards[i].lock), NULL);
+        table->shards[i].table = New_GenericTable_WithOptions(&shard_options);
+    }
+    return table;
+}
+
+void Delete_GenericConcurrentTable(GenericConcurrentTable **p_table)
+{
+    GenericConcurrentTable *table = *p_table;
+    for (int i = 0; i < table->shard_count; i++)
+    {
+        Delete_GenericTable(&(table->shards[i].table));
+        pthread_rwlock_destroy(&(table->shards[i].lock));
+    }
+    free(table->shards);
+    free(table);
+    *p_table = NULL;
+}
+
+void GenericConcurrentTable_Add_Str(GenericConcurrentTable *table, const char *key, const char *value)
+{
+    _GenericTableShard *shard = _WriteLock(table, key);
+    GenericTable_Add_Str(shard->table, key, value);
+    _Unlock(shard);
+}
+
+void GenericConcurrentTable_Add_Int(GenericConcurrentTable *table, const char *key, int value)
+{
+    _GenericTableShard *shard = _WriteLock(table, key);
+    GenericTable_Add_Int(shard->table, key, value);
+    _Unlock(shard);
+}
+
+void GenericConcurrentTable_Add_Long(GenericConcurrentTable *table, const char *key, long value)
+{
+    _GenericTableShard *shard = _WriteLock(table, key);
+    GenericTable_Add_Long(shard->table, key, value);
+    _Unlock(shard);
+}
+
+void GenericConcurrentTable_Add_Double(GenericConcurrentTable *table, const char *key, double value)
+{
+    _GenericTableShard *shard = _WriteLock(table, key);
+    GenericTable_Add_Double(shard->table, key, value);
+    _Unlock(shard);
+}
+
+void GenericConcurrentTable_Add_Float(GenericConcurrentTable *table, const char *key, float value)
+{
+    _GenericTableShard *shard = _WriteLock(table, key);
+    GenericTable_Add_Float(shard->table, key, value);
+    _Unlock(shard);
+}
+
+void GenericConcurrentTable_Add_Table(GenericConcurrentTable *table, const char *key, GenericTable *value)
+{
+    _GenericTableShard *shard = _WriteLock(table, key);
+    GenericTable_Add_Table(shard->table, key, value);
+    _Unlock(shard);
+}
+
+void GenericConcurrentTable_Add_List(GenericConcurrentTable *table, const char *key, struct GenericList *value)
+{
+    _GenericTableShard *shard = _WriteLock(table, key);
+    GenericTable_Add_List(shard->table, key, value);
+    _Unlock(shard);
+}
+
+char* GenericConcurrentTable_Find_Str(GenericConcurrentTable *table, const char *key)
+{
+    _GenericTableShard *shard = _ReadLock(table, key);
+    GenericType *value = _FindValue(shard, key, GEN_TYPE_STR);
+    char *copy = value ? strdup(GenericType_GetStr(value)) : NULL;
+    _Unlock(shard);
+    return copy;
+}
+
+bool GenericConcurrentTable_Find_Int(GenericConcurrentTable *table, const char *key, int *out)
+{
+    _GenericTableShard *shard = _ReadLock(table, key);
+    GenericType *value = _FindValue(shard, key, GEN_TYPE_INT);
+    if (value) *out = *GenericType_GetInt(value);
+    _Unlock(shard);
+    return value != NULL;
+}
+
+bool GenericConcurrentTable_Find_Long(GenericConcurrentTable *table, const char *key, long *out)
+{
+    _GenericTableShard *shard = _ReadLock(table, key);
+    GenericType *value = _FindValue(shard, key, GEN_TYPE_LONG);
+    if (value) *out = *GenericType_GetLong(value);
+    _Unlock(shard);
+    return value != NULL;
+}
+
+bool GenericConcurrentTable_Find_Double(GenericConcurrentTable *table, const char *key, double *out)
+{
+    _GenericTableShard *shard = _ReadLock(table, key);
+    GenericType *value = _FindValue(shard, key, GEN_TYPE_DOUBLE);
+    if (value) *out = *GenericType_GetDouble(value);
+    _Unlock(shard);
+    return value != NULL;
+}
+
+bool GenericConcurrentTable_Find_Float(GenericConcurrentTable *table, const char *key, float *out)
+{
+    _GenericTableShard *shard = _ReadLock(table, key);
+    GenericType *value = _FindValue(shard, key, GEN_TYPE_FLOAT);
+    if (value) *out = *GenericType_GetFloat(value);
+    _Unlock(shard);
+    return value != NULL;
+}
+
+bool GenericConcurrentTable_Read(GenericConcurrentTable *table, const char *key, GenericConcurrentTable_Visitor reader, void *context)
+{
+    _GenericTableShard *shard = _ReadLock(table, key);
+    GenericType *value = NULL;
+    GenericTable_FindMany(shard->table, &key, 1, &value);
+    if (value) reader(key, value, context);
+    _Unlock(shard);
+    return value != NULL;
+}
+
+void GenericConcurrentTable_Delete(GenericConcurrentTable *table, const char *key)
+{
+    _GenericTableShard *shard = _WriteLock(table, key);
+    GenericTable_Delete(shard->table, key);
+    _Unlock(shard);
+}
+
+bool GenericConcurrentTable_HasKey(GenericConcurrentTable *table, const char *key)
+{
+    _GenericTableShard *shard = _ReadLock(table, key);
+    bool has_key = GenericTable_HasKey(shard->table, key);
+    _Unlock(shard);
+    return has_key;
+}
+
+int GenericConcurrentTable_Size(GenericConcurrentTable *table)
+{
+    int size = 0;
+    for (int i = 0; i < table->shard_count; i++)
+    {
+        _GenericTableShard *shard = &(table->shards[i]);
+        pthread_rwlock_rdlock(&(shard->lock));
+        size += GenericTable_Size(shard->table);
+        _Unlock(shard);
+    }
+    return size;
+}
+
+void GenericConcurrentTable_ForEach(GenericConcurrentTable *table, GenericConcurrentTable_Visitor visitor, void *context)
+{
+    for (int i = 0; i < table->shard_count; i++)
+    {
+        _GenericTableShard *shard = &(table->shards[i]);
+        pthread_rwlock_rdlock(&(shard->lock));
+        // 分片的映射表關閉了 rehash_on_lookup，GenericTable_Begin 不會修改映射表，可在讀取鎖內迭代
+        GenericTable_Cursor cursor = GenericTable_Begin(shard->table);
+        const char *key;
+        GenericType *value;
+        while (GenericTable_Next(&cursor, &key, &value))
+        {
+            visitor(key, value, context);
+        }
+        _Unlock(shard);
+    }
+}
@@ -0,0 +1,306 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../include/common_util.h"
+#include "../include/cow_util.h"
+#include "../include/generic_arena.h"
+#include "../include/generic_type.h"
+#include "../include/generic_table.h"
+#include "../include/generic_list.h"
+#include "../include/generic_dedup.h"
+
+// ================================================================================
+// Private Properties
+// ================================================================================
+/**
+ * 登記的節點，node 為 NULL 代表空位
+ */
+typedef struct _DedupEntry
+{
+    uint64_t hash;
+    GenericTypeEnum type;
+    void *node;
+} _DedupEntry;
+
+struct GenericDedup
+{
+    /**
+     * 以結構雜湊值線性探測的登記表，每個節點持有一個參考
+     */
+    _DedupEntry *entries;
+    /**
+     * 位置數量，2 的次方
+     */
+    int size;
+    int count;
+    size_t bytes_saved;
+    int shared_count;
+};
+
+static const int _DEFAULT_SIZE = 0x100;
+
+static inline GenericArena* _Node_Arena(GenericTypeEnum type, void *node)
+{
+    return type == GEN_TYPE_TABLE
+        ? GenericTable_GetArena((GenericTable*) node)
+        : GenericList_GetArena((GenericList*) node);
+}
+
+static inline bool _Node_Equals(GenericTypeEnum type, void *node1, void *node2)
+{
+    return type == GEN_TYPE_TABLE
+        ? GenericTable_Equals((GenericTable*) node1, (GenericTable*) node2)
+        : GenericList_Equals((GenericList*) node1, (GenericList*) node2);
+}
+
+static void _Release_Node(GenericTypeEnum type, void *node)
+{
+    if (type == GEN_TYPE_TABLE)
+    {
+        GenericTable *table = (GenericTable*) node;
+        Delete_GenericTable(&table);
+    }
+    else
+    {
+        GenericList *list = (GenericList*) node;
+        Delete_GenericList(&list);
+    }
+}
+
+/**
+ * 估計值所在的子樹佔用的位元組數：每個映射表、動態陣列本身的總和
+ */
+static size_t _Tree_Bytes(GenericType *value)
+{
+    size_t bytes = 0;
+    if (GenericType_IsType(value, GEN_TYPE_TABLE))
+    {
+        GenericTable *table = GenericType_GetTable(value);
+        bytes += GenericTable_BytesUsed(table);
+        GenericTable_Cursor cursor = GenericTable_Begin(table);
+        GenericType *child;
+        while (GenericTable_Next(&cursor, NULL, &child))
+        {
+            bytes += _Tree_Bytes(child);
+        }
+    }
+    else if (GenericType_IsType(value, GEN_TYPE_LIST))
+    {
+        GenericList *list = GenericType_GetList(value);
+        bytes += GenericList_BytesUsed(list);
+        int size = GenericList_Size(list);
+        for (int i = 0; i < size; i++)
+        {
+            bytes += _Tree_Bytes(GenericList_Get(list, i));
+        }
+    }
+    return bytes;
+}
+
+static void _Place(_DedupEntry *entries, int size, const _DedupEntry *entry)
+{
+    int index = (int) (entry->hash & (uint64_t) (size - 1));
+    while (entries[index].node) index = (index + 1) & (size - 1);
+    entries[index] = *entry;
+}
+
+/**
+ * 登記的節點超過位置數量的一半時擴充為兩倍
+ */
+static bool _Grow(GenericDedup *dedup)
+{
+    int size = dedup->size * 2;
+    _DedupEntry *entries = (_DedupEntry*) calloc(size, sizeof(_DedupEntry));
+    if (!entries)
+    {
+        s_out_err("calloc GenericDedup entries failed");
+        return false;
+    }
+    for (int i = 0; i < dedup->size; i++)
+    {
+        if (dedup->entries[i].node) _Place(entries, size, &(dedup->entries[i]));
+    }
+    free(dedup->entries);
+    dedup->entries = entries;
+    dedup->size = size;
+    return true;
+}
+
+/**
+ * 找到與 node 內容相同的登記節點(可能是 node 本身)，找不到時回傳 NULL
+ */
+static void* _Lookup(GenericDedup *dedup, GenericTypeEnum type, void *node, uint64_t hash)
+{
+    int mask = dedup->size - 1;
+    for (int index = (int) (hash & (uint64_t) mask); dedup->entries[index].node; index = (index + 1) & mask)
+    {
+        _DedupEntry *entry = &(dedup->entries[index]);
+        if (entry->hash != hash || entry->type != type) continue;
+        if (entry->node == node || _Node_Equals(type, entry->node, node)) return entry->node;
+    }
+    return NULL;
+}
+
+static void _Register(GenericDedup *dedup, GenericTypeEnum type, void *node, uint64_t hash)
+{
+    if ((dedup->count + 1) * 2 > dedup->size && !_Grow(dedup)) return;
+
+    _DedupEntry entry;
+    entry.hash = hash;
+    entry.type = type;
+    entry.node = type == GEN_TYPE_TABLE
+        ? (void*) GenericTable_Retain((GenericTable*) node)
+        : (void*) GenericList_Retain((GenericList*) node);
+    _Place(dedup->entries, dedup->size, &entry);
+    dedup->count++;
+}
+
+static void* _Dedup_Find(GenericDedup *dedup, GenericType *value);
+
+/**
+ * 以登記過的相同節點取代值
+ */
+static void _Dedup_Replace(GenericDedup *dedup, GenericType *value, void *found)
+{
+    dedup->bytes_saved += _Tree_Bytes(value);
+    dedup->shared_count++;
+    if (GenericType_IsType(value, GEN_TYPE_TABLE))
+        GenericType_Set_Table(value, GenericTable_Retain((GenericTable*) found));
+    else
+        GenericType_Set_List(value, GenericList_Retain((GenericList*) found));
+}
+
+static void _Dedup_Value(GenericType *value, void *arg)
+{
+    GenericDedup *dedup = (GenericDedup*) arg;
+    void *found = _Dedup_Find(dedup, value);
+    if (found) _Dedup_Replace(dedup, value, found);
+}
+
+static void _Dedup_Children(GenericDedup *dedup, GenericTypeEnum type, void *node)
+{
+    if (type == GEN_TYPE_TABLE)
+    {
+        GenericTable_ForEachValue((GenericTable*) node, _Dedup_Value, dedup);
+        return;
+    }
+    GenericList *list = (GenericList*) node;
+    int size = GenericList_Size(list);
+    for (int i = 0; i < size; i++)
+    {
+        // 只有要取代時才取得可修改的元素，其餘元素不必複製
+        void *found = _Dedup_Find(dedup, GenericList_Get(list, i));
+        if (found) _Dedup_Replace(dedup, GenericList_At(list, i), found);
+    }
+}
+
+/**
+ * 值為映射表、動態陣列時，回傳登記過的相同節點，由呼叫端取代，
+ * 找不到時先去重其中的子容器再登記並回傳 NULL，整個子樹都有相同的節點時直接取代，不必走訪子樹
+ */
+static void* _Dedup_Find(GenericDedup *dedup, GenericType *value)
+{
+    GenericTypeEnum type = GenericType_GetType(value);
+    void *node;
+    if (type == GEN_TYPE_TABLE)
+        node = GenericType_GetTable(value);
+    else if (type == GEN_TYPE_LIST)
+        node = GenericType_GetList(value);
+    else
+        return NULL;
+    if (_Node_Arena(type, node)) return NULL;
+
+    // 子樹的雜湊值記在每個容器上，取代子容器不改變內容，登記時沿用同一個值
+    uint64_t hash = GenericType_Hash(value);
+    void *found = _Lookup(dedup, type, node, hash);
+    if (found == node) return NULL;
+    if (!found)
+    {
+        _Dedup_Children(dedup, type, node);
+        _Register(dedup, type, node, hash);
+    }
+    return found;
+}
+
+/**
+ * 快照中不可修改容器樹
+ */
+static bool _CanDedup(void)
+{
+    if (!CowUtil_ReadGeneration()) return true;
+
+    s_out_err("GenericDedup can not be used inside a snapshot");
+    return false;
+}
+
+// ================================================================================
+// Public properties
+// ================================================================================
+GenericDedup* New_GenericDedup(void)
+{
+    GenericDedup *dedup = (GenericDedup*) malloc(sizeof(GenericDedup));
+    dedup->entries = (_DedupEntry*) calloc(_DEFAULT_SIZE, sizeof(_DedupEntry));
+    dedup->size = _DEFAULT_SIZE;
+    dedup->count = 0;
+    dedup->bytes_saved = 0;
+    dedup->shared_count = 0;
+    return dedup;
+}
+
+void Delete_GenericDedup(GenericDedup **p_dedup)
+{
+    GenericDedup *dedup = *p_dedup;
+    if (!dedup) return;
+
+    for (int i = 0; i < dedup->size; i++)
+    {
+        _DedupEntry *entry = &(dedup->entries[i]);
+        if (entry->node) _Release_Node(entry->type, entry->node);
+    }
+    free(dedup->entries);
+    free(dedup);
+    *p_dedup = NULL;
+}
+
+size_t GenericDedup_Table(GenericDedup *dedup, GenericTable *table)
+{
+    if (!dedup || !table)
+    {
+        s_out_err("the pointer is null at GenericDedup_Table!");
+        return 0;
+    }
+    if (!_CanDedup() || GenericTable_GetArena(table)) return 0;
+
+    size_t before = dedup->bytes_saved;
+    GenericTable_ForEachValue(table, _Dedup_Value, dedup);
+    return dedup->bytes_saved - before;
+}
+
+size_t GenericDedup_List(GenericDedup *dedup, GenericList *list)
+{
+    if (!dedup || !list)
+    {
+        s_out_err("the pointer is null at GenericDedup_List!");
+        return 0;
+    }
+    if (!_CanDedup() || GenericList_GetArena(list)) return 0;
+
+    size_t before = dedup->bytes_saved;
+    _Dedup_Children(dedup, GEN_TYPE_LIST, list);
+    return dedup->bytes_saved - before;
+}
+
+size_t GenericDedup_BytesSaved(GenericDedup *dedup)
+{
+    return dedup->bytes_saved;
+}
+
+int GenericDedup_SharedCount(GenericDedup *dedup)
+{
+    return dedup->shared_count;
+}
+
+int GenericDedup_UniqueCount(GenericDedup *dedup)
+{
+    return dedup->count;
+}
@@ -1,11 +1,16 @@
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 
 #include "../include/generic_list.h"
 #include "../include/string_builder.h"
 #include "../include/common_util.h"
 #include "../include/generic_type.h"
 #include "../include/number_util.h"
+#include "../include/generic_arena.h"
+#include "../include/cow_util.h"
+#include "../include/generic_pool.h"
+#include "../include/hash_util.h"
 
 // ================================================================================
 // Private Properties
@@ -24,16 +29,55 @@ struct GenericList
     int next;
     int max_size;
     GenericType **elements;
+    /**
+     * 配置動態陣列與其元素的 arena，NULL 代表以 malloc 配置
+     */
+    GenericArena *arena;
+    /**
+     * 快照的版本狀態，elements_shared 為 true 時 elements 仍與凍結的版本共用，修改前須先複製
+     */
+    CowUtil_State cow;
+    bool elements_shared;
+    /**
+     * 元素共用的環境：arena 與版本狀態
+     */
+    GenericTypeContext context;
+    /**
+     * 凍結的版本，只供快照讀取
+     */
+    bool is_version;
+    /**
+     * 參考計數，歸零時才真正解構
+     */
+    atomic_int refs;
 };
 
-static GenericList* _New_GenericList(int init_size)
+/**
+ * 不在 arena 中的容器從池配置，凍結的版本仍以 malloc 配置
+ */
+static GenericPool _pool = GENERIC_POOL_INIT(sizeof(GenericList));
+
+static GenericType** _New_Elements(GenericList *list, int size)
 {
-    GenericList *list = (GenericList*) malloc(sizeof(GenericList));
+    if (!list->arena) return (GenericType**) calloc(size, sizeof(GenericType*));
+    return (GenericType**) GenericArena_Calloc(list->arena, size * sizeof(GenericType*));
+}
+
+static GenericList* _New_GenericList(GenericArena *arena, int init_size)
+{
+    GenericList *list = arena
+        ? (GenericList*) GenericArena_Alloc(arena, sizeof(GenericList))
+        : (GenericList*) GenericPool_Alloc(&_pool);
     list->next = 0;
     list->max_size = init_size;
-
-    GenericType **elements = (GenericType**) calloc(init_size, sizeof(GenericType*));
-    list->elements = elements;
+    list->arena = arena;
+    list->elements = _New_Elements(list, init_size);
+    CowUtil_Init(&(list->cow));
+    list->elements_shared = false;
+    list->context.arena = arena;
+    list->context.owner = &(list->cow);
+    list->is_version = false;
+    atomic_init(&(list->refs), 1);
 
     return list;
 }
@@ -47,27 +91,98 @@ static void _EnsureSize(GenericList *list, int num)
 {
     if (!_NeedResize(list, num)) return;
     
-    int curr_max = list->max_size;
-    int new_max = curr_max | (curr_max >> 1);
+    long curr_max = list->max_size;
+    long new_max = curr_max + (curr_max >> 1);
+    if (new_max < list->next + num) new_max = list->next + num;
     if (new_max > NUMBER_UTIL_INT_MAX) 
     {
         s_out("list size is over integer max");
         return;
     }
 
-    GenericType **new_element = (GenericType**) calloc(new_max, sizeof(GenericType*));
+    GenericType **new_element = _New_Elements(list, new_max);
     for (int i = 0; i < list->next; i++) 
     {
         new_element[i] = list->elements[i];
     }
 
-    free(list->elements);
+    if (!list->arena) free(list->elements);
     list->elements = new_element;
     list->max_size = new_max;
 }
 
+static void* _Cow_Freeze(void *owner)
+{
+    GenericList *list = (GenericList*) owner;
+    GenericList *version = (GenericList*) malloc(sizeof(GenericList));
+    memcpy(version, list, sizeof(GenericList));
+    version->is_version = true;
+    list->elements_shared = true;
+    return version;
+}
+
+static void _Cow_Release(void *owner, void *data)
+{
+    GenericList *list = (GenericList*) owner;
+    GenericList *version = (GenericList*) data;
+    if (version->elements == list->elements)
+        list->elements_shared = false;
+    else if (!list->arena)
+        free(version->elements);
+    free(version);
+}
+
+static void _Cow_Drop(void *owner, void *ptr)
+{
+    (void) owner;
+    GenericType *gen = (GenericType*) ptr;
+    Delete_GenericType(&gen);
+}
+
+static const CowUtil_Ops _COW_OPS = { _Cow_Freeze, _Cow_Release, _Cow_Drop };
+
+/**
+ * 快照中讀取時改讀快照當下的版本
+ */
+static GenericList* _ReadList(GenericList *list)
+{
+    uint64_t generation = CowUtil_ReadGeneration();
+    if (!generation || list->is_version) return list;
+
+    GenericList *version = (GenericList*) CowUtil_Resolve(&(list->cow), &_COW_OPS, list, generation);
+    return version ? version : list;
+}
+
+/**
+ * 修改動態陣列前呼叫：快照中不可修改，elements 仍與凍結的版本共用時先複製一份
+ */
+static bool _BeginModify(GenericList *list)
+{
+    if (CowUtil_ReadGeneration())
+    {
+        s_out_err("GenericList is read only inside a snapshot");
+        return false;
+    }
+    CowUtil_PrepareWrite(&(list->cow), &_COW_OPS, list);
+    CowUtil_MarkModified(&(list->cow));
+    if (list->elements_shared)
+    {
+        GenericType **elements = _New_Elements(list, list->max_size);
+        memcpy(elements, list->elements, (size_t) list->next * sizeof(GenericType*));
+        list->elements = elements;
+        list->elements_shared = false;
+    }
+    return true;
+}
+
 static void _AddSingle(GenericList *list, GenericType *gen)
 {
+    if (!_BeginModify(list))
+    {
+        Delete_GenericType(&gen);
+        return;
+    }
+    GenericType_SetOwner(gen, &(list->context), list->cow.epoch);
     _EnsureSize(list, 1);
     list->elements[list->next] = gen;
     list->next++;
@@ -88,75 +203,177 @@ static void _AddAll(GenericList *list, GenericType **gen_list, int gen_count)
 // ================================================================================
 GenericList* New_GenericList()
 {
-    return _New_GenericList(DEFAULT_SIZE);
+    return _New_GenericList(NULL, DEFAULT_SIZE);
+}
+
+GenericList* New_GenericList_InArena(GenericArena *arena)
+{
+    return _New_GenericList(arena, DEFAULT_SIZE);
+}
+
+GenericArena* GenericList_GetArena(GenericList *list)
+{
+    return list->arena;
+}
+
+GenericList* GenericList_Retain(GenericList *list)
+{
+    atomic_fetch_add(&(list->refs), 1);
+    return list;
+}
+
+CowUtil_State* GenericList_GetCowState(GenericList *list)
+{
+    return &(list->cow);
 }
 
 void Delete_GenericList(GenericList **p_list)
 {
     GenericList *list = *p_list;
-    for (int i = 0; i < list->next; i++)
+    *p_list = NULL;
+    if (atomic_fetch_sub(&(list->refs), 1) > 1) return;
+
+    CowUtil_Destroy(&(list->cow), &_COW_OPS, list);
+    // arena 中的動態陣列隨 arena 一起釋放
+    if (!list->arena)
     {
-        Delete_GenericType(&(list->elements[i]));
+        for (int i = 0; i < list->next; i++)
+        {
+            Delete_GenericType(&(list->elements[i]));
+        }
+        free(list->elements);
+        GenericPool_Free(&_pool, list);
     }
-    free(list->elements);
-    free(list);
-    *p_list = NULL;
 }
 
 GenericType* GenericList_At(GenericList *list, int index)
 {
-    return list->elements[index];
+    if (CowUtil_ReadGeneration()) return GenericList_Get(list, index);
+
+    // 回傳的元素可以就地修改，仍與快照共用時先換成複製的元素
+    CowUtil_PrepareWrite(&(list->cow), &_COW_OPS, list);
+    CowUtil_InvalidateHash(&(list->cow));
+    GenericType *gen = list->elements[index];
+    if (!CowUtil_IsShared(&(list->cow), GenericType_GetEpoch(gen))) return gen;
+
+    _BeginModify(list);
+    GenericType *copy = GenericType_Clone(gen);
+    GenericType_SetOwner(copy, &(list->context), list->cow.epoch);
+    list->elements[index] = copy;
+    CowUtil_Retire(&(list->cow), &_COW_OPS, list, gen, GenericType_GetEpoch(gen));
+    return copy;
+}
+
+GenericType* GenericList_Get(GenericList *list, int index)
+{
+    return _ReadList(list)->elements[index];
 }
 
 int GenericList_Size(GenericList *list)
 {
-    return list->next;
+    return _ReadList(list)->next;
 }
 
 bool GenericList_IsEmpty(GenericList *list)
 {
-    return list->next == 0;
+    return _ReadList(list)->next == 0;
+}
+
+size_t GenericList_BytesUsed(GenericList *list)
+{
+    list = _ReadList(list);
+    return sizeof(GenericList) + (size_t) list->max_size * sizeof(GenericType*) + (size_t) list->next * GenericType_Sizeof();
+}
+
+uint64_t GenericList_Hash(GenericList *list)
+{
+    if (!list)
+    {
+        s_out_err("the GenericList pointer is null at GenericList_Hash!");
+        return 0;
+    }
+    // 快照中讀取的是凍結的版本，不記下雜湊值
+    bool cacheable = !CowUtil_ReadGeneration();
+    list = _ReadList(list);
+    uint64_t hash = cacheable ? CowUtil_CachedHash(&(list->cow)) : 0;
+    if (hash) return hash;
+
+    // 依序混合，元素順序不同時雜湊值不同
+    hash = (uint64_t) list->next;
+    for (int i = 0; i < list->next; i++)
+    {
+        hash = HashUtil_Mix(hash, GenericType_Hash(list->elements[i]));
+    }
+    if (!hash) hash = 1;
+    if (cacheable) CowUtil_SetCachedHash(&(list->cow), hash);
+    return hash;
+}
+
+bool GenericList_Equals(GenericList *list1, GenericList *list2)
+{
+    if (!list1 || !list2)
+    {
+        s_out_err("the GenericList pointer is null at GenericList_Equals!");
+        return false;
+    }
+    if (list1 == list2) return true;
+
+    list1 = _ReadList(list1);
+    list2 = _ReadList(list2);
+    if (list1->next != list2->next) return false;
+    if (!CowUtil_ReadGeneration())
+    {
+        uint64_t hash1 = CowUtil_CachedHash(&(list1->cow));
+        uint64_t hash2 = CowUtil_CachedHash(&(list2->cow));
+        if (hash1 && hash2 && hash1 != hash2) return false;
+    }
+
+    for (int i = 0; i < list1->next; i++)
+    {
+        if (!GenericType_Equals(list1->elements[i], list2->elements[i])) return false;
+    }
+    return true;
 }
 
 void GenericList_Add_Str(GenericList *list, char *val)
 {
-    GenericType *gen = New_GenericType(val);
+    GenericType *gen = list->arena ? New_GenericType_InArena(list->arena, GEN_TYPE_STR, val) : New_GenericType(val);
     _AddSingle(list, gen);
 }
 
 void GenericList_Add_Int(GenericList *list, int val)
 {
-    GenericType *gen = New_GenericType(val);
+    GenericType *gen = list->arena ? New_GenericType_InArena(list->arena, GEN_TYPE_INT, &val) : New_GenericType(val);
     _AddSingle(list, gen);
 }
 
 void GenericList_Add_Long(GenericList *list, long val)
 {
-    GenericType *gen = New_GenericType(val);
+    GenericType *gen = list->arena ? New_GenericType_InArena(list->arena, GEN_TYPE_LONG, &val) : New_GenericType(val);
     _AddSingle(list, gen);
 }
 
 void GenericList_Add_Float(GenericList *list, float val)
 {
-    GenericType *gen = New_GenericType(val);
+    GenericType *gen = list->arena ? New_GenericType_InArena(list->arena, GEN_TYPE_FLOAT, &val) : New_GenericType(val);
     _AddSingle(list, gen);
 }
 
 void GenericList_Add_Double(GenericList *list, double val)
 {
-    GenericType *gen = New_GenericType(val);
+    GenericType *gen = list->arena ? New_GenericType_InArena(list->arena, GEN_TYPE_DOUBLE, &val) : New_GenericType(val);
     _AddSingle(list, gen);
 }
 
 void GenericList_Add_Table(GenericList *list, GenericTable *val)
 {
-    GenericType *gen = New_GenericType(val);
+    GenericType *gen = list->arena ? New_GenericType_InArena(list->arena, GEN_TYPE_TABLE, val) : New_GenericType(val);
     _AddSingle(list, gen);
 }
 
 void GenericList_Add_List(GenericList *list, GenericList *val)
 {
-    GenericType *gen = New_GenericType(val);
+    GenericType *gen = list->arena ? New_GenericType_InArena(list->arena, GEN_TYPE_LIST, val) : New_GenericType(val);
     _AddSingle(list, gen);
 }
 
@@ -167,9 +384,10 @@ bool GenericList_DeleteAt(GenericList *list, int index)
         s_out_err_f("index '%d' is out of bound '%d'", index, list->next);
         return false;
     }
+    if (!_BeginModify(list)) return false;
 
     GenericType *gen = list->elements[index];
-    Delete_GenericType(&gen);
+    CowUtil_Retire(&(list->cow), &_COW_OPS, list, gen, GenericType_GetEpoch(gen));
     if (index == list->next - 1) 
     {
         list->next--;
@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "../include/common_util.h"
+#include "../include/generic_pool.h"
+
+// ================================================================================
+// Private Properties
+// ================================================================================
+#if !defined(GENERIC_POOL_DISABLE)
+
+static const size_t _SLAB_SIZE = 0x10000;
+
+// slab 開頭保留給串接指標的大小，物件從此處開始，維持 16 個位元組對齊
+#define _SLAB_HEADER 16
+
+// 池的數量上限，每個執行緒為每個池保留一個 free list
+#define _MAX_POOLS 16
+
+// 執行緒的 free list 與池交換的物件數量，free list 超過兩倍時交還一批
+#define _BATCH 0x40
+
+typedef struct _PoolNode
+{
+    struct _PoolNode *next;
+} _PoolNode;
+
+typedef struct _PoolCache
+{
+    _PoolNode *head;
+    int count;
+} _PoolCache;
+
+static GenericPool *_pools[_MAX_POOLS + 1];
+
+static int _pool_count = 0;
+
+static pthread_mutex_t _registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t _key_once = PTHREAD_ONCE_INIT;
+
+/**
+ * 只用來在執行緒結束時交還 free list，值沒有意義
+ */
+static pthread_key_t _thread_key;
+
+static _Thread_local _PoolCache _caches[_MAX_POOLS + 1];
+
+static _Thread_local bool _thread_registered = false;
+
+/**
+ * 物件至少要放得下串接指標，並對齊指標
+ */
+static inline size_t _ObjectSize(GenericPool *pool)
+{
+    size_t size = pool->object_size < sizeof(_PoolNode) ? sizeof(_PoolNode) : pool->object_size;
+    return (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+}
+
+static int _PoolId(GenericPool *pool)
+{
+    int id = atomic_load_explicit(&(pool->id), memory_order_acquire);
+    if (id) return id;
+
+    pthread_mutex_lock(&_registry_lock);
+    id = atomic_load(&(pool->id));
+    if (!id)
+    {
+        if (_pool_count < _MAX_POOLS)
+        {
+            id = ++_pool_count;
+            _pools[id] = pool;
+        }
+        else
+        {
+            s_out_err("GenericPool count is over the limit, fallback to malloc");
+            id = -1;
+        }
+        atomic_store_explicit(&(pool->id), id, memory_order_release);
+    }
+    pthread_mutex_unlock(&_registry_lock);
+    return id;
+}
+
+/**
+ * 把 head 開始的 count 個物件交還給池，tail 為最後一個
+ */
+static void _Give(GenericPool *pool, _PoolNode *head, _PoolNode *tail, int count)
+{
+    pthread_mutex_lock(&(pool->lock));
+    tail->next = (_PoolNode*) pool->free_list;
+    pool->free_list = head;
+    pool->free_count += count;
+    pthread_mutex_unlock(&(pool->lock));
+}
+
+static void _FlushThread(void *unused)
+{
+    (void) unused;
+    pthread_mutex_lock(&_registry_lock);
+    int pool_count = _pool_count;
+    pthread_mutex_unlock(&_registry_lock);
+
+    for (int id = 1; id <= pool_count; id++)
+    {
+        _PoolCache *cache = &(_caches[id]);
+        if (!cache->head) continue;
+
+        _PoolNode *tail = cache->head;
+        while (tail->next) tail = tail->next;
+        _Give(_pools[id], cache->head, tail, cache->count);
+        cache->head = NULL;
+        cache->count = 0;
+    }
+}
+
+static void _CreateKey(void)
+{
+    pthread_key_create(&_thread_key, _FlushThread);
+}
+
+/**
+ * 登記執行緒結束時交還 free list，主執行緒隨行程結束，不需交還
+ */
+static inline void _RegisterThread(void)
+{
+    if (_thread_registered) return;
+
+    pthread_once(&_key_once, _CreateKey);
+    pthread_setspecific(_thread_key, (void*) 1);
+    _thread_registered = true;
+}
+
+/**
+ * 執行緒的 free list 用完時，從池取回一批，池也沒有時切一個新的 slab
+ */
+static void _Refill(GenericPool *pool, _PoolCache *cache)
+{
+    _RegisterThread();
+    pthread_mutex_lock(&(pool->lock));
+    if (pool->free_count)
+    {
+        _PoolNode *head = (_PoolNode*) pool->free_list;
+        _PoolNode *tail = head;
+        int count = 1;
+        while (count < _BATCH && tail->next)
+        {
+            tail = tail->next;
+            count++;
+        }
+        pool->free_list = tail->next;
+        pool->free_count -= count;
+        tail->next = cache->head;
+        cache->head = head;
+        cache->count += count;
+        pthread_mutex_unlock(&(pool->lock));
+        return;
+    }
+
+    char *slab = (char*) malloc(_SLAB_SIZE);
+    if (!slab)
+    {
+        pthread_mutex_unlock(&(pool->lock));
+        s_out_err("malloc GenericPool slab failed");
+        return;
+    }
+    *(void**) slab = pool->slabs;
+    pool->slabs = slab;
+    pool->bytes_reserved += _SLAB_SIZE;
+    pthread_mutex_unlock(&(pool->lock));
+
+    size_t size = _ObjectSize(pool);
+    int count = (int) ((_SLAB_SIZE - _SLAB_HEADER) / size);
+    for (int i = count - 1; i >= 0; i--)
+    {
+        _PoolNode *node = (_PoolNode*) (slab + _SLAB_HEADER + (size_t) i * size);
+        node->next = cache->head;
+        cache->head = node;
+    }
+    cache->count += count;
+}
+
+#endif
+
+// ================================================================================
+// Public properties
+// ================================================================================
+#if defined(GENERIC_POOL_DISABLE)
+
+void* GenericPool_Alloc(GenericPool *pool)
+{
+    return malloc(pool->object_size);
+}
+
+void GenericPool_Free(GenericPool *pool, void *ptr)
+{
+    (void) pool;
+    free(ptr);
+}
+
+#else
+
+void* GenericPool_Alloc(GenericPool *pool)
+{
+    int id = _PoolId(pool);
+    if (id < 0) return malloc(pool->object_size);
+
+    _PoolCache *cache = &(_caches[id]);
+    if (!cache->head)
+    {
+        _Refill(pool, cache);
+        if (!cache->head) return NULL;
+    }
+    _PoolNode *node = cache->head;
+    cache->head = node->next;
+    cache->count--;
+    return node;
+}
+
+void GenericPool_Free(GenericPool *pool, void *ptr)
+{
+    if (!ptr) return;
+
+    int id = _PoolId(pool);
+    if (id < 0)
+    {
+        free(ptr);
+        return;
+    }
+
+    _RegisterThread();
+    _PoolCache *cache = &(_caches[id]);
+    _PoolNode *node = (_PoolNode*) ptr;
+    node->next = cache->head;
+    cache->head = node;
+    cache->count++;
+    if (cache->count < 2 * _BATCH) return;
+
+    // 只釋放不配置的執行緒(例如專門解構的執行緒)不會無限累積
+    _PoolNode *tail = node;
+    for (int i = 1; i < _BATCH; i++) tail = tail->next;
+    cache->head = tail->next;
+    cache->count -= _BATCH;
+    _Give(pool, node, tail, _BATCH);
+}
+
+#endif
+
+size_t GenericPool_BytesReserved(GenericPool *pool)
+{
+    pthread_mutex_lock(&(pool->lock));
+    size_t bytes = pool->bytes_reserved;
+    pthread_mutex_unlock(&(pool->lock));
+    return bytes;
+}
@@ -0,0 +1,350 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "../include/generic_read_mostly_table.h"
+#include "../include/generic_table.h"
+#include "../include/generic_type.h"
+#include "../include/common_util.h"
+#include "../include/hash_util.h"
+#include "../include/epoch_util.h"
+
+// ================================================================================
+// Private Properties
+// ================================================================================
+static const int _DEFAULT_SIZE = 0x20;
+
+static const int _DEFAULT_LOAD_FACTOR = 0x40;
+
+/**
+ * 發布後就不再修改的映射物件，更新時以新的映射物件整個取代
+ */
+typedef struct _ReadMostlyItem
+{
+    uint64_t hash;
+    int key_len;
+    char *key;
+    GenericType *value;
+} _ReadMostlyItem;
+
+/**
+ * 線性探測的容器，大小為 2 的次方，
+ * used 為佔用的位置(含已刪除標記)，只有寫入端會讀寫
+ */
+typedef struct _ReadMostlyBucket
+{
+    int size;
+    int used;
+    _Atomic(_ReadMostlyItem*) slots[];
+} _ReadMostlyBucket;
+
+struct GenericReadMostlyTable
+{
+    pthread_mutex_t write_lock;
+    _Atomic(_ReadMostlyBucket*) bucket;
+    _Atomic int item_count;
+    int load_factor;
+    GenericTableHashFn hash_fn;
+    uint64_t seed;
+};
+
+/**
+ * 已刪除標記，查找時跳過，新增時可重複使用
+ */
+static _ReadMostlyItem _TOMBSTONE;
+
+static _ReadMostlyBucket* _New_Bucket(int size)
+{
+    _ReadMostlyBucket *bucket = (_ReadMostlyBucket*) malloc(sizeof(_ReadMostlyBucket) + sizeof(_ReadMostlyItem*) * size);
+    bucket->size = size;
+    bucket->used = 0;
+    for (int i = 0; i < size; i++) atomic_init(&(bucket->slots[i]), NULL);
+    return bucket;
+}
+
+static void _Free_Item(void *ptr)
+{
+    _ReadMostlyItem *item = (_ReadMostlyItem*) ptr;
+    free(item->key);
+    Delete_GenericType(&(item->value));
+    free(item);
+}
+
+static _ReadMostlyItem* _New_Item(GenericReadMostlyTable *table, const char *key, GenericType *value)
+{
+    _ReadMostlyItem *item = (_ReadMostlyItem*) malloc(sizeof(_ReadMostlyItem));
+    item->key_len = strlen(key);
+    item->hash = table->hash_fn(key, item->key_len, table->seed);
+    item->key = strdup(key);
+    item->value = value;
+    return item;
+}
+
+static inline bool _IsSameKey(_ReadMostlyItem *item, uint64_t hash, const char *key, int key_len)
+{
+    return item->hash == hash && item->key_len == key_len && memcmp(item->key, key, key_len) == 0;
+}
+
+/**
+ * 查找 key 對應的映射物件與位置，不存在時回傳 NULL，
+ * 讀取端與寫入端共用，讀取端必須在讀取區段中呼叫，
+ * 讀取端只能使用回傳的映射物件，位置可能已被寫入端重複使用
+ */
+static _ReadMostlyItem* _FindItem(_ReadMostlyBucket *bucket, uint64_t hash, const char *key, int key_len, int *out_index)
+{
+    int mask = bucket->size - 1;
+    int index = hash & mask;
+    for (int i = 0; i < bucket->size; i++)
+    {
+        _ReadMostlyItem *item = atomic_load_explicit(&(bucket->slots[index]), memory_order_acquire);
+        if (!item) return NULL;
+        if (item != &_TOMBSTONE && _IsSameKey(item, hash, key, key_len))
+        {
+            if (out_index) *out_index = index;
+            return item;
+        }
+        index = (index + 1) & mask;
+    }
+    return NULL;
+}
+
+/**
+ * 只有寫入端呼叫，回傳第一個空位或已刪除標記
+ */
+static int _FreeIndex(_ReadMostlyBucket *bucket, uint64_t hash)
+{
+    int mask = bucket->size - 1;
+    int index = hash & mask;
+    while (true)
+    {
+        _ReadMostlyItem *item = atomic_load_explicit(&(bucket->slots[index]), memory_order_relaxed);
+        if (!item || item == &_TOMBSTONE) return index;
+        index = (index + 1) & mask;
+    }
+}
+
+/**
+ * 佔用的位置超過負載係數時，建立新的容器搬入所有映射物件後再發布，
+ * 映射物件本身直接沿用，舊容器延後釋放，讀取端讀到新舊容器都能正確查找
+ */
+static _ReadMostlyBucket* _EnsureBucketSize(GenericReadMostlyTable *table, _ReadMostlyBucket *bucket)
+{
+    if ((long) (bucket->used + 1) * 100 <= (long) bucket->size * table->load_factor) return bucket;
+
+    int size = bucket->size;
+    int item_count = atomic_load_explicit(&(table->item_count), memory_order_relaxed);
+    // 已刪除標記太多時，以相同大小重建即可清除
+    if ((long) (item_count + 1) * 200 > (long) size * table->load_factor) size <<= 1;
+
+    _ReadMostlyBucket *new_bucket = _New_Bucket(size);
+    for (int i = 0; i < bucket->size; i++)
+    {
+        _ReadMostlyItem *item = atomic_load_explicit(&(bucket->slots[i]), memory_order_relaxed);
+        if (!item || item == &_TOMBSTONE) continue;
+        int index = _FreeIndex(new_bucket, item->hash);
+        atomic_store_explicit(&(new_bucket->slots[index]), item, memory_order_relaxed);
+        new_bucket->used++;
+    }
+    atomic_store_explicit(&(table->bucket), new_bucket, memory_order_release);
+    EpochUtil_RetireOwned(table, bucket, free);
+    return new_bucket;
+}
+
+static void _AddItem(GenericReadMostlyTable *table, const char *key, GenericType *value)
+{
+    pthread_mutex_lock(&(table->write_lock));
+    _ReadMostlyItem *new_item = _New_Item(table, key, value);
+    _ReadMostlyBucket *bucket = atomic_load_explicit(&(table->bucket), memory_order_relaxed);
+    int index;
+    if (_FindItem(bucket, new_item->hash, key, new_item->key_len, &index))
+    {
+        _ReadMostlyItem *old_item = atomic_exchange_explicit(&(bucket->slots[index]), new_item, memory_order_acq_rel);
+        EpochUtil_RetireOwned(table, old_item, _Free_Item);
+    }
+    else
+    {
+        bucket = _EnsureBucketSize(table, bucket);
+        index = _FreeIndex(bucket, new_item->hash);
+        if (!atomic_load_explicit(&(bucket->slots[index]), memory_order_relaxed)) bucket->used++;
+        atomic_store_explicit(&(bucket->slots[index]), new_item, memory_order_release);
+        atomic_fetch_add_explicit(&(table->item_count), 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&(table->write_lock));
+}
+
+// ================================================================================
+// Public properties
+// ================================================================================
+GenericReadMostlyTable* New_GenericReadMostlyTable(void)
+{
+    return New_GenericReadMostlyTable_WithOptions(NULL);
+}
+
+GenericReadMostlyTable* New_GenericReadMostlyTable_WithOptions(const GenericTableOptions *options)
+{
+    GenericTableOptions opts = options ? *options : GenericTable_DefaultOptions();
+    int size = _DEFAULT_SIZE;
+    while (size < opts.bucket_size) size <<= 1;
+
+    GenericReadMostlyTable *table = (GenericReadMostlyTable*) malloc(sizeof(GenericReadMostlyTable));
+    pthread_mutex_init(&(table->write_lock), NULL);
+    atomic_init(&(table->bucket), _New_Bucket(size));
+    atomic_init(&(table->item_count), 0);
+    table->load_factor = opts.load_factor > 0 && opts.load_factor < 100 ? opts.load_factor : _DEFAULT_LOAD_FACTOR;
+    table->hash_fn = opts.hash_fn ? opts.hash_fn : HashUtil_WyHash;
+    table->seed = opts.seed;
+    return table;
+}
+
+void Delete_GenericReadMostlyTable(GenericReadMostlyTable **p_table)
+{
+    GenericReadMostlyTable *table = *p_table;
+    if (!table) return;
+
+    _ReadMostlyBucket *bucket = atomic_load(&(table->bucket));
+    for (int i = 0; i < bucket->size; i++)
+    {
+        _ReadMostlyItem *item = atomic_load_explicit(&(bucket->slots[i]), memory_order_relaxed);
+        if (item && item != &_TOMBSTONE) _Free_Item(item);
+    }
+    free(bucket);
+    // 已沒有讀取端在使用這個映射表，延後釋放的舊容器與映射物件可以直接釋放，不必等其他映射表的讀取端
+    EpochUtil_FreeOwned(table);
+    pthread_mutex_destroy(&(table->write_lock));
+    free(table);
+    *p_table = NULL;
+}
+
+void GenericReadMostlyTable_Add_Str(GenericReadMostlyTable *table, const char *key, const char *value)
+{
+    _AddItem(table, key, New_GenericType(value));
+}
+
+void GenericReadMostlyTable_Add_Int(GenericReadMostlyTable *table, const char *key, int value)
+{
+    _AddItem(table, key, New_GenericType(value));
+}
+
+void GenericReadMostlyTable_Add_Long(GenericReadMostlyTable *table, const char *key, long value)
+{
+    _AddItem(table, key, New_GenericType(value));
+}
+
+void GenericReadMostlyTable_Add_Double(GenericReadMostlyTable *table, const char *key, double value)
+{
+    _AddItem(table, key, New_GenericType(value));
+}
+
+void GenericReadMostlyTable_Add_Float(GenericReadMostlyTable *table, const char *key, float value)
+{
+    _AddItem(table, key, New_GenericType(value));
+}
+
+void GenericReadMostlyTable_Add_Table(GenericReadMostlyTable *table, const char *key, GenericTable *value)
+{
+    _AddItem(table, key, New_GenericType(value));
+}
+
+void GenericReadMostlyTable_Add_List(GenericReadMostlyTable *table, const char *key, struct GenericList *value)
+{
+    _AddItem(table, key, New_GenericType(value));
+}
+
+void GenericReadMostlyTable_Delete(GenericReadMostlyTable *table, const char *key)
+{
+    pthread_mutex_lock(&(table->write_lock));
+    _ReadMostlyBucket *bucket = atomic_load_explicit(&(table->bucket), memory_order_relaxed);
+    int key_len = strlen(key);
+    int index;
+    if (_FindItem(bucket, table->hash_fn(key, key_len, table->seed), key, key_len, &index))
+    {
+        _ReadMostlyItem *old_item = atomic_exchange_explicit(&(bucket->slots[index]), &_TOMBSTONE, memory_order_acq_rel);
+        atomic_fetch_sub_explicit(&(table->item_count), 1, memory_order_relaxed);
+        EpochUtil_RetireOwned(table, old_item, _Free_Item);
+    }
+    pthread_mutex_unlock(&(table->write_lock));
+}
+
+void GenericReadMostlyTable_ReadBegin(GenericReadMostlyTable *table)
+{
+    (void) table;
+    EpochUtil_Enter();
+}
+
+void GenericReadMostlyTable_ReadEnd(GenericReadMostlyTable *table)
+{
+    (void) table;
+    EpochUtil_Exit();
+}
+
+GenericType* GenericReadMostlyTable_Find(GenericReadMostlyTable *table, const char *key)
+{
+    _ReadMostlyBucket *bucket = atomic_load_explicit(&(table->bucket), memory_order_acquire);
+    int key_len = strlen(key);
+    _ReadMostlyItem *item = _FindItem(bucket, table->hash_fn(key, key_len, table->seed), key, key_len, NULL);
+    return item ? item->value : NULL;
+}
+
+char* GenericReadMostlyTable_Find_Str(GenericReadMostlyTable *table, const char *key)
+{
+    EpochUtil_Enter();
+    GenericType *value = GenericReadMostlyTable_Find(table, key);
+    const char *str = value ? GenericType_GetStr(value) : NULL;
+    char *copy = str ? strdup(str) : NULL;
+    EpochUtil_Exit();
+    return copy;
+}
+
+bool GenericReadMostlyTable_Find_Int(GenericReadMostlyTable *table, const char *key, int *out)
+{
+    EpochUtil_Enter();
+    GenericType *value = GenericReadMostlyTable_Find(table, key);
+    int *val = value ? GenericType_GetInt(value) : NULL;
+    if (val) *out = *val;
+    EpochUtil_Exit();
+    return val != NULL;
+}
+
+bool GenericReadMostlyTable_Find_Long(GenericReadMostlyTable *table, const char *key, long *out)
+{
+    EpochUtil_Enter();
+    GenericType *value = GenericReadMostlyTable_Find(table, key);
+    long *val = value ? GenericType_GetLong(value) : NULL;
+    if (val) *out = *val;
+    EpochUtil_Exit();
+    return val != NULL;
+}
+
+bool GenericReadMostlyTable_Find_Double(GenericReadMostlyTable *table, const char *key, double *out)
+{
+    EpochUtil_Enter();
+    GenericType *value = GenericReadMostlyTable_Find(table, key);
+    double *val = value ? GenericType_GetDouble(value) : NULL;
+    if (val) *out = *val;
+    EpochUtil_Exit();
+    return val != NULL;
+}
+
+bool GenericReadMostlyTable_Find_Float(GenericReadMostlyTable *table, const char *key, float *out)
+{
+    EpochUtil_Enter();
+    GenericType *value = GenericReadMostlyTable_Find(table, key);
+    float *val = value ? GenericType_GetFloat(value) : NULL;
+    if (val) *out = *val;
+    EpochUtil_Exit();
+    return val != NULL;
+}
+
+bool GenericReadMostlyTable_HasKey(GenericReadMostlyTable *table, const char *key)
+{
+    EpochUtil_Enter();
+    bool has_key = GenericReadMostlyTable_Find(table, key) != NULL;
+    EpochUtil_Exit();
+    return has_key;
+}
+
+int GenericReadMostlyTable_Size(GenericReadMostlyTable *table)
+{
+    return atomic_load_explicit(&(table->item_count), memory_order_relaxed);
+}
@@ -0,0 +1,222 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "../include/common_util.h"
+#include "../include/hash_util.h"
+#include "../include/generic_string.h"
+
+// ================================================================================
+// Private Properties
+// ================================================================================
+struct GenericString
+{
+    /**
+     * 同一個分片、同一個位置的下一個字串
+     */
+    struct GenericString *next;
+    uint64_t hash;
+    atomic_int refs;
+    int len;
+    char chars[];
+};
+
+/**
+ * 字串池的一個分片，以雜湊值的高位元選擇分片，低位元選擇位置，同一個位置的字串以 next 串接
+ */
+typedef struct _InternShard
+{
+    pthread_mutex_t lock;
+    GenericString **buckets;
+    /**
+     * 位置數量，2 的次方
+     */
+    size_t size;
+    size_t count;
+} _InternShard;
+
+// 分片數量的位元數，分片數量為 64
+#define _SHARD_BITS 6
+
+#define _SHARD_COUNT (1 << _SHARD_BITS)
+
+static const size_t _DEFAULT_SIZE = 0X10;
+
+static _InternShard _shards[_SHARD_COUNT];
+
+static pthread_once_t _shards_once = PTHREAD_ONCE_INIT;
+
+static void _InitShards(void)
+{
+    for (int i = 0; i < _SHARD_COUNT; i++)
+    {
+        pthread_mutex_init(&(_shards[i].lock), NULL);
+        _shards[i].buckets = NULL;
+        _shards[i].size = 0;
+        _shards[i].count = 0;
+    }
+}
+
+static inline _InternShard* _ShardOf(uint64_t hash)
+{
+    pthread_once(&_shards_once, _InitShards);
+    return &(_shards[hash >> (64 - _SHARD_BITS)]);
+}
+
+/**
+ * 字串數量超過位置數量時擴充為兩倍，須持有分片的鎖
+ */
+static void _Shard_Grow(_InternShard *shard)
+{
+    size_t size = shard->size ? shard->size * 2 : _DEFAULT_SIZE;
+    GenericString **buckets = (GenericString**) calloc(size, sizeof(GenericString*));
+    if (!buckets)
+    {
+        s_out_err("calloc GenericString buckets failed");
+        return;
+    }
+    for (size_t i = 0; i < shard->size; i++)
+    {
+        GenericString *str = shard->buckets[i];
+        while (str)
+        {
+            GenericString *next = str->next;
+            GenericString **head = &(buckets[str->hash & (size - 1)]);
+            str->next = *head;
+            *head = str;
+            str = next;
+        }
+    }
+    free(shard->buckets);
+    shard->buckets = buckets;
+    shard->size = size;
+}
+
+// ================================================================================
+// Public properties
+// ================================================================================
+uint64_t GenericString_HashOf(const char *str, size_t len)
+{
+    return HashUtil_WyHash(str, len, HashUtil_ProcessSeed());
+}
+
+GenericString* GenericString_Intern(const char *str, size_t len)
+{
+    if (!str)
+    {
+        s_out_err("the string pointer is null at GenericString_Intern!");
+        return NULL;
+    }
+    return GenericString_InternHashed(str, len, GenericString_HashOf(str, len));
+}
+
+GenericString* GenericString_InternHashed(const char *str, size_t len, uint64_t hash)
+{
+    _InternShard *shard = _ShardOf(hash);
+    pthread_mutex_lock(&(shard->lock));
+    if (shard->count >= shard->size) _Shard_Grow(shard);
+    if (!shard->buckets)
+    {
+        pthread_mutex_unlock(&(shard->lock));
+        return NULL;
+    }
+
+    GenericString **head = &(shard->buckets[hash & (shard->size - 1)]);
+    for (GenericString *current = *head; current; current = current->next)
+    {
+        if (current->hash != hash || (size_t) current->len != len || memcmp(current->chars, str, len) != 0) continue;
+
+        // 持有鎖時參考計數不會歸零，找到的字串一定還存活
+        atomic_fetch_add_explicit(&(current->refs), 1, memory_order_relaxed);
+        pthread_mutex_unlock(&(shard->lock));
+        return current;
+    }
+
+    GenericString *created = (GenericString*) malloc(sizeof(GenericString) + len + 1);
+    if (!created)
+    {
+        pthread_mutex_unlock(&(shard->lock));
+        s_out_err("malloc GenericString failed");
+        return NULL;
+    }
+    created->hash = hash;
+    atomic_init(&(created->refs), 1);
+    created->len = (int) len;
+    memcpy(created->chars, str, len);
+    created->chars[len] = '\0';
+    created->next = *head;
+    *head = created;
+    shard->count++;
+    pthread_mutex_unlock(&(shard->lock));
+    return created;
+}
+
+GenericString* GenericString_Retain(GenericString *str)
+{
+    atomic_fetch_add_explicit(&(str->refs), 1, memory_order_relaxed);
+    return str;
+}
+
+void Delete_GenericString(GenericString **p_str)
+{
+    GenericString *str = *p_str;
+    *p_str = NULL;
+    if (!str) return;
+
+    // 不會歸零時不需加鎖
+    int refs = atomic_load_explicit(&(str->refs), memory_order_relaxed);
+    while (refs > 1)
+    {
+        if (atomic_compare_exchange_weak_explicit(&(str->refs), &refs, refs - 1, memory_order_release, memory_order_relaxed)) return;
+    }
+
+    // 可能是最後一個參考，加鎖後再遞減，期間其他執行緒可能從字串池取得同一個字串
+    _InternShard *shard = _ShardOf(str->hash);
+    pthread_mutex_lock(&(shard->lock));
+    if (atomic_fetch_sub_explicit(&(str->refs), 1, memory_order_acq_rel) > 1)
+    {
+        pthread_mutex_unlock(&(shard->lock));
+        return;
+    }
+    GenericString **link = &(shard->buckets[str->hash & (shard->size - 1)]);
+    while (*link != str) link = &((*link)->next);
+    *link = str->next;
+    shard->count--;
+    pthread_mutex_unlock(&(shard->lock));
+    free(str);
+}
+
+const char* GenericString_Chars(const GenericString *str)
+{
+    return str->chars;
+}
+
+GenericString* GenericString_FromChars(const char *chars)
+{
+    return (GenericString*) (chars - offsetof(GenericString, chars));
+}
+
+int GenericString_Length(const GenericString *str)
+{
+    return str->len;
+}
+
+uint64_t GenericString_Hash(const GenericString *str)
+{
+    return str->hash;
+}
+
+size_t GenericString_InternedCount(void)
+{
+    size_t count = 0;
+    for (int i = 0; i < _SHARD_COUNT; i++)
+    {
+        _InternShard *shard = _ShardOf((uint64_t) i << (64 - _SHARD_BITS));
+        pthread_mutex_lock(&(shard->lock));
+        count += shard->count;
+        pthread_mutex_unlock(&(shard->lock));
+    }
+    return count;
+}
@@ -2,46 +2,284 @@
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "../include/common_util.h"
 #include "../include/generic_table.h"
 #include "../include/generic_type.h"
 #include "../include/string_builder.h"
 #include "../include/number_util.h"
+#include "../include/hash_util.h"
+#include "../include/generic_arena.h"
+#include "../include/cow_util.h"
+#include "../include/generic_pool.h"
+#include "../include/generic_string.h"
 
 // ================================================================================
 // Private Properties
 // ================================================================================
+/**
+ * 直接存放在映射物件中的 key 容量(含結尾的 '\0')，
+ * 長度小於此值的 key 不另外配置記憶體，比對時也不需多讀取一塊記憶體
+ */
+#define _INLINE_KEY_SIZE 24
+
+/**
+ * 映射物件，值(GenericType)緊接在映射物件之後一起配置，
+ * 映射物件與值合計 64 個位元組，查找命中後讀取值不需再跳到另一塊記憶體
+ */
 struct GenericTableItem
 {
-    char *key;
-    GenericType *value;
+    /**
+     * key 的完整雜湊值，探測、重構時直接使用，不需重新計算
+     */
+    uint64_t hash;
+    /**
+     * key 的字串長度，比對字串前先比對長度，也決定 key 存放的位置
+     */
+    int key_len;
+    /**
+     * 保持插入順序時，在 entries 中的位置
+     */
+    int entry_index;
+    /**
+     * key_len < _INLINE_KEY_SIZE 時存放在 inline_key，否則存放在另外配置的 heap_key，
+     * 開啟 intern_keys 時 heap_key 指向字串池中 GenericString 的內容
+     */
+    union
+    {
+        char inline_key[_INLINE_KEY_SIZE];
+        char *heap_key;
+    } key;
 };
 
-struct GenericTable_Private
+/**
+ * 保持插入順序時，依插入順序緊密排列的映射物件，刪除的位置為 NULL，重構時才會壓縮
+ */
+typedef struct _GenericTableEntries
+{
+    GenericTableItem **items;
+    /**
+     * 已使用的位置數量，包含已刪除的位置，新增的映射物件放在此位置
+     */
+    int count;
+    int capacity;
+} _GenericTableEntries;
+
+/**
+ * 編譯時定義 GENERIC_TABLE_ENABLE_STATS 才會累計的查找、新增計數，
+ * 未定義時 _COUNT 不產生任何程式碼，熱路徑沒有額外成本，
+ * 多個讀者可以在分片讀鎖內同時查找(GenericConcurrentTable)，以不排序的原子操作累加
+ */
+typedef struct _GenericTableCounters
+{
+    long finds;
+    long find_hits;
+    long probes;
+    long inserts;
+    long updates;
+} _GenericTableCounters;
+
+#if defined(GENERIC_TABLE_ENABLE_STATS)
+#define _COUNT(counters, field, n) ((void) __atomic_fetch_add(&((counters)->field), (n), __ATOMIC_RELAXED))
+#else
+#define _COUNT(counters, field, n) ((void) 0)
+#endif
+
+/**
+ * GenericTable_FromArrays 一次配置的連續區塊，區塊中的映射物件與 key 不個別釋放，映射表解構時整塊釋放
+ */
+typedef struct _GenericTableBlock
+{
+    char *start;
+    size_t size;
+    struct _GenericTableBlock *next;
+} _GenericTableBlock;
+
+/**
+ * 一組雜湊容器，漸進式重構期間新舊兩組容器會同時存在
+ */
+typedef struct _GenericTableBucket
 {
     /**
      * 雜湊映射表的容器大小
      */
-    int bucket_size;
+    int size;
+    /**
+     * 質數大小時的 fastmod 常數，計算起始位置時以乘法取代取餘數
+     */
+    uint64_t mod_magic;
+    /**
+     * 2 的次方大小時，乘法雜湊後保留高位元需要右移的位元數，質數大小時為 0
+     */
+    int shift;
+    /**
+     * 已佔用的位置數量，包含標記為 _CTRL_DELETED 的位置，用以判定是否需要重構
+     */
+    int used;
+    /**
+     * 控制位元組，每個位置一個 byte：
+     * 已使用的位置存放雜湊值的低 7 位元，其餘為 _CTRL_EMPTY 或 _CTRL_DELETED，
+     * 尾端額外複製開頭 _GROUP_WIDTH - 1 個位元組，讓群組掃描跨越結尾時不需繞回
+     */
+    signed char *ctrl;
+    /**
+     * 承裝映射物件的容器，與 ctrl 一一對應，保持插入順序時為 NULL
+     */
+    GenericTableItem **items;
+    /**
+     * 保持插入順序時取代 items，存放映射物件在 entries 中的位置，每個位置只佔 4 個位元組
+     */
+    int32_t *indices;
+    _GenericTableEntries *entries;
+#if defined(GENERIC_TABLE_ENABLE_STATS)
+    /**
+     * 指向映射表的計數，探測迴圈只拿得到容器
+     */
+    _GenericTableCounters *counters;
+#endif
+} _GenericTableBucket;
+
+struct GenericTable_Private
+{
     /**
      * 重構臨界點，用以判定容器是否擴充、縮減
      */
     int resize_threshold;
     /**
-     * 實際存在的映射物件(HT_DELETED_ITEM 不算在內)
+     * 實際存在的映射物件(標記為 _CTRL_DELETED 的位置不算在內)，包含尚未搬移的舊容器
      * 會隨著刪除方法而減少
      */
     int item_count;
     /**
-     * 成功新增、刪除的計數
+     * 成功新增、刪除的計數，開始重構時重設為 item_count
      * 不會隨著刪除方法而減少
      */
     int modified_count;
     /**
-     * 承裝映射物件的容器
+     * 容器配置版本，新增、刪除 key 或搬移映射物件時遞增，
+     * GenericTable_Cursor 以此判定迭代期間映射表是否被修改
      */
-    GenericTableItem **items;
+    unsigned int layout_version;
+    /**
+     * 計算 key 雜湊值的函式
+     */
+    GenericTableHashFn hash_fn;
+    /**
+     * 傳給 hash_fn 的種子
+     */
+    uint64_t seed;
+    /**
+     * 探測方式，建構後不會改變
+     */
+    GenericTableProbing probing;
+    /**
+     * 查找時是否順便搬移舊容器，關閉時查找不會修改映射表，可在讀取鎖內同時查找
+     */
+    bool rehash_on_lookup;
+    /**
+     * 是否保持插入順序，建構後不會改變
+     */
+    bool ordered;
+    /**
+     * 保持插入順序時，依插入順序排列的映射物件
+     */
+    _GenericTableEntries entries;
+    /**
+     * 容器大小的取法，建構後不會改變
+     */
+    GenericTableSizing sizing;
+    /**
+     * 刪除後物件過少時是否自動縮減容器
+     */
+    bool auto_shrink;
+    /**
+     * 放不進 inline_key 的 key 是否從字串池取得，在 arena 中時固定為 false
+     */
+    bool intern_keys;
+    /**
+     * 雜湊函式與種子和字串池相同，取得字串時直接使用已算好的雜湊值
+     */
+    bool intern_hash_shared;
+    /**
+     * GenericTable_Reserve 預留的容器大小，自動縮減不會小於此大小
+     */
+    int reserved_size;
+    /**
+     * 配置映射表、容器與映射物件的 arena，NULL 代表以 malloc 配置
+     */
+    GenericArena *arena;
+    /**
+     * 批次建構時配置的映射物件、key 區塊
+     */
+    _GenericTableBlock *blocks;
+    /**
+     * 值共用的環境：arena 與版本狀態
+     */
+    GenericTypeContext context;
+    /**
+     * 目前使用的容器，新增的映射物件一律放在這裡
+     */
+    _GenericTableBucket buckets;
+    /**
+     * 重構中尚未搬移完畢的舊容器，ctrl 為 NULL 代表沒有進行中的重構，
+     * 舊容器只會被搬移、刪除，不會再放入新的映射物件
+     */
+    _GenericTableBucket old_buckets;
+    /**
+     * 舊容器下一個要搬移的位置
+     */
+    int rehash_index;
+    /**
+     * 舊容器中尚未搬移的映射物件數量
+     */
+    int old_count;
+    /**
+     * 擴充、縮減、以相同大小重構(清除 _CTRL_DELETED)的次數
+     */
+    int grow_count;
+    int shrink_count;
+    int rehash_count;
+    /**
+     * 重構、搬移舊容器累計花費的時間(奈秒)
+     */
+    long resize_nanos;
+#if defined(GENERIC_TABLE_ENABLE_STATS)
+    _GenericTableCounters counters;
+#endif
+    /**
+     * 快照的版本狀態，arrays_shared 為 true 時容器陣列與 entries 仍與凍結的版本共用，修改前須先複製
+     */
+    CowUtil_State cow;
+    bool arrays_shared;
+    /**
+     * 凍結的版本，只供快照讀取
+     */
+    bool is_version;
+    /**
+     * 參考計數，歸零時才真正解構
+     */
+    atomic_int refs;
+};
+
+/**
+ * 凍結的版本：複製映射表的描述，容器陣列與映射物件與映射表共用
+ */
+typedef struct _GenericTableVersion
+{
+    GenericTable table;
+    GenericTable_Private priv;
+} _GenericTableVersion;
+
+struct GenericTableSnapshot
+{
+    GenericTable *root;
+    uint64_t generation;
 };
 
 /**
@@ -54,426 +292,2545 @@ struct GenericTableIterator
     GenericTableItem **items;
 };
 
-// 作為雜湊運算用的常數
-static const int _HASH_ARG = 0X11;
 static const int _DEFAULT_SIZE = 0X1f;
 static const int _DEFAULT_LOAD_FACTOR = 0X50;
 
-// 作為判定已刪除的物件
-static GenericTableItem _DELETED_ITEM = {NULL, NULL};
+// 每次新增、刪除、查找時，從舊容器搬移的位置數量
+static const int _REHASH_STEP = 0X40;
 
-static GenericTableItem* _New_GenericTableItem(const char *key, GenericType *val)
-{
-    GenericTableItem* item = (GenericTableItem*) malloc(sizeof(GenericTableItem));
-    item->key = strdup(key);
-    item->value = val;
+// 批次查找時一輪同時處理的 key 數量
+#define _BATCH_WIDTH 16
 
-    return item;
+// 控制位元組的狀態，已使用的位置為 0 ~ 127 (最高位元為 0)
+#define _CTRL_EMPTY ((signed char) -128)
+#define _CTRL_DELETED ((signed char) -2)
+
+// 一次比對的位置數量，剛好是一個 SSE2 暫存器的寬度
+#define _GROUP_WIDTH 16
+
+/**
+ * 群組比對結果，第 i 個位元代表群組中第 i 個位置符合條件
+ */
+typedef unsigned int _GroupMask;
+
+static inline _GroupMask _Group_Match(const signed char *group, signed char tag)
+{
+#if defined(__SSE2__)
+    __m128i ctrl = _mm_loadu_si128((const __m128i*) group);
+    return (_GroupMask) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+#else
+    _GroupMask mask = 0;
+    for (int i = 0; i < _GROUP_WIDTH; i++)
+    {
+        if (group[i] == tag) mask |= 1u << i;
+    }
+    return mask;
+#endif
 }
 
-static void _Delete_GenericTableItem(GenericTableItem* item) 
+static inline _GroupMask _Group_MatchEmpty(const signed char *group)
 {
-    free(item->key);
-    Delete_GenericType(&(item->value));
-    free(item);
+    return _Group_Match(group, _CTRL_EMPTY);
 }
 
-static int _Calculate_StringHash(const char *str, const int hash_arg) 
+/**
+ * 空位與已刪除的位置最高位元皆為 1，直接取出符號位元即可
+ */
+static inline _GroupMask _Group_MatchEmptyOrDeleted(const signed char *group)
 {
-    long hash = 0;
-    const int str_len = strlen(str);
-    for (size_t i = 0; i < str_len; i++)
+#if defined(__SSE2__)
+    return (_GroupMask) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) group));
+#else
+    _GroupMask mask = 0;
+    for (int i = 0; i < _GROUP_WIDTH; i++)
     {
-        hash <<= 6;
-        hash += str[i] * hash_arg ^ (str_len - 1);
-        hash ^= (hash >> 16) ^ (hash >> 8);
+        if (group[i] < 0) mask |= 1u << i;
     }
-    hash ^= (hash >> 24) ^ (hash >> 12);
-    return (int) hash ^ (hash >> 8) ^ (hash >> 4);
+    return mask;
+#endif
 }
 
-static int _Get_HashValue(const char *str, const int max_val, const int addition)
+static inline int _LowestBit(_GroupMask mask)
 {
-    int result = _Calculate_StringHash(str, _HASH_ARG);
-    if (result < 0) result = ~result;
-
-    return (result + addition) % max_val;
+    return __builtin_ctz(mask);
 }
 
-static inline int _IsAbandoned(GenericTableItem *item)
+static inline uint64_t _Get_HashValue(GenericTable_Private *priv, const char *str, int str_len)
 {
-    return item == &_DELETED_ITEM;
+    return priv->hash_fn(str, (size_t) str_len, priv->seed);
 }
 
-static inline int _IsValid(GenericTableItem *item)
+static inline bool _IsInlineKey(int key_len)
 {
-    return item != NULL && !_IsAbandoned(item);
+    return key_len < _INLINE_KEY_SIZE;
 }
 
-static GenericTable* _New_GenericTable(int size, int threshold)
+static inline char* _ItemKey(GenericTableItem *item)
 {
-    GenericTable* table = calloc(1, sizeof(GenericTable));
-    GenericTable_Private *priv = calloc(1, sizeof(GenericTable_Private));
-
-    priv->bucket_size = size;
-    priv->resize_threshold = threshold;
-    priv->item_count = 0;
-    priv->modified_count = 0;
-    priv->items = calloc((size_t) priv->bucket_size, sizeof(GenericTableItem*));
-    table->priv = priv;
-
-    return table;
+    return _IsInlineKey(item->key_len) ? item->key.inline_key : item->key.heap_key;
 }
 
-static void _AddItem(GenericTable *table, GenericTableItem *new_item)
+/**
+ * 以映射表的 arena 配置記憶體，沒有 arena 時使用 malloc
+ */
+static inline void* _Alloc(GenericTable_Private *priv, size_t size)
 {
-    GenericTable_Private *priv = table->priv;
-    GenericTableItem *item;
-    int index, addition;
-    
-    addition = 0;
-    while (true)
-    {
-        index = _Get_HashValue(new_item->key, priv->bucket_size, addition);
-        item = priv->items[index];
-        addition++;
+    return priv->arena ? GenericArena_Alloc(priv->arena, size) : malloc(size);
+}
 
-        if (item == NULL) break;
-        if (_IsAbandoned(item) || strcmp(new_item->key, item->key) != 0) continue;
+static inline void _Free(GenericTable_Private *priv, void *ptr)
+{
+    if (!priv->arena) free(ptr);
+}
 
-        _Delete_GenericTableItem(item);
-        priv->item_count--;
-        break;
-    }
+static inline GenericType* _ItemValue(GenericTableItem *item)
+{
+    return (GenericType*) (item + 1);
+}
 
-    priv->items[index] = new_item;
-    priv->item_count++;
-    priv->modified_count++;
+/**
+ * 映射物件連同值的大小
+ */
+static inline size_t _ItemSize(void)
+{
+    return sizeof(GenericTableItem) + GENERIC_TYPE_SIZE;
 }
 
-static int _NeedResize(GenericTable *table)
+/**
+ * 不在 arena 中的映射物件從池配置
+ */
+static GenericPool _item_pool = GENERIC_POOL_INIT(sizeof(GenericTableItem) + GENERIC_TYPE_SIZE);
+
+/**
+ * 從字串池取得 key，回傳與 GenericString 共用的內容
+ */
+static char* _InternKey(GenericTable_Private *priv, const char *key, int key_len, uint64_t hash)
 {
-    GenericTable_Private *priv = table->priv;
-    return priv->modified_count * 100 / priv->bucket_size > priv->resize_threshold;
+    GenericString *str = priv->intern_hash_shared
+        ? GenericString_InternHashed(key, (size_t) key_len, hash)
+        : GenericString_Intern(key, (size_t) key_len);
+    return (char*) GenericString_Chars(str);
 }
 
-static inline void _EnsureBucketSize(GenericTable *table)
+/**
+ * 建構映射物件，值為 GEN_TYPE_NULL，由呼叫端寫入
+ */
+static GenericTableItem* _New_GenericTableItem(GenericTable_Private *priv, const char *key, int key_len, uint64_t hash)
 {
-    if (!_NeedResize(table)) return;
-    
-    GenericTable_Private *curr_priv = table->priv;
-    int current_size = curr_priv->item_count;
-    int new_size = NumberUtil_NextPrime(current_size * 2);
-    if (_DEFAULT_SIZE >= new_size) 
+    GenericTableItem* item = (GenericTableItem*) (priv->arena
+        ? GenericArena_Alloc(priv->arena, _ItemSize())
+        : GenericPool_Alloc(&_item_pool));
+    item->key_len = key_len;
+    item->hash = hash;
+    if (_IsInlineKey(item->key_len))
     {
-        new_size = _DEFAULT_SIZE;
+        memcpy(item->key.inline_key, key, (size_t) item->key_len + 1);
     }
-
-    GenericTable *temp_table = _New_GenericTable(new_size, curr_priv->resize_threshold);
-    if (!temp_table) s_out_err("malloc new GenericTable failed");
-
-    for (size_t i = 0; i < curr_priv->bucket_size; i++)
+    else if (priv->intern_keys)
     {
-        GenericTableItem *item = curr_priv->items[i];
-        if (!_IsValid(item)) continue;
-
-        _AddItem(temp_table, item);
+        item->key.heap_key = _InternKey(priv, key, key_len, hash);
     }
+    else
+    {
+        item->key.heap_key = (char*) _Alloc(priv, (size_t) item->key_len + 1);
+        memcpy(item->key.heap_key, key, (size_t) item->key_len + 1);
+    }
+    GenericType_InitAt(_ItemValue(item), &(priv->context), priv->cow.epoch);
 
-    GenericTable_Private *temp_priv = temp_table->priv;
-    table->priv = temp_priv;
-    free(curr_priv->items);
-
-    if (curr_priv) return;
-    free(curr_priv);
+    return item;
 }
 
-static GenericTableItem* _Find(GenericTable *table, const char *key)
+/**
+ * 是否位在批次建構配置的區塊中，一般建構的映射表沒有區塊，只多一次判斷
+ */
+static bool _InBlock(GenericTable_Private *priv, const void *ptr)
 {
-    GenericTable_Private *priv = table->priv;
-    GenericTableItem *item;
-    int index, addition;
-
-    addition = 0;
-    while (true)
+    uintptr_t address = (uintptr_t) ptr;
+    for (_GenericTableBlock *block = priv->blocks; block; block = block->next)
     {
-        index = _Get_HashValue(key, priv->bucket_size, addition);
-        item = priv->items[index];
-        addition++;
+        uintptr_t start = (uintptr_t) block->start;
+        if (address >= start && address < start + block->size) return true;
+    }
+    return false;
+}
 
-        if (item == NULL) break;
-        if (_IsAbandoned(item) || strcmp(item->key, key) != 0) continue;
+/**
+ * 釋放另外存放的 key，字串池中的 key 遞減參考計數，批次建構區塊中的 key 隨區塊釋放
+ */
+static void _Release_ItemKey(GenericTable_Private *priv, GenericTableItem *item)
+{
+    if (_IsInlineKey(item->key_len)) return;
 
-        return item;
+    if (priv->intern_keys)
+    {
+        GenericString *str = GenericString_FromChars(item->key.heap_key);
+        Delete_GenericString(&str);
+    }
+    else if (!_InBlock(priv, item->key.heap_key))
+    {
+        _Free(priv, item->key.heap_key);
     }
-
-    return NULL;
 }
 
-// ================================================================================
-// Public properties
-// ================================================================================
-GenericTable* New_GenericTable(void) 
+static void _Delete_GenericTableItem(GenericTable_Private *priv, GenericTableItem* item) 
 {
-    return _New_GenericTable(_DEFAULT_SIZE, _DEFAULT_LOAD_FACTOR);
+    _Release_ItemKey(priv, item);
+    GenericType *value = _ItemValue(item);
+    Delete_GenericType(&value);
+    if (!priv->arena && !_InBlock(priv, item)) GenericPool_Free(&_item_pool, item);
 }
 
-GenericTable* New_GenericTable_WithBucketSize(int size) 
+/**
+ * 雜湊值的高位元決定起始位置，
+ * 質數大小以 fastmod 取餘數，2 的次方大小以 Fibonacci 乘法雜湊取高位元，都不需要除法指令
+ */
+static inline int _HomeIndex(_GenericTableBucket *bucket, uint64_t hash)
 {
-    return _New_GenericTable(size, _DEFAULT_LOAD_FACTOR);
+    uint64_t bits = hash >> 7;
+    if (bucket->shift) return (int) ((bits * 0x9e3779b97f4a7c15ull) >> bucket->shift);
+    return (int) NumberUtil_FastMod((uint32_t) bits, bucket->mod_magic, (uint32_t) bucket->size);
 }
 
-GenericTable* New_GenericTable_WithBucketSizeAndLoadFactor(int size, int load_factor)
+/**
+ * 雜湊值的低 7 位元作為控制位元組的標記
+ */
+static inline signed char _HashTag(uint64_t hash)
 {
-    return _New_GenericTable(size, load_factor);
+    return (signed char) (hash & 0x7f);
 }
 
-void Delete_GenericTable(GenericTable **p_to_table) 
+static inline void _SetCtrl(_GenericTableBucket *bucket, int index, signed char tag)
 {
-    GenericTable *table = *p_to_table;
-    GenericTable_Private *priv = table->priv;
-    for (int i = 0; i < priv->bucket_size; i++) 
+    bucket->ctrl[index] = tag;
+    if (index < _GROUP_WIDTH - 1)
     {
-        GenericTableItem *item = priv->items[i];
-        if (!_IsValid(item)) continue;
-
-        _Delete_GenericTableItem(item);
+        bucket->ctrl[bucket->size + index] = tag;
     }
-
-    free(priv->items);
-    free(priv);
-    free(table);
-    *p_to_table = NULL;
-} 
-
-void GenericTable_Add_Str(GenericTable *table, const char *key, const char *value)
-{
-    _EnsureBucketSize(table);
-    GenericType *gen_obj = New_GenericType(value);
-    GenericTableItem *new_item = _New_GenericTableItem(key, gen_obj);
-    _AddItem(table, new_item);
 }
 
-void GenericTable_Add_Int(GenericTable *table, const char *key, int value)
+/**
+ * 最多需要探測的群組數量，保證即使容器內沒有空位也會結束
+ */
+static inline int _MaxProbeGroups(_GenericTableBucket *bucket)
 {
-    _EnsureBucketSize(table);
-    GenericType *gen_obj = New_GenericType(value);
-    GenericTableItem *new_item = _New_GenericTableItem(key, gen_obj);
-    _AddItem(table, new_item);
+    return bucket->size / _GROUP_WIDTH + 1;
 }
 
-void GenericTable_Add_Long(GenericTable *table, const char *key, long value)
+static inline int _NextGroup(_GenericTableBucket *bucket, int pos)
 {
-    _EnsureBucketSize(table);
-    GenericType *gen_obj = New_GenericType(value);
-    GenericTableItem *new_item = _New_GenericTableItem(key, gen_obj);
-    _AddItem(table, new_item);
+    pos += _GROUP_WIDTH;
+    if (pos >= bucket->size) pos -= bucket->size;
+    return pos;
 }
 
-void GenericTable_Add_Double(GenericTable *table, const char *key, double value)
+static inline int _SlotOf(_GenericTableBucket *bucket, int pos, int offset)
 {
-    _EnsureBucketSize(table);
-    GenericType *gen_obj = New_GenericType(value);
-    GenericTableItem *new_item = _New_GenericTableItem(key, gen_obj);
-    _AddItem(table, new_item);
+    int index = pos + offset;
+    if (index >= bucket->size) index -= bucket->size;
+    return index;
 }
 
-void GenericTable_Add_Float(GenericTable *table, const char *key, float value)
+/**
+ * 取得位置上的映射物件，呼叫前須確認該位置已使用
+ */
+static inline GenericTableItem* _SlotItem(_GenericTableBucket *bucket, int index)
 {
-    _EnsureBucketSize(table);
-    GenericType *gen_obj = New_GenericType(value);
-    GenericTableItem *new_item = _New_GenericTableItem(key, gen_obj);
-    _AddItem(table, new_item);
+    if (bucket->indices) return bucket->entries->items[bucket->indices[index]];
+    return bucket->items[index];
 }
 
-void GenericTable_Add_Table(GenericTable *table, const char *key, GenericTable *value)
+static inline void _SetSlot(_GenericTableBucket *bucket, int index, GenericTableItem *item)
 {
-    _EnsureBucketSize(table);
-    GenericType *gen_obj = New_GenericType(value);
-    GenericTableItem *new_item = _New_GenericTableItem(key, gen_obj);
-    _AddItem(table, new_item);
+    if (bucket->indices)
+        bucket->indices[index] = item ? item->entry_index : -1;
+    else
+        bucket->items[index] = item;
 }
 
-void GenericTable_Add_List(GenericTable *table, const char *key, struct GenericList *value)
+/**
+ * 把需要的大小進位到實際使用的容器大小：質數階梯中的質數，或 2 的次方，
+ * 容器至少要能容納一個完整的群組，尾端複製的控制位元組才不會重疊
+ */
+static int _RoundSize(GenericTable_Private *priv, int size)
 {
-    _EnsureBucketSize(table);
-    GenericType *gen_obj = New_GenericType(value);
-    GenericTableItem *new_item = _New_GenericTableItem(key, gen_obj);
-    _AddItem(table, new_item);
+    if (size < _GROUP_WIDTH) size = _GROUP_WIDTH;
+    if (priv->sizing != GENERIC_TABLE_SIZE_POW2) return NumberUtil_LadderPrime(size).prime;
+
+    int pow2 = _GROUP_WIDTH;
+    while (pow2 < size && pow2 < (1 << 30)) pow2 <<= 1;
+    return pow2;
 }
 
-char* GenericTable_Find_Str(GenericTable *table, const char *key)
+static inline bool _IsRehashing(GenericTable_Private *priv)
 {
-    GenericTableItem *item = _Find(table, key);
-    if (!item) return NULL;
-
-    GenericType *gen = item->value;
-    if (!item || !GenericType_IsType(gen, GEN_TYPE_STR)) return NULL;
-    
-    return GenericType_GetStr(gen);
+    return priv->old_buckets.ctrl != NULL;
 }
 
-int* GenericTable_Find_Int(GenericTable *table, const char *key)
+/**
+ * 配置容器，arena 中的映射表擴充後，舊容器會留在 arena 中直到 arena 重設
+ */
+static void _Init_Bucket(GenericTable_Private *priv, _GenericTableBucket *bucket, int size)
 {
-    GenericTableItem *item = _Find(table, key);
-    if (!item) return NULL;
+    size = _RoundSize(priv, size);
+    if (priv->sizing == GENERIC_TABLE_SIZE_POW2)
+    {
+        bucket->shift = 64 - __builtin_ctz((unsigned int) size);
+        bucket->mod_magic = 0;
+    }
+    else
+    {
+        bucket->shift = 0;
+        bucket->mod_magic = NumberUtil_LadderPrime(size).magic;
+    }
 
-    GenericType *gen = item->value;
-    if (!item || !GenericType_IsType(gen, GEN_TYPE_INT)) return NULL;
-    
-    return GenericType_GetInt(gen);
+    bucket->size = size;
+    bucket->used = 0;
+    bucket->ctrl = (signed char*) _Alloc(priv, (size_t) size + _GROUP_WIDTH);
+    memset(bucket->ctrl, _CTRL_EMPTY, (size_t) size + _GROUP_WIDTH);
+    bucket->entries = &(priv->entries);
+#if defined(GENERIC_TABLE_ENABLE_STATS)
+    bucket->counters = &(priv->counters);
+#endif
+    if (priv->ordered)
+    {
+        bucket->items = NULL;
+        bucket->indices = (int32_t*) _Alloc(priv, (size_t) size * sizeof(int32_t));
+        memset(bucket->indices, 0xff, (size_t) size * sizeof(int32_t));
+    }
+    else
+    {
+        bucket->indices = NULL;
+        bucket->items = (GenericTableItem**) _Alloc(priv, (size_t) size * sizeof(GenericTableItem*));
+        memset(bucket->items, 0, (size_t) size * sizeof(GenericTableItem*));
+    }
 }
 
-long* GenericTable_Find_Long(GenericTable *table, const char *key)
+/**
+ * 釋放容器本身，delete_items 為 true 時一併解構其中的映射物件
+ */
+static void _Free_Bucket(GenericTable_Private *priv, _GenericTableBucket *bucket, bool delete_items)
 {
-    GenericTableItem *item = _Find(table, key);
-    if (!item) return NULL;
+    if (!bucket->ctrl) return;
 
-    GenericType *gen = item->value;
-    if (!item || !GenericType_IsType(gen, GEN_TYPE_LONG)) return NULL;
-    
-    return GenericType_GetLong(gen);
+    if (delete_items)
+    {
+        for (int i = 0; i < bucket->size; i++)
+        {
+            if (bucket->ctrl[i] < 0) continue;
+
+            _Delete_GenericTableItem(priv, _SlotItem(bucket, i));
+        }
+    }
+    _Free(priv, bucket->ctrl);
+    _Free(priv, bucket->items);
+    _Free(priv, bucket->indices);
+    bucket->ctrl = NULL;
+    bucket->items = NULL;
+    bucket->indices = NULL;
+    bucket->size = 0;
+    bucket->used = 0;
 }
 
-double* GenericTable_Find_Double(GenericTable *table, const char *key)
+// ================================================================================
+// 快照：寫入前凍結目前的狀態，之後只複製碰到的容器陣列與映射物件
+// ================================================================================
+static void* _Cow_Freeze(void *owner)
 {
-    GenericTableItem *item = _Find(table, key);
-    if (!item) return NULL;
-
-    GenericType *gen = item->value;
-    if (!item || !GenericType_IsType(gen, GEN_TYPE_DOUBLE)) return NULL;
-    
-    return GenericType_GetDouble(gen);
+    GenericTable_Private *priv = ((GenericTable*) owner)->priv;
+    _GenericTableVersion *version = (_GenericTableVersion*) malloc(sizeof(_GenericTableVersion));
+    memcpy(&(version->priv), priv, sizeof(GenericTable_Private));
+    version->table.priv = &(version->priv);
+    version->priv.is_version = true;
+    version->priv.rehash_on_lookup = false;
+    version->priv.buckets.entries = &(version->priv.entries);
+    version->priv.old_buckets.entries = &(version->priv.entries);
+#if defined(GENERIC_TABLE_ENABLE_STATS)
+    version->priv.buckets.counters = &(version->priv.counters);
+    version->priv.old_buckets.counters = &(version->priv.counters);
+#endif
+    priv->arrays_shared = true;
+    return &(version->table);
 }
 
-float* GenericTable_Find_Float(GenericTable *table, const char *key)
+/**
+ * 容器陣列一次全部複製，與映射表的 ctrl 相同代表仍全部共用，交還給映射表
+ */
+static void _Cow_Release(void *owner, void *data)
 {
-    GenericTableItem *item = _Find(table, key);
+    GenericTable_Private *priv = ((GenericTable*) owner)->priv;
+    _GenericTableVersion *version = (_GenericTableVersion*) data;
+    GenericTable_Private *frozen = &(version->priv);
+    if (frozen->buckets.ctrl == priv->buckets.ctrl)
+    {
+        priv->arrays_shared = false;
+    }
+    else
+    {
+        _Free_Bucket(priv, &(frozen->buckets), false);
+        _Free_Bucket(priv, &(frozen->old_buckets), false);
+        _Free(priv, frozen->entries.items);
+    }
+    free(version);
+}
+
+static void _Cow_Drop(void *owner, void *ptr)
+{
+    _Delete_GenericTableItem(((GenericTable*) owner)->priv, (GenericTableItem*) ptr);
+}
+
+static const CowUtil_Ops _COW_OPS = { _Cow_Freeze, _Cow_Release, _Cow_Drop };
+
+static void* _Dup(GenericTable_Private *priv, const void *src, size_t size)
+{
+    void *dest = _Alloc(priv, size);
+    memcpy(dest, src, size);
+    return dest;
+}
+
+static void _Bucket_Own(GenericTable_Private *priv, _GenericTableBucket *bucket)
+{
+    if (!bucket->ctrl) return;
+
+    bucket->ctrl = (signed char*) _Dup(priv, bucket->ctrl, (size_t) bucket->size + _GROUP_WIDTH);
+    if (bucket->items)
+        bucket->items = (GenericTableItem**) _Dup(priv, bucket->items, (size_t) bucket->size * sizeof(GenericTableItem*));
+    if (bucket->indices)
+        bucket->indices = (int32_t*) _Dup(priv, bucket->indices, (size_t) bucket->size * sizeof(int32_t));
+}
+
+/**
+ * 快照中讀取時改讀快照當下的版本
+ */
+static GenericTable* _ReadTable(GenericTable *table)
+{
+    uint64_t generation = CowUtil_ReadGeneration();
+    if (!generation || table->priv->is_version) return table;
+
+    GenericTable *version = (GenericTable*) CowUtil_Resolve(&(table->priv->cow), &_COW_OPS, table, generation);
+    return version ? version : table;
+}
+
+/**
+ * 寫入或取得可修改的值之前呼叫，快照中不可修改
+ */
+static inline bool _PrepareWrite(GenericTable *table)
+{
+    if (CowUtil_ReadGeneration())
+    {
+        s_out_err("GenericTable is read only inside a snapshot");
+        return false;
+    }
+    CowUtil_PrepareWrite(&(table->priv->cow), &_COW_OPS, table);
+    return true;
+}
+
+/**
+ * 實際修改前呼叫，容器陣列仍與凍結的版本共用時先複製一份
+ */
+static void _MarkModified(GenericTable_Private *priv)
+{
+    CowUtil_MarkModified(&(priv->cow));
+    if (!priv->arrays_shared) return;
+
+    _Bucket_Own(priv, &(priv->buckets));
+    _Bucket_Own(priv, &(priv->old_buckets));
+    if (priv->entries.items)
+    {
+        priv->entries.items = (GenericTableItem**) _Dup(
+            priv, priv->entries.items, (size_t) priv->entries.capacity * sizeof(GenericTableItem*)
+        );
+    }
+    priv->arrays_shared = false;
+}
+
+static inline bool _BeginModify(GenericTable *table)
+{
+    if (!_PrepareWrite(table)) return false;
+
+    _MarkModified(table->priv);
+    return true;
+}
+
+/**
+ * 移除映射物件，仍與快照共用時交給快照保管
+ */
+static inline void _Retire_Item(GenericTable *table, GenericTableItem *item)
+{
+    CowUtil_Retire(&(table->priv->cow), &_COW_OPS, table, item, GenericType_GetEpoch(_ItemValue(item)));
+}
+
+/**
+ * 取得可修改的映射物件，仍與快照共用時複製映射物件與值取代原本的位置，原本的交給快照保管
+ */
+static GenericTableItem* _OwnItem(GenericTable *table, _GenericTableBucket *bucket, int index)
+{
+    GenericTable_Private *priv = table->priv;
+    GenericTableItem *item = _SlotItem(bucket, index);
+    if (!CowUtil_IsShared(&(priv->cow), GenericType_GetEpoch(_ItemValue(item)))) return item;
+
+    _MarkModified(priv);
+    GenericTableItem *copy = _New_GenericTableItem(priv, _ItemKey(item), item->key_len, item->hash);
+    GenericType_Assign(_ItemValue(copy), _ItemValue(item));
+    if (priv->ordered)
+    {
+        copy->entry_index = item->entry_index;
+        priv->entries.items[item->entry_index] = copy;
+    }
+    else
+    {
+        bucket->items[index] = copy;
+    }
+    _Retire_Item(table, item);
+    return copy;
+}
+
+/**
+ * 修正建構選項中無法使用的值，負載係數須介於 1 到 99 之間，
+ * 100 以上時容器永遠不會擴充，0 以下無法換算容器大小，皆改用預設值
+ */
+static GenericTableOptions _NormalizeOptions(const GenericTableOptions *options)
+{
+    GenericTableOptions normalized = *options;
+    if (normalized.load_factor <= 0 || normalized.load_factor >= 100) normalized.load_factor = _DEFAULT_LOAD_FACTOR;
+    return normalized;
+}
+
+static GenericTable* _New_GenericTable(const GenericTableOptions *p_options)
+{
+    GenericTableOptions normalized = _NormalizeOptions(p_options);
+    const GenericTableOptions *options = &normalized;
+    GenericTable *table;
+    GenericTable_Private *priv;
+    if (options->arena)
+    {
+        table = GenericArena_Calloc(options->arena, sizeof(GenericTable));
+        priv = GenericArena_Calloc(options->arena, sizeof(GenericTable_Private));
+    }
+    else
+    {
+        table = calloc(1, sizeof(GenericTable));
+        priv = calloc(1, sizeof(GenericTable_Private));
+    }
+    priv->arena = options->arena;
+    priv->blocks = NULL;
+
+    priv->resize_threshold = options->load_factor;
+    priv->item_count = 0;
+    priv->modified_count = 0;
+    priv->layout_version = 0;
+    priv->hash_fn = options->hash_fn ? options->hash_fn : HashUtil_WyHash;
+    priv->seed = options->seed;
+    priv->probing = options->probing;
+    priv->rehash_on_lookup = options->rehash_on_lookup;
+    priv->auto_shrink = options->auto_shrink;
+    priv->intern_keys = options->intern_keys && !priv->arena;
+    priv->intern_hash_shared = priv->hash_fn == HashUtil_WyHash && priv->seed == HashUtil_ProcessSeed();
+    priv->sizing = options->sizing;
+    priv->ordered = options->ordered;
+    if (priv->ordered)
+    {
+        priv->entries.capacity = _GROUP_WIDTH;
+        priv->entries.count = 0;
+        priv->entries.items = (GenericTableItem**) _Alloc(priv, (size_t) priv->entries.capacity * sizeof(GenericTableItem*));
+    }
+    priv->reserved_size = 0;
+    _Init_Bucket(priv, &(priv->buckets), options->bucket_size);
+    priv->rehash_index = 0;
+    priv->old_count = 0;
+    CowUtil_Init(&(priv->cow));
+    priv->context.arena = priv->arena;
+    priv->context.owner = &(priv->cow);
+    priv->arrays_shared = false;
+    priv->is_version = false;
+    atomic_init(&(priv->refs), 1);
+    table->priv = priv;
+
+    return table;
+}
+
+static inline bool _IsSameKey(GenericTableItem *item, const char *key, int key_len, uint64_t hash)
+{
+    return item->hash == hash
+        && item->key_len == key_len
+        && memcmp(_ItemKey(item), key, (size_t) key_len) == 0;
+}
+
+static inline bool _IsRobinHood(GenericTable_Private *priv)
+{
+    return priv->probing == GENERIC_TABLE_PROBE_ROBIN_HOOD;
+}
+
+// ================================================================================
+// 群組探測：以 16 個位置為一組，用控制位元組一次比對整組
+// ================================================================================
+/**
+ * 依照雜湊值以群組為單位探測，
+ * 只有控制位元組的標記相符時才會讀取映射物件，並依序比對雜湊值、長度、key，
+ * 找到時回傳位置，找不到時回傳 -1，並透過 p_free_index 帶回第一個可放置的位置
+ */
+static int _Group_FindIndex(_GenericTableBucket *bucket, const char *key, int key_len, uint64_t hash, int *p_free_index)
+{
+    signed char tag = _HashTag(hash);
+    int pos = _HomeIndex(bucket, hash);
+    int free_index = -1;
+
+    for (int probe = 0; probe < _MaxProbeGroups(bucket); probe++)
+    {
+        _COUNT(bucket->counters, probes, 1);
+        const signed char *group = bucket->ctrl + pos;
+        _GroupMask match = _Group_Match(group, tag);
+        while (match)
+        {
+            int index = _SlotOf(bucket, pos, _LowestBit(match));
+            if (_IsSameKey(_SlotItem(bucket, index), key, key_len, hash)) return index;
+            match &= match - 1;
+        }
+
+        if (free_index < 0)
+        {
+            _GroupMask available = _Group_MatchEmptyOrDeleted(group);
+            if (available) free_index = _SlotOf(bucket, pos, _LowestBit(available));
+        }
+        if (_Group_MatchEmpty(group)) break;
+
+        pos = _NextGroup(bucket, pos);
+    }
+
+    if (p_free_index) *p_free_index = free_index;
+    return -1;
+}
+
+static inline void _Group_Place(_GenericTableBucket *bucket, int index, GenericTableItem *item)
+{
+    if (bucket->ctrl[index] == _CTRL_EMPTY) bucket->used++;
+    _SetSlot(bucket, index, item);
+    _SetCtrl(bucket, index, _HashTag(item->hash));
+}
+
+/**
+ * 放入確定不存在的 key，只需以保存的雜湊值找出第一個可放置的位置，不會讀取 key
+ */
+static void _Group_Insert(_GenericTableBucket *bucket, GenericTableItem *item)
+{
+    int pos = _HomeIndex(bucket, item->hash);
+    while (true)
+    {
+        _GroupMask available = _Group_MatchEmptyOrDeleted(bucket->ctrl + pos);
+        if (available)
+        {
+            _Group_Place(bucket, _SlotOf(bucket, pos, _LowestBit(available)), item);
+            return;
+        }
+        pos = _NextGroup(bucket, pos);
+    }
+}
+
+// ================================================================================
+// Robin Hood 探測：逐一位置線性探測，離起始位置較遠的物件優先佔位，
+// 刪除時把後方的物件往前移，不留下 _CTRL_DELETED
+// ================================================================================
+static inline int _RobinHood_Distance(_GenericTableBucket *bucket, int index, GenericTableItem *item)
+{
+    int distance = index - _HomeIndex(bucket, item->hash);
+    if (distance < 0) distance += bucket->size;
+    return distance;
+}
+
+static inline int _RobinHood_Next(_GenericTableBucket *bucket, int index)
+{
+    index++;
+    if (index >= bucket->size) index = 0;
+    return index;
+}
+
+/**
+ * 探測到空位，或遇到離起始位置比目前探測距離還近的物件時即可判定不存在，
+ * _CTRL_DELETED 只會出現在漸進式重構中的舊容器，直接略過
+ */
+static int _RobinHood_FindIndex(_GenericTableBucket *bucket, const char *key, int key_len, uint64_t hash)
+{
+    signed char tag = _HashTag(hash);
+    int index = _HomeIndex(bucket, hash);
+
+    for (int distance = 0; distance < bucket->size; distance++)
+    {
+        _COUNT(bucket->counters, probes, 1);
+        signed char ctrl = bucket->ctrl[index];
+        if (ctrl == _CTRL_EMPTY) break;
+        if (ctrl >= 0)
+        {
+            GenericTableItem *item = _SlotItem(bucket, index);
+            if (ctrl == tag && _IsSameKey(item, key, key_len, hash)) return index;
+            if (_RobinHood_Distance(bucket, index, item) < distance) break;
+        }
+        index = _RobinHood_Next(bucket, index);
+    }
+    return -1;
+}
+
+/**
+ * 放入確定不存在的 key，沿途遇到離起始位置較近的物件就交換，由被換出的物件繼續探測
+ */
+static void _RobinHood_Insert(_GenericTableBucket *bucket, GenericTableItem *item)
+{
+    int index = _HomeIndex(bucket, item->hash);
+    int distance = 0;
+    // 呼叫端保證容器還有空位，最多繞容器一圈即可放入
+    for (int step = 0; step < bucket->size; step++)
+    {
+        if (bucket->ctrl[index] < 0)
+        {
+            bucket->used++;
+            _SetSlot(bucket, index, item);
+            _SetCtrl(bucket, index, _HashTag(item->hash));
+            return;
+        }
+
+        GenericTableItem *current = _SlotItem(bucket, index);
+        int current_distance = _RobinHood_Distance(bucket, index, current);
+        if (current_distance < distance)
+        {
+            _SetSlot(bucket, index, item);
+            _SetCtrl(bucket, index, _HashTag(item->hash));
+            item = current;
+            distance = current_distance;
+        }
+        index = _RobinHood_Next(bucket, index);
+        distance++;
+    }
+    s_out_err("GenericTable Robin Hood bucket has no free slot");
+}
+
+/**
+ * 移除指定位置後，把後方不在起始位置上的物件逐一往前移一格
+ */
+static void _RobinHood_Erase(_GenericTableBucket *bucket, int index)
+{
+    int next = _RobinHood_Next(bucket, index);
+    while (bucket->ctrl[next] >= 0 && _RobinHood_Distance(bucket, next, _SlotItem(bucket, next)) > 0)
+    {
+        _SetSlot(bucket, index, _SlotItem(bucket, next));
+        _SetCtrl(bucket, index, bucket->ctrl[next]);
+        index = next;
+        next = _RobinHood_Next(bucket, next);
+    }
+    _SetSlot(bucket, index, NULL);
+    _SetCtrl(bucket, index, _CTRL_EMPTY);
+    bucket->used--;
+}
+
+// ================================================================================
+// 依照探測方式分派
+// ================================================================================
+static inline int _Bucket_FindIndex(
+    GenericTable_Private *priv, _GenericTableBucket *bucket,
+    const char *key, int key_len, uint64_t hash, int *p_free_index
+) {
+    if (_IsRobinHood(priv)) return _RobinHood_FindIndex(bucket, key, key_len, hash);
+    return _Group_FindIndex(bucket, key, key_len, hash, p_free_index);
+}
+
+static inline void _Bucket_Insert(GenericTable_Private *priv, _GenericTableBucket *bucket, GenericTableItem *item)
+{
+    if (_IsRobinHood(priv))
+        _RobinHood_Insert(bucket, item);
+    else
+        _Group_Insert(bucket, item);
+}
+
+/**
+ * 從舊容器移除指定位置，標記為 _CTRL_DELETED 以保留其他物件的探測路徑，
+ * 舊容器不會再放入物件，兩種探測方式都適用
+ */
+static inline void _Vacate(_GenericTableBucket *bucket, int index)
+{
+    _SetSlot(bucket, index, NULL);
+    _SetCtrl(bucket, index, _CTRL_DELETED);
+}
+
+/**
+ * 從目前的容器移除指定位置
+ */
+static inline void _Bucket_Erase(GenericTable_Private *priv, _GenericTableBucket *bucket, int index)
+{
+    if (_IsRobinHood(priv))
+        _RobinHood_Erase(bucket, index);
+    else
+        _Vacate(bucket, index);
+}
+
+/**
+ * 從舊容器搬移最多 steps 個位置到目前的容器，全部搬完後釋放舊容器
+ */
+static void _RehashStep(GenericTable_Private *priv, int steps)
+{
+    if (!_IsRehashing(priv)) return;
+
+    priv->layout_version++;
+    _GenericTableBucket *old = &(priv->old_buckets);
+    int end = priv->rehash_index + steps;
+    if (end > old->size) end = old->size;
+
+    for (int i = priv->rehash_index; i < end; i++)
+    {
+        if (old->ctrl[i] < 0) continue;
+
+        _Bucket_Insert(priv, &(priv->buckets), _SlotItem(old, i));
+        _Vacate(old, i);
+        priv->old_count--;
+    }
+    priv->rehash_index = end;
+
+    if (priv->rehash_index >= old->size)
+    {
+        _Free_Bucket(priv, old, false);
+        priv->rehash_index = 0;
+        priv->old_count = 0;
+    }
+}
+
+/**
+ * 查找時搬移舊容器，rehash_on_lookup 關閉時(含快照的版本)不做任何修改
+ */
+static inline void _LookupRehashStep(GenericTable *table)
+{
+    GenericTable_Private *priv = table->priv;
+    if (priv->rehash_on_lookup && _IsRehashing(priv) && _BeginModify(table)) _RehashStep(priv, _REHASH_STEP);
+}
+
+// ================================================================================
+// 保持插入順序：映射物件依插入順序存放在 entries，容器只存放位置
+// ================================================================================
+/**
+ * 壓縮 entries 中已刪除的位置，並重建指定大小的容器，不分批搬移
+ */
+static void _Ordered_Rebuild(GenericTable_Private *priv, int new_size)
+{
+    _Free_Bucket(priv, &(priv->buckets), false);
+    priv->layout_version++;
+
+    _GenericTableEntries *entries = &(priv->entries);
+    int count = 0;
+    for (int i = 0; i < entries->count; i++)
+    {
+        GenericTableItem *item = entries->items[i];
+        if (!item) continue;
+        item->entry_index = count;
+        entries->items[count++] = item;
+    }
+    entries->count = count;
+
+    _Init_Bucket(priv, &(priv->buckets), new_size);
+    for (int i = 0; i < count; i++)
+    {
+        _Bucket_Insert(priv, &(priv->buckets), entries->items[i]);
+    }
+    priv->modified_count = priv->item_count;
+}
+
+/**
+ * 把映射物件接在 entries 尾端，entries 已滿時：
+ * 已刪除的位置夠多就壓縮並重建容器，回傳 false，呼叫端須重新尋找放置的位置，
+ * 否則擴充 entries，回傳 true
+ */
+static bool _Ordered_Append(GenericTable_Private *priv, GenericTableItem *item)
+{
+    _GenericTableEntries *entries = &(priv->entries);
+    bool keep_bucket = true;
+    if (entries->count == entries->capacity)
+    {
+        if ((long) priv->item_count * 4 <= (long) entries->count * 3)
+        {
+            _Ordered_Rebuild(priv, priv->buckets.size);
+            keep_bucket = false;
+        }
+        else
+        {
+            int new_capacity = entries->capacity + (entries->capacity >> 1);
+            GenericTableItem **items = (GenericTableItem**) _Alloc(priv, (size_t) new_capacity * sizeof(GenericTableItem*));
+            memcpy(items, entries->items, (size_t) entries->count * sizeof(GenericTableItem*));
+            _Free(priv, entries->items);
+            entries->items = items;
+            entries->capacity = new_capacity;
+        }
+    }
+    item->entry_index = entries->count;
+    entries->items[entries->count++] = item;
+    return keep_bucket;
+}
+
+static int _TargetSize(GenericTable_Private *priv);
+
+static void _Resize(GenericTable_Private *priv, int new_size);
+
+/**
+ * 查找 key，找到時直接回傳原本的映射物件，不配置任何記憶體，
+ * 不存在時放入值為 GEN_TYPE_NULL 的新映射物件，由呼叫端寫入值，
+ * 新增與查找共用同一次探測，容器沒有空位時先擴充再放入
+ */
+static GenericTableItem* _FindOrInsert(GenericTable *table, const char *key, bool *p_inserted)
+{
+    GenericTable_Private *priv = table->priv;
+    _GenericTableBucket *bucket = &(priv->buckets);
+    int key_len = strlen(key);
+    uint64_t hash = _Get_HashValue(priv, key, key_len);
+    int free_index = -1;
+    int index = _Bucket_FindIndex(priv, bucket, key, key_len, hash, &free_index);
+    *p_inserted = false;
+    if (index >= 0) return _OwnItem(table, bucket, index);
+
+    if (_IsRehashing(priv))
+    {
+        // 尚未搬移的舊物件留在舊容器，之後照常搬移
+        _GenericTableBucket *old = &(priv->old_buckets);
+        int old_index = _Bucket_FindIndex(priv, old, key, key_len, hash, NULL);
+        if (old_index >= 0) return _OwnItem(table, old, old_index);
+    }
+
+    // 負載係數小於 100 時放入前已會擴充，沒有空位只是保險，擴充後原本找到的空位已失效
+    bool relocate = _IsRobinHood(priv) ? bucket->used >= bucket->size : free_index < 0;
+    if (relocate) _Resize(priv, _TargetSize(priv));
+
+    GenericTableItem *new_item = _New_GenericTableItem(priv, key, key_len, hash);
+    if ((priv->ordered && !_Ordered_Append(priv, new_item)) || relocate)
+    {
+        // 壓縮 entries 時重建了容器，原本的空位已失效
+        _Bucket_Insert(priv, bucket, new_item);
+    }
+    else if (_IsRobinHood(priv))
+    {
+        _RobinHood_Insert(bucket, new_item);
+    }
+    else
+    {
+        _Group_Place(bucket, free_index, new_item);
+    }
+    priv->item_count++;
+    priv->modified_count++;
+    priv->layout_version++;
+    _COUNT(&(priv->counters), inserts, 1);
+    *p_inserted = true;
+    return new_item;
+}
+
+/**
+ * 放入 count 個物件而不超過重構臨界點所需的最小容器大小
+ */
+static int _CapacityFor(GenericTable_Private *priv, int count)
+{
+    long size = (long) count * 100 / priv->resize_threshold + 1;
+    if (size < _DEFAULT_SIZE) size = _DEFAULT_SIZE;
+    if (size > NUMBER_UTIL_INT_MAX / 2)
+    {
+        s_out_err_f("GenericTable capacity for %d items is over integer max", count);
+        size = NUMBER_UTIL_INT_MAX / 2;
+    }
+    return _RoundSize(priv, (int) size);
+}
+
+/**
+ * 擴充、縮減、清除已刪除的位置時的新容器大小，與 GenericTable_Reserve 相同以負載係數換算，
+ * 預留一半的物件數量，重構後還能再放入一半的物件才會再次擴充
+ */
+static int _TargetSize(GenericTable_Private *priv)
+{
+    int new_size = _CapacityFor(priv, priv->item_count + priv->item_count / 2);
+    if (priv->reserved_size > new_size)
+    {
+        new_size = priv->reserved_size;
+    }
+    return new_size;
+}
+
+/**
+ * 以佔用的位置(含 _CTRL_DELETED 與尚未搬移的舊物件)判定是否擴充或清除已刪除的位置，
+ * 實際物件過少時縮減
+ */
+static int _NeedResize(GenericTable *table)
+{
+    GenericTable_Private *priv = table->priv;
+    _GenericTableBucket *bucket = &(priv->buckets);
+    long occupied = (long) bucket->used + priv->old_count;
+    if (occupied * 100 / bucket->size > priv->resize_threshold) return true;
+
+    return priv->auto_shrink
+        && (long) priv->item_count * 100 / bucket->size < priv->resize_threshold / 4
+        && _TargetSize(priv) < bucket->size;
+}
+
+/**
+ * 配置新容器並把目前的容器轉為舊容器，舊容器中的物件由之後的操作分批搬移
+ */
+static void _BeginResize(GenericTable_Private *priv, int new_size)
+{
+    // 上一次重構還沒完成就需要再次重構，先一次搬完
+    if (_IsRehashing(priv)) _RehashStep(priv, priv->old_buckets.size);
+
+    priv->layout_version++;
+    priv->old_buckets = priv->buckets;
+    priv->rehash_index = 0;
+    priv->old_count = priv->item_count;
+    _Init_Bucket(priv, &(priv->buckets), new_size);
+    if (!priv->buckets.ctrl) s_out_err("malloc new GenericTable bucket failed");
+
+    priv->modified_count = priv->item_count;
+}
+
+static inline long _NowNanos(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long) now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/**
+ * 依新舊大小累計擴充、縮減或以相同大小重構的次數
+ */
+static void _CountResize(GenericTable_Private *priv, int new_size)
+{
+    new_size = _RoundSize(priv, new_size);
+    if (new_size > priv->buckets.size)
+        priv->grow_count++;
+    else if (new_size < priv->buckets.size)
+        priv->shrink_count++;
+    else
+        priv->rehash_count++;
+}
+
+/**
+ * 先搬移一小段舊容器，再判斷是否需要重構，
+ * 重構時只配置新容器，舊容器中的物件由之後的操作分批搬移，
+ * 沒有進行中的重構也不需重構時直接返回，不計時
+ */
+static inline void _EnsureBucketSize(GenericTable *table)
+{
+    GenericTable_Private *priv = table->priv;
+    if (!_IsRehashing(priv) && !_NeedResize(table)) return;
+
+    long start = _NowNanos();
+    _RehashStep(priv, _REHASH_STEP);
+    if (_NeedResize(table))
+    {
+        int new_size = _TargetSize(priv);
+        _CountResize(priv, new_size);
+        // 保持插入順序時，重構的同時需要壓縮 entries，一次完成
+        if (priv->ordered)
+        {
+            _Ordered_Rebuild(priv, new_size);
+        }
+        else
+        {
+            _BeginResize(priv, new_size);
+            _RehashStep(priv, _REHASH_STEP);
+        }
+    }
+    priv->resize_nanos += _NowNanos() - start;
+}
+
+/**
+ * 立即重構成指定大小，不分批搬移
+ */
+static void _Resize(GenericTable_Private *priv, int new_size)
+{
+    long start = _NowNanos();
+    _CountResize(priv, new_size);
+    if (priv->ordered)
+    {
+        _Ordered_Rebuild(priv, new_size);
+    }
+    else
+    {
+        _BeginResize(priv, new_size);
+        _RehashStep(priv, priv->old_buckets.size);
+    }
+    priv->resize_nanos += _NowNanos() - start;
+}
+
+/**
+ * 以已算好的雜湊值查找 key 所在的容器與位置，先找目前的容器，重構中再找舊容器，不會修改映射表
+ */
+static _GenericTableBucket* _LocateHashed(GenericTable_Private *priv, const char *key, int key_len, uint64_t hash, int *p_index)
+{
+    int index = _Bucket_FindIndex(priv, &(priv->buckets), key, key_len, hash, NULL);
+    if (index >= 0)
+    {
+        *p_index = index;
+        return &(priv->buckets);
+    }
+    if (!_IsRehashing(priv)) return NULL;
+
+    index = _Bucket_FindIndex(priv, &(priv->old_buckets), key, key_len, hash, NULL);
+    if (index < 0) return NULL;
+
+    *p_index = index;
+    return &(priv->old_buckets);
+}
+
+/**
+ * 查找 key 所在的容器與位置
+ */
+static _GenericTableBucket* _Locate(GenericTable_Private *priv, const char *key, int *p_index)
+{
+    int key_len = strlen(key);
+    return _LocateHashed(priv, key, key_len, _Get_HashValue(priv, key, key_len), p_index);
+}
+
+/**
+ * 查找映射物件，只供讀取
+ */
+static GenericTableItem* _Find(GenericTable *table, const char *key)
+{
+    table = _ReadTable(table);
+    GenericTable_Private *priv = table->priv;
+    _LookupRehashStep(table);
+
+    int index;
+    _GenericTableBucket *bucket = _Locate(priv, key, &index);
+    _COUNT(&(priv->counters), finds, 1);
+    if (!bucket) return NULL;
+
+    _COUNT(&(priv->counters), find_hits, 1);
+    return _SlotItem(bucket, index);
+}
+
+/**
+ * 查找要回傳可修改指標且值為指定型態的映射物件，仍與快照共用時先換成複製的映射物件，
+ * 在快照中則讀取快照當下的版本，找不到或型態不符時不會修改映射表
+ */
+static GenericTableItem* _FindForWrite(GenericTable *table, const char *key, GenericTypeEnum type)
+{
+    if (CowUtil_ReadGeneration())
+    {
+        GenericTableItem *item = _Find(table, key);
+        return item && GenericType_IsType(_ItemValue(item), type) ? item : NULL;
+    }
+
+    GenericTable_Private *priv = table->priv;
+    CowUtil_PrepareWrite(&(priv->cow), &_COW_OPS, table);
+    _LookupRehashStep(table);
+
+    int index;
+    _GenericTableBucket *bucket = _Locate(priv, key, &index);
+    _COUNT(&(priv->counters), finds, 1);
+    if (!bucket) return NULL;
+
+    _COUNT(&(priv->counters), find_hits, 1);
+    if (!GenericType_IsType(_ItemValue(_SlotItem(bucket, index)), type)) return NULL;
+
+    // 呼叫端可能經由回傳的指標修改值
+    CowUtil_InvalidateHash(&(priv->cow));
+    return _OwnItem(table, bucket, index);
+}
+
+// ================================================================================
+// Public properties
+// ================================================================================
+GenericTableOptions GenericTable_DefaultOptions(void)
+{
+    GenericTableOptions options;
+    options.bucket_size = _DEFAULT_SIZE;
+    options.load_factor = _DEFAULT_LOAD_FACTOR;
+    options.hash_fn = HashUtil_WyHash;
+    options.seed = HashUtil_ProcessSeed();
+    options.probing = GENERIC_TABLE_PROBE_GROUP;
+    options.rehash_on_lookup = true;
+    options.auto_shrink = true;
+    options.sizing = GENERIC_TABLE_SIZE_PRIME;
+    options.ordered = false;
+    options.arena = NULL;
+    options.build_threads = 1;
+    options.intern_keys = false;
+    return options;
+}
+
+GenericTable* New_GenericTable(void) 
+{
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    return _New_GenericTable(&options);
+}
+
+GenericTable* New_GenericTable_WithBucketSize(int size) 
+{
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    options.bucket_size = size;
+    return _New_GenericTable(&options);
+}
+
+GenericTable* New_GenericTable_WithBucketSizeAndLoadFactor(int size, int load_factor)
+{
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    options.bucket_size = size;
+    options.load_factor = load_factor;
+    return _New_GenericTable(&options);
+}
+
+GenericTable* New_GenericTable_WithHasher(int size, int load_factor, GenericTableHashFn hash_fn, uint64_t seed)
+{
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    options.bucket_size = size;
+    options.load_factor = load_factor;
+    options.hash_fn = hash_fn;
+    options.seed = seed;
+    return _New_GenericTable(&options);
+}
+
+GenericTable* New_GenericTable_WithOptions(const GenericTableOptions *options)
+{
+    if (!options)
+    {
+        GenericTableOptions defaults = GenericTable_DefaultOptions();
+        return _New_GenericTable(&defaults);
+    }
+    return _New_GenericTable(options);
+}
+
+GenericTable* New_GenericTable_InArena(GenericArena *arena)
+{
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    options.arena = arena;
+    return _New_GenericTable(&options);
+}
+
+GenericArena* GenericTable_GetArena(GenericTable *table)
+{
+    return table->priv->arena;
+}
+
+GenericTable* GenericTable_Retain(GenericTable *table)
+{
+    atomic_fetch_add(&(table->priv->refs), 1);
+    return table;
+}
+
+CowUtil_State* GenericTable_GetCowState(GenericTable *table)
+{
+    return &(table->priv->cow);
+}
+
+void Delete_GenericTable(GenericTable **p_to_table) 
+{
+    GenericTable *table = *p_to_table;
+    GenericTable_Private *priv = table->priv;
+    *p_to_table = NULL;
+    if (atomic_fetch_sub(&(priv->refs), 1) > 1) return;
+
+    CowUtil_Destroy(&(priv->cow), &_COW_OPS, table);
+    // arena 中的映射表隨 arena 一起釋放
+    if (!priv->arena)
+    {
+        _Free_Bucket(priv, &(priv->buckets), true);
+        _Free_Bucket(priv, &(priv->old_buckets), true);
+        free(priv->entries.items);
+        while (priv->blocks)
+        {
+            _GenericTableBlock *next = priv->blocks->next;
+            free(priv->blocks->start);
+            free(priv->blocks);
+            priv->blocks = next;
+        }
+        free(priv);
+        free(table);
+    }
+} 
+
+/**
+ * GenericTable_Add_* 共用：確保容器大小後找到或放入 key，回傳要寫入的值，
+ * key 已存在時沿用原本的映射物件與值，由 GenericType_Set_* 就地覆寫
+ */
+static GenericType* _Upsert(GenericTable *table, const char *key)
+{
+    if (!_BeginModify(table)) return NULL;
+
+    _EnsureBucketSize(table);
+    bool inserted;
+    GenericTableItem *item = _FindOrInsert(table, key, &inserted);
+    if (!item) return NULL;
+
+    if (!inserted)
+    {
+        table->priv->modified_count++;
+        _COUNT(&(table->priv->counters), updates, 1);
+    }
+    return _ItemValue(item);
+}
+
+void GenericTable_Add_Str(GenericTable *table, const char *key, const char *value)
+{
+    GenericType *gen_obj = _Upsert(table, key);
+    if (gen_obj) GenericType_Set_Str(gen_obj, value);
+}
+
+void GenericTable_Add_Int(GenericTable *table, const char *key, int value)
+{
+    GenericType *gen_obj = _Upsert(table, key);
+    if (gen_obj) GenericType_Set_Int(gen_obj, value);
+}
+
+void GenericTable_Add_Long(GenericTable *table, const char *key, long value)
+{
+    GenericType *gen_obj = _Upsert(table, key);
+    if (gen_obj) GenericType_Set_Long(gen_obj, value);
+}
+
+void GenericTable_Add_Double(GenericTable *table, const char *key, double value)
+{
+    GenericType *gen_obj = _Upsert(table, key);
+    if (gen_obj) GenericType_Set_Double(gen_obj, value);
+}
+
+void GenericTable_Add_Float(GenericTable *table, const char *key, float value)
+{
+    GenericType *gen_obj = _Upsert(table, key);
+    if (gen_obj) GenericType_Set_Float(gen_obj, value);
+}
+
+void GenericTable_Add_Table(GenericTable *table, const char *key, GenericTable *value)
+{
+    GenericType *gen_obj = _Upsert(table, key);
+    if (gen_obj) GenericType_Set_Table(gen_obj, value);
+}
+
+void GenericTable_Add_List(GenericTable *table, const char *key, struct GenericList *value)
+{
+    GenericType *gen_obj = _Upsert(table, key);
+    if (gen_obj) GenericType_Set_List(gen_obj, value);
+}
+
+GenericType* GenericTable_GetOrInsert(GenericTable *table, const char *key, bool *p_inserted)
+{
+    if (!_BeginModify(table)) return NULL;
+
+    _EnsureBucketSize(table);
+    bool inserted;
+    GenericTableItem *item = _FindOrInsert(table, key, &inserted);
+    if (p_inserted) *p_inserted = inserted;
+    return item ? _ItemValue(item) : NULL;
+}
+
+const char* GenericTable_Find_Str(GenericTable *table, const char *key)
+{
+    GenericTableItem *item = _Find(table, key);
+    if (!item) return NULL;
+
+    GenericType *gen = _ItemValue(item);
+    if (!GenericType_IsType(gen, GEN_TYPE_STR)) return NULL;
+    
+    return GenericType_GetStr(gen);
+}
+
+int* GenericTable_Find_Int(GenericTable *table, const char *key)
+{
+    GenericTableItem *item = _FindForWrite(table, key, GEN_TYPE_INT);
+    if (!item) return NULL;
+
+    return GenericType_GetInt(_ItemValue(item));
+}
+
+long* GenericTable_Find_Long(GenericTable *table, const char *key)
+{
+    GenericTableItem *item = _FindForWrite(table, key, GEN_TYPE_LONG);
+    if (!item) return NULL;
+
+    return GenericType_GetLong(_ItemValue(item));
+}
+
+double* GenericTable_Find_Double(GenericTable *table, const char *key)
+{
+    GenericTableItem *item = _FindForWrite(table, key, GEN_TYPE_DOUBLE);
+    if (!item) return NULL;
+
+    return GenericType_GetDouble(_ItemValue(item));
+}
+
+float* GenericTable_Find_Float(GenericTable *table, const char *key)
+{
+    GenericTableItem *item = _FindForWrite(table, key, GEN_TYPE_FLOAT);
+    if (!item) return NULL;
+
+    return GenericType_GetFloat(_ItemValue(item));
+}
+
+GenericTable* GenericTable_Find_Table(GenericTable *table, const char *key)
+{
+    GenericTableItem *item = _Find(table, key);
     if (!item) return NULL;
 
-    GenericType *gen = item->value;
-    if (!item || !GenericType_IsType(gen, GEN_TYPE_FLOAT)) return NULL;
-    
-    return GenericType_GetFloat(gen);
+    GenericType *gen = _ItemValue(item);
+    if (!GenericType_IsType(gen, GEN_TYPE_TABLE)) return NULL;
+    
+    return GenericType_GetTable(gen);
+}
+
+GenericTypeEnum GenericTable_ValueType(GenericTable *table, const char *key)
+{
+    GenericTableItem *item = _Find(table, key);
+    if (!item) return -1;
+
+    return GenericType_GetType(_ItemValue(item));
+}
+
+void GenericTable_Delete(GenericTable *table, const char *key)
+{
+    GenericTable_Private *priv = table->priv;
+    if (!_BeginModify(table)) return;
+
+    int index;
+    _GenericTableBucket *bucket = _Locate(priv, key, &index);
+    if (bucket)
+    {
+        GenericTableItem *item = _SlotItem(bucket, index);
+        if (priv->ordered) priv->entries.items[item->entry_index] = NULL;
+        _Retire_Item(table, item);
+        if (bucket == &(priv->buckets))
+        {
+            _Bucket_Erase(priv, bucket, index);
+        }
+        else
+        {
+            _Vacate(bucket, index);
+            priv->old_count--;
+        }
+        priv->item_count--;
+        priv->modified_count++;
+        priv->layout_version++;
+    }
+
+    _EnsureBucketSize(table);
+}
+
+void GenericTable_Reserve(GenericTable *table, int count)
+{
+    GenericTable_Private *priv = table->priv;
+    if (count < 0)
+    {
+        s_out_err_f("GenericTable_Reserve count '%d' is negative", count);
+        return;
+    }
+    if (!_BeginModify(table)) return;
+
+    priv->reserved_size = _CapacityFor(priv, count);
+    if (priv->buckets.size < priv->reserved_size) _Resize(priv, priv->reserved_size);
+}
+
+void GenericTable_ShrinkToFit(GenericTable *table)
+{
+    GenericTable_Private *priv = table->priv;
+    if (!_BeginModify(table)) return;
+
+    priv->reserved_size = 0;
+    // 先搬完舊容器，縮減後也不會留下已刪除的位置
+    if (_IsRehashing(priv)) _RehashStep(priv, priv->old_buckets.size);
+
+    int new_size = _CapacityFor(priv, priv->item_count);
+    if (new_size < priv->buckets.size || priv->buckets.used > priv->item_count) _Resize(priv, new_size);
+}
+
+int GenericTable_Capacity(GenericTable *table)
+{
+    return _ReadTable(table)->priv->buckets.size;
+}
+
+bool GenericTable_HasKey(GenericTable *table, const char *key)
+{
+    return _Find(table, key) != NULL;
+}
+
+/**
+ * 批次查找一輪最多 _BATCH_WIDTH 個 key：
+ * 先計算全部 key 的雜湊值並預取起始群組的控制位元組與映射物件指標，
+ * 再預取標記相符的映射物件，最後才逐一比對，讓多個 cache miss 同時進行
+ */
+static void _FindBatch(GenericTable_Private *priv, const char **keys, int n, GenericTableItem **out_items)
+{
+    _GenericTableBucket *bucket = &(priv->buckets);
+    uint64_t hashes[_BATCH_WIDTH];
+    int lens[_BATCH_WIDTH];
+    int homes[_BATCH_WIDTH];
+
+    for (int i = 0; i < n; i++)
+    {
+        lens[i] = strlen(keys[i]);
+        hashes[i] = _Get_HashValue(priv, keys[i], lens[i]);
+        homes[i] = _HomeIndex(bucket, hashes[i]);
+        __builtin_prefetch(bucket->ctrl + homes[i]);
+        if (bucket->indices)
+            __builtin_prefetch(bucket->indices + homes[i]);
+        else
+            __builtin_prefetch(bucket->items + homes[i]);
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        if (_IsRobinHood(priv))
+        {
+            if (bucket->ctrl[homes[i]] >= 0) __builtin_prefetch(_SlotItem(bucket, homes[i]));
+            continue;
+        }
+        _GroupMask match = _Group_Match(bucket->ctrl + homes[i], _HashTag(hashes[i]));
+        if (match) __builtin_prefetch(_SlotItem(bucket, _SlotOf(bucket, homes[i], _LowestBit(match))));
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        out_items[i] = NULL;
+        int index = _Bucket_FindIndex(priv, bucket, keys[i], lens[i], hashes[i], NULL);
+        if (index >= 0)
+        {
+            out_items[i] = _SlotItem(bucket, index);
+        }
+        else if (_IsRehashing(priv))
+        {
+            index = _Bucket_FindIndex(priv, &(priv->old_buckets), keys[i], lens[i], hashes[i], NULL);
+            if (index >= 0) out_items[i] = _SlotItem(&(priv->old_buckets), index);
+        }
+        _COUNT(&(priv->counters), finds, 1);
+        _COUNT(&(priv->counters), find_hits, out_items[i] != NULL);
+    }
+}
+
+void GenericTable_FindMany(GenericTable *table, const char **keys, int n, struct GenericType **out_values)
+{
+    table = _ReadTable(table);
+    GenericTable_Private *priv = table->priv;
+    GenericTableItem *items[_BATCH_WIDTH];
+    _LookupRehashStep(table);
+
+    for (int begin = 0; begin < n; begin += _BATCH_WIDTH)
+    {
+        int count = n - begin < _BATCH_WIDTH ? n - begin : _BATCH_WIDTH;
+        _FindBatch(priv, keys + begin, count, items);
+        for (int i = 0; i < count; i++)
+        {
+            out_values[begin + i] = items[i] ? _ItemValue(items[i]) : NULL;
+        }
+    }
+}
+
+void GenericTable_HasKeyMany(GenericTable *table, const char **keys, int n, bool *out_results)
+{
+    table = _ReadTable(table);
+    GenericTable_Private *priv = table->priv;
+    GenericTableItem *items[_BATCH_WIDTH];
+    _LookupRehashStep(table);
+
+    for (int begin = 0; begin < n; begin += _BATCH_WIDTH)
+    {
+        int count = n - begin < _BATCH_WIDTH ? n - begin : _BATCH_WIDTH;
+        _FindBatch(priv, keys + begin, count, items);
+        for (int i = 0; i < count; i++)
+        {
+            out_results[begin + i] = items[i] != NULL;
+        }
+    }
+}
+
+/**
+ * 計算在單一容器中查找 key 需要探測的群組數量
+ */
+static int _Group_ProbeLength(_GenericTableBucket *bucket, const char *key, int key_len, uint64_t hash, bool *p_found)
+{
+    signed char tag = _HashTag(hash);
+    int pos = _HomeIndex(bucket, hash);
+
+    int probe = 0;
+    while (probe < _MaxProbeGroups(bucket))
+    {
+        const signed char *group = bucket->ctrl + pos;
+        probe++;
+
+        _GroupMask match = _Group_Match(group, tag);
+        while (match)
+        {
+            int index = _SlotOf(bucket, pos, _LowestBit(match));
+            if (_IsSameKey(_SlotItem(bucket, index), key, key_len, hash))
+            {
+                *p_found = true;
+                return probe;
+            }
+            match &= match - 1;
+        }
+        if (_Group_MatchEmpty(group)) break;
+
+        pos = _NextGroup(bucket, pos);
+    }
+    *p_found = false;
+    return probe;
+}
+
+/**
+ * 從起始位置 home 查找不存在的 key 需要探測的位置數量，與 _RobinHood_FindIndex 相同的結束條件
+ */
+static int _RobinHood_MissLength(_GenericTableBucket *bucket, int home)
+{
+    int index = home;
+    int probe = 1;
+    for (int distance = 0; distance < bucket->size; distance++, probe++)
+    {
+        signed char ctrl = bucket->ctrl[index];
+        if (ctrl == _CTRL_EMPTY) break;
+        if (ctrl >= 0 && _RobinHood_Distance(bucket, index, _SlotItem(bucket, index)) < distance) break;
+        index = _RobinHood_Next(bucket, index);
+    }
+    return probe;
+}
+
+/**
+ * 從起始位置 home 查找不存在的 key 需要探測的群組數量，遇到有空位的群組即結束
+ */
+static int _Group_MissLength(_GenericTableBucket *bucket, int home)
+{
+    int pos = home;
+    int probe = 1;
+    while (probe < _MaxProbeGroups(bucket) && !_Group_MatchEmpty(bucket->ctrl + pos))
+    {
+        pos = _NextGroup(bucket, pos);
+        probe++;
+    }
+    return probe;
+}
+
+/**
+ * 計算在單一容器中查找 key 需要探測的位置數量
+ */
+static int _RobinHood_ProbeLength(_GenericTableBucket *bucket, const char *key, int key_len, uint64_t hash, bool *p_found)
+{
+    int found_index = _RobinHood_FindIndex(bucket, key, key_len, hash);
+    int home = _HomeIndex(bucket, hash);
+    *p_found = found_index >= 0;
+    if (*p_found)
+    {
+        int distance = found_index - home;
+        if (distance < 0) distance += bucket->size;
+        return distance + 1;
+    }
+
+    return _RobinHood_MissLength(bucket, home);
+}
+
+static inline int _ProbeLength(
+    GenericTable_Private *priv, _GenericTableBucket *bucket,
+    const char *key, int key_len, uint64_t hash, bool *p_found
+) {
+    if (_IsRobinHood(priv)) return _RobinHood_ProbeLength(bucket, key, key_len, hash, p_found);
+    return _Group_ProbeLength(bucket, key, key_len, hash, p_found);
+}
+
+int GenericTable_ProbeLength(GenericTable *table, const char *key)
+{
+    table = _ReadTable(table);
+    GenericTable_Private *priv = table->priv;
+    int key_len = strlen(key);
+    uint64_t hash = _Get_HashValue(priv, key, key_len);
+
+    bool found;
+    int probe = _ProbeLength(priv, &(priv->buckets), key, key_len, hash, &found);
+    if (!found && _IsRehashing(priv))
+    {
+        probe += _ProbeLength(priv, &(priv->old_buckets), key, key_len, hash, &found);
+    }
+    return probe;
+}
+
+/**
+ * 把探測長度計入直方圖，超過直方圖大小的計入最後一格
+ */
+static inline void _Histogram_Add(int *histogram, int probe)
+{
+    int slot = probe < GENERIC_TABLE_PROBE_HISTOGRAM_SIZE ? probe : GENERIC_TABLE_PROBE_HISTOGRAM_SIZE;
+    histogram[slot - 1]++;
+}
+
+/**
+ * 已存在的映射物件需要的探測長度，由位置與起始位置的距離直接算出，不必比對 key，也不經過計數的探測迴圈：
+ * Robin Hood 探測逐一位置前進，群組探測從起始位置起每次前進一個群組
+ */
+static inline int _Stats_HitLength(GenericTable_Private *priv, _GenericTableBucket *bucket, int index)
+{
+    int distance = _RobinHood_Distance(bucket, index, _SlotItem(bucket, index));
+    return _IsRobinHood(priv) ? distance + 1 : distance / _GROUP_WIDTH + 1;
+}
+
+/**
+ * 走訪容器中的每個映射物件，累計找到它需要的探測長度與另外存放的 key 佔用的記憶體
+ */
+static void _Stats_CollectHits(
+    GenericTable_Private *priv, _GenericTableBucket *bucket, GenericTableStats *stats, long *p_total
+) {
+    for (int i = 0; i < bucket->size; i++)
+    {
+        if (bucket->ctrl[i] < 0) continue;
+
+        GenericTableItem *item = _SlotItem(bucket, i);
+        int probe = _Stats_HitLength(priv, bucket, i);
+        _Histogram_Add(stats->hit_histogram, probe);
+        *p_total += probe;
+        if (probe > stats->max_probe) stats->max_probe = probe;
+        if (!_IsInlineKey(item->key_len)) stats->bytes_used += (size_t) item->key_len + 1;
+    }
+}
+
+static size_t _Stats_BucketBytes(_GenericTableBucket *bucket)
+{
+    if (!bucket->ctrl) return 0;
+
+    size_t slot_size = bucket->indices ? sizeof(int32_t) : sizeof(GenericTableItem*);
+    return (size_t) bucket->size * (1 + slot_size) + _GROUP_WIDTH;
+}
+
+void GenericTable_GetStats(GenericTable *table, GenericTableStats *stats)
+{
+    table = _ReadTable(table);
+    GenericTable_Private *priv = table->priv;
+    _GenericTableBucket *bucket = &(priv->buckets);
+    memset(stats, 0, sizeof(GenericTableStats));
+
+    stats->capacity = bucket->size;
+    stats->old_capacity = _IsRehashing(priv) ? priv->old_buckets.size : 0;
+    stats->item_count = priv->item_count;
+    stats->tombstones = bucket->used - (priv->item_count - priv->old_count);
+    stats->modified_count = priv->modified_count;
+    stats->load_factor = (double) bucket->used / bucket->size;
+    stats->grow_count = priv->grow_count;
+    stats->shrink_count = priv->shrink_count;
+    stats->rehash_count = priv->rehash_count;
+    stats->resize_nanos = priv->resize_nanos;
+
+    stats->bytes_used = GenericTable_BytesUsed(table);
+
+#if defined(GENERIC_TABLE_ENABLE_STATS)
+    stats->counters_enabled = true;
+    stats->find_count = __atomic_load_n(&(priv->counters.finds), __ATOMIC_RELAXED);
+    stats->find_hit_count = __atomic_load_n(&(priv->counters.find_hits), __ATOMIC_RELAXED);
+    stats->probe_count = __atomic_load_n(&(priv->counters.probes), __ATOMIC_RELAXED);
+    stats->insert_count = __atomic_load_n(&(priv->counters.inserts), __ATOMIC_RELAXED);
+    stats->update_count = __atomic_load_n(&(priv->counters.updates), __ATOMIC_RELAXED);
+#endif
+}
+
+void GenericTable_GetDeepStats(GenericTable *table, GenericTableStats *stats)
+{
+    GenericTable_GetStats(table, stats);
+    GenericTable_Private *priv = _ReadTable(table)->priv;
+    _GenericTableBucket *bucket = &(priv->buckets);
+
+    long hit_total = 0;
+    _Stats_CollectHits(priv, bucket, stats, &hit_total);
+    if (_IsRehashing(priv)) _Stats_CollectHits(priv, &(priv->old_buckets), stats, &hit_total);
+    if (priv->item_count > 0) stats->average_hit_probe = (double) hit_total / priv->item_count;
+
+    // 雜湊值的起始位置平均分布在每個位置上，逐一計算每個起始位置即為查找不存在的 key 的分布
+    long miss_total = 0;
+    for (int home = 0; home < bucket->size; home++)
+    {
+        int probe = _IsRobinHood(priv) ? _RobinHood_MissLength(bucket, home) : _Group_MissLength(bucket, home);
+        _Histogram_Add(stats->miss_histogram, probe);
+        miss_total += probe;
+    }
+    stats->average_miss_probe = (double) miss_total / bucket->size;
+}
+
+size_t GenericTable_BytesUsed(GenericTable *table)
+{
+    GenericTable_Private *priv = _ReadTable(table)->priv;
+    size_t bytes = sizeof(GenericTable) + sizeof(GenericTable_Private)
+        + _Stats_BucketBytes(&(priv->buckets)) + _Stats_BucketBytes(&(priv->old_buckets))
+        + (size_t) priv->item_count * _ItemSize();
+    if (priv->ordered) bytes += (size_t) priv->entries.capacity * sizeof(GenericTableItem*);
+    return bytes;
+}
+
+int GenericTable_Size(GenericTable *table)
+{
+    return _ReadTable(table)->priv->item_count;
+}
+
+inline bool GenericTable_IsEmpty(GenericTable *table)
+{
+    return GenericTable_Size(table) == 0;
+}
+
+char* GenericTableItem_GetKey(GenericTableItem *item)
+{
+    return _ItemKey(item);
+}
+
+struct GenericType* GenericTableItem_GetValue(GenericTableItem *item)
+{
+    return _ItemValue(item);
+}
+
+static void _CollectItems(GenericTableIterator *iterator, _GenericTableBucket *bucket)
+{
+    for (int i = 0; i < bucket->size; i++) 
+    {
+        if (bucket->ctrl[i] < 0) continue;
+        iterator->items[iterator->last] = _SlotItem(bucket, i);
+        iterator->last++;
+    }
+}
+
+/**
+ * 依插入順序收集，只需線性掃過緊密排列的 entries
+ */
+static void _CollectEntries(GenericTableIterator *iterator, _GenericTableEntries *entries)
+{
+    for (int i = 0; i < entries->count; i++)
+    {
+        if (!entries->items[i]) continue;
+        iterator->items[iterator->last] = entries->items[i];
+        iterator->last++;
+    }
+}
+
+GenericTableIterator* GenericTable_GetIterator(GenericTable *table)
+{
+    table = _ReadTable(table);
+    int iterator_size = table->priv->item_count;
+    GenericTableIterator *iterator = (GenericTableIterator*) malloc(sizeof(GenericTableIterator));
+    GenericTableItem **items = (GenericTableItem**) calloc(iterator_size, sizeof(GenericTableItem*));
+    iterator->next = 0;
+    iterator->last = 0;
+    iterator->items = items;
+    if (table->priv->ordered)
+    {
+        _CollectEntries(iterator, &(table->priv->entries));
+        return iterator;
+    }
+    _CollectItems(iterator, &(table->priv->buckets));
+    if (_IsRehashing(table->priv)) _CollectItems(iterator, &(table->priv->old_buckets));
+    return iterator;
+}
+
+bool GenericTableIterator_HasNext(GenericTableIterator *iterator)
+{
+    return iterator->next < iterator->last;
 }
 
-GenericTable* GenericTable_Find_Table(GenericTable *table, const char *key)
+GenericTableItem* GenericTableIterator_Next(GenericTableIterator *iterator)
 {
-    GenericTableItem *item = _Find(table, key);
-    if (!item) return NULL;
+    GenericTableItem *item = iterator->items[iterator->next];
+    iterator->next++;
+    return item;
+}
 
-    GenericType *gen = item->value;
-    if (!item || !GenericType_IsType(gen, GEN_TYPE_TABLE)) return NULL;
-    
-    return GenericType_GetTable(gen);
+void Delete_GenericTableIterator(GenericTableIterator **p_iterator)
+{
+    GenericTableIterator *iterator = *p_iterator;
+    // iterator->items 中的 GenericTableItem 還需要使用，只釋放 iterator->items 本身
+    free(iterator->items);
+    free(iterator);
+    *p_iterator = NULL;
 }
 
-GenericTypeEnum GenericTable_ValueType(GenericTable *table, const char *key)
+// ================================================================================
+// Cursor：直接走訪容器，不配置記憶體
+// ================================================================================
+// cursor->phase 的值
+#define _CURSOR_BUCKETS 0
+#define _CURSOR_OLD_BUCKETS 1
+#define _CURSOR_END 2
+
+/**
+ * 從 from 開始找下一個已使用的位置，以群組比對一次跳過 16 個空位，找不到時回傳 -1
+ */
+static int _NextUsedSlot(_GenericTableBucket *bucket, int from)
 {
-    GenericTableItem *item = _Find(table, key);
-    if (!item) return -1;
+    for (int pos = from; pos < bucket->size; pos += _GROUP_WIDTH)
+    {
+        _GroupMask mask = ~_Group_MatchEmptyOrDeleted(bucket->ctrl + pos) & 0xffffu;
+        if (mask)
+        {
+            // 超出容器大小的位元是開頭位置的副本，不需要再看
+            int slot = pos + _LowestBit(mask);
+            return slot < bucket->size ? slot : -1;
+        }
+    }
+    return -1;
+}
+
+/**
+ * 從頭走訪 table 的游標，不搬移舊容器，重構中時走完目前的容器再走舊容器
+ */
+static GenericTable_Cursor _ReadCursor(GenericTable *table)
+{
+    GenericTable_Cursor cursor;
+    cursor.table = table;
+    cursor.index = 0;
+    cursor.phase = _CURSOR_BUCKETS;
+    cursor.layout_version = table->priv->layout_version;
+    cursor.invalidated = false;
+    return cursor;
+}
 
-    return GenericType_GetType(item->value);
+GenericTable_Cursor GenericTable_Begin(GenericTable *table)
+{
+    table = _ReadTable(table);
+    GenericTable_Private *priv = table->priv;
+    // 查找會搬移舊容器時先一次搬完，迭代期間的查找才不會移動映射物件
+    if (priv->rehash_on_lookup && _IsRehashing(priv) && _BeginModify(table))
+    {
+        _RehashStep(priv, priv->old_buckets.size);
+    }
+    return _ReadCursor(table);
 }
 
-void GenericTable_Delete(GenericTable *table, const char *key)
+/**
+ * 依插入順序走訪 entries，跳過已刪除的位置
+ */
+static GenericTableItem* _Cursor_NextEntry(GenericTable_Cursor *cursor, _GenericTableEntries *entries)
+{
+    while (cursor->index < entries->count)
+    {
+        GenericTableItem *item = entries->items[cursor->index++];
+        if (item) return item;
+    }
+    return NULL;
+}
+
+static GenericTableItem* _Cursor_NextSlot(GenericTable_Cursor *cursor, _GenericTableBucket *bucket)
+{
+    int slot = _NextUsedSlot(bucket, cursor->index);
+    if (slot < 0) return NULL;
+    cursor->index = slot + 1;
+    return _SlotItem(bucket, slot);
+}
+
+/**
+ * 下一個映射物件，保持插入順序時依 entries，否則依容器的位置，走完時回傳 NULL
+ */
+static GenericTableItem* _Cursor_NextItem(GenericTable_Cursor *cursor)
+{
+    GenericTable_Private *priv = cursor->table->priv;
+    if (priv->ordered) return _Cursor_NextEntry(cursor, &(priv->entries));
+
+    GenericTableItem *item = NULL;
+    if (cursor->phase == _CURSOR_BUCKETS)
+    {
+        item = _Cursor_NextSlot(cursor, &(priv->buckets));
+        if (!item && _IsRehashing(priv))
+        {
+            cursor->phase = _CURSOR_OLD_BUCKETS;
+            cursor->index = 0;
+        }
+    }
+    if (!item && cursor->phase == _CURSOR_OLD_BUCKETS)
+    {
+        item = _Cursor_NextSlot(cursor, &(priv->old_buckets));
+    }
+    return item;
+}
+
+bool GenericTable_Next(GenericTable_Cursor *cursor, const char **p_key, struct GenericType **p_value)
+{
+    if (cursor->phase == _CURSOR_END) return false;
+
+    GenericTable_Private *priv = cursor->table->priv;
+    if (cursor->layout_version != priv->layout_version)
+    {
+        cursor->invalidated = true;
+        cursor->phase = _CURSOR_END;
+        return false;
+    }
+
+    GenericTableItem *item = _Cursor_NextItem(cursor);
+    if (!item)
+    {
+        cursor->phase = _CURSOR_END;
+        return false;
+    }
+    if (p_key) *p_key = _ItemKey(item);
+    if (p_value) *p_value = _ItemValue(item);
+    return true;
+}
+
+bool GenericTable_CursorInvalidated(const GenericTable_Cursor *cursor)
+{
+    return cursor->invalidated;
+}
+
+/**
+ * 走訪容器中每個已使用的位置，取得可修改的值後交給 fn
+ */
+static void _ForEachOwnedValue(GenericTable *table, _GenericTableBucket *bucket, GenericTable_ValueFn fn, void *arg)
+{
+    for (int slot = _NextUsedSlot(bucket, 0); slot >= 0; slot = _NextUsedSlot(bucket, slot + 1))
+    {
+        fn(_ItemValue(_OwnItem(table, bucket, slot)), arg);
+    }
+}
+
+void GenericTable_ForEachValue(GenericTable *table, GenericTable_ValueFn fn, void *arg)
+{
+    if (!_PrepareWrite(table)) return;
+
+    GenericTable_Private *priv = table->priv;
+    _ForEachOwnedValue(table, &(priv->buckets), fn, arg);
+    if (_IsRehashing(priv)) _ForEachOwnedValue(table, &(priv->old_buckets), fn, arg);
+}
+
+// ================================================================================
+// 結構雜湊與比較：只讀取，不搬移舊容器，不會修改映射表
+// ================================================================================
+/**
+ * key 的雜湊值，映射表與字串池的雜湊函式相同時直接使用映射物件記下的值
+ */
+static inline uint64_t _ItemKeyHash(GenericTable_Private *priv, GenericTableItem *item)
+{
+    if (priv->intern_hash_shared) return item->hash;
+    return GenericString_HashOf(_ItemKey(item), (size_t) item->key_len);
+}
+
+uint64_t GenericTable_Hash(GenericTable *table)
 {
+    if (!table)
+    {
+        s_out_err("the GenericTable pointer is null at GenericTable_Hash!");
+        return 0;
+    }
+    // 快照中讀取的是凍結的版本，不記下雜湊值
+    bool cacheable = !CowUtil_ReadGeneration();
+    table = _ReadTable(table);
     GenericTable_Private *priv = table->priv;
+    uint64_t hash = cacheable ? CowUtil_CachedHash(&(priv->cow)) : 0;
+    if (hash) return hash;
+
+    // 每個映射物件各自混合 key 與值後相加，與走訪順序、容器大小無關
+    uint64_t sum = 0;
+    GenericTable_Cursor cursor = _ReadCursor(table);
     GenericTableItem *item;
-    int index, addition;
+    while ((item = _Cursor_NextItem(&cursor)))
+    {
+        sum += HashUtil_Mix(_ItemKeyHash(priv, item), GenericType_Hash(_ItemValue(item)));
+    }
+    hash = HashUtil_Mix(sum, (uint64_t) priv->item_count);
+    if (!hash) hash = 1;
+    if (cacheable) CowUtil_SetCachedHash(&(priv->cow), hash);
+    return hash;
+}
 
-    addition = 0;
-    while (true)
+bool GenericTable_Equals(GenericTable *table1, GenericTable *table2)
+{
+    if (!table1 || !table2)
+    {
+        s_out_err("the GenericTable pointer is null at GenericTable_Equals!");
+        return false;
+    }
+    if (table1 == table2) return true;
+
+    table1 = _ReadTable(table1);
+    table2 = _ReadTable(table2);
+    GenericTable_Private *priv1 = table1->priv;
+    GenericTable_Private *priv2 = table2->priv;
+    if (priv1->item_count != priv2->item_count) return false;
+    if (!CowUtil_ReadGeneration())
     {
-        index = _Get_HashValue(key, priv->bucket_size, addition);
-        item = priv->items[index];
-        addition++;
+        uint64_t hash1 = CowUtil_CachedHash(&(priv1->cow));
+        uint64_t hash2 = CowUtil_CachedHash(&(priv2->cow));
+        if (hash1 && hash2 && hash1 != hash2) return false;
+    }
 
-        if (item == NULL) break;
-        if (_IsAbandoned(item) || strcmp(item->key, key) != 0) continue;
+    // 雜湊函式與種子相同時，table2 直接以 table1 記下的雜湊值查找
+    bool same_hasher = priv1->hash_fn == priv2->hash_fn && priv1->seed == priv2->seed;
+    GenericTable_Cursor cursor = _ReadCursor(table1);
+    GenericTableItem *item;
+    while ((item = _Cursor_NextItem(&cursor)))
+    {
+        char *key = _ItemKey(item);
+        uint64_t hash = same_hasher ? item->hash : _Get_HashValue(priv2, key, item->key_len);
+        int index;
+        _GenericTableBucket *bucket = _LocateHashed(priv2, key, item->key_len, hash, &index);
+        if (!bucket) return false;
+        if (!GenericType_Equals(_ItemValue(item), _ItemValue(_SlotItem(bucket, index)))) return false;
+    }
+    return true;
+}
 
-        _Delete_GenericTableItem(item);
-        priv->items[index] = &_DELETED_ITEM;
-        priv->item_count--;
-        priv->modified_count++;
-        break;
+// ================================================================================
+// Snapshot
+// ================================================================================
+GenericTableSnapshot* GenericTable_Snapshot(GenericTable *table)
+{
+    if (CowUtil_ReadGeneration())
+    {
+        s_out_err("GenericTable_Snapshot can not be called inside a snapshot");
+        return NULL;
     }
+    GenericTableSnapshot *snapshot = (GenericTableSnapshot*) malloc(sizeof(GenericTableSnapshot));
+    snapshot->root = GenericTable_Retain(table);
+    snapshot->generation = CowUtil_BeginSnapshot(&(table->priv->cow));
+    return snapshot;
+}
 
-    _EnsureBucketSize(table);
+GenericTable* GenericTableSnapshot_Begin(GenericTableSnapshot *snapshot)
+{
+    if (CowUtil_ReadGeneration())
+    {
+        s_out_err("GenericTableSnapshot_Begin can not be nested");
+        return NULL;
+    }
+    CowUtil_SetReadGeneration(snapshot->generation);
+    return snapshot->root;
 }
 
-bool GenericTable_HasKey(GenericTable *table, const char *key)
+void GenericTableSnapshot_End(GenericTableSnapshot *snapshot)
 {
-    GenericTableItem *item = _Find(table, key);
-    return _IsValid(item);
+    (void) snapshot;
+    CowUtil_SetReadGeneration(0);
 }
 
-int GenericTable_Size(GenericTable *table)
+void Delete_GenericTableSnapshot(GenericTableSnapshot **p_snapshot)
 {
-    return table->priv->item_count;
+    GenericTableSnapshot *snapshot = *p_snapshot;
+    CowUtil_EndSnapshot(snapshot->generation);
+    Delete_GenericTable(&(snapshot->root));
+    free(snapshot);
+    *p_snapshot = NULL;
 }
 
-inline bool GenericTable_IsEmpty(GenericTable *table)
+// ================================================================================
+// 批次建構：容器大小一次決定，雜湊、建構值、複製 key 各自整批處理，
+// 多執行緒時依起始位置把容器切成連續的區段，每個執行緒只放入起始位置在自己區段內的 key
+// ================================================================================
+#define _BULK_MAX_THREADS 64
+
+// 每個執行緒至少分到的 key 數量，太少時建立執行緒的成本比省下的時間多
+#define _BULK_MIN_KEYS_PER_THREAD 0X1000
+
+typedef struct _BulkBuild
 {
-    return GenericTable_Size(table) == 0;
+    GenericTable_Private *priv;
+    const char **keys;
+    const void **values;
+    const GenericTypeEnum *types;
+    int n;
+    int threads;
+    /**
+     * 依序緊密排列的映射物件(連同值)，重複的 key 只有第一個映射物件會留在容器中
+     */
+    char *items;
+    size_t item_size;
+    /**
+     * 放不進 inline_key 的 key，依序緊密排列
+     */
+    char *key_block;
+    /**
+     * 每個執行緒負責的 key 在 key_block 中的起始位置
+     */
+    size_t key_offsets[_BULK_MAX_THREADS];
+    /**
+     * 依區段分組的 key 編號，區段內維持原本的順序
+     */
+    int *order;
+    /**
+     * counts[t * threads + p]: 執行緒 t 負責的 key 中起始位置在區段 p 的數量，分組時改為寫入位置
+     */
+    int *counts;
+    int partition_begin[_BULK_MAX_THREADS + 1];
+    int placed[_BULK_MAX_THREADS];
+    /**
+     * 探測超出區段結尾、留到最後依序放入的數量，存放在 order 中區段的開頭
+     */
+    int deferred[_BULK_MAX_THREADS];
+} _BulkBuild;
+
+typedef void (*_BulkPhase)(_BulkBuild *build, int id);
+
+typedef struct _BulkTask
+{
+    _BulkBuild *build;
+    _BulkPhase phase;
+    int id;
+} _BulkTask;
+
+/**
+ * 把 [0, size) 切成 parts 段，回傳第 part 段的開頭，
+ * 起始位置 home 所在的區段為 home * parts / size
+ */
+static inline int _Bulk_Bound(int size, int parts, int part)
+{
+    return (int) (((long) part * size + parts - 1) / parts);
 }
 
-char* GenericTableItem_GetKey(GenericTableItem *item)
+static inline GenericTableItem* _Bulk_Item(_BulkBuild *build, int i)
 {
-    return item->key;
+    return (GenericTableItem*) (build->items + (size_t) i * build->item_size);
 }
 
-struct GenericType* GenericTableItem_GetValue(GenericTableItem *item)
+static inline int _Bulk_Partition(_BulkBuild *build, int home)
 {
-    return item->value;
+    return (int) ((long) home * build->threads / build->priv->buckets.size);
 }
 
-GenericTableIterator* GenericTable_GetIterator(GenericTable *table)
+static void* _Bulk_Thread(void *arg)
 {
-    int iterator_size = table->priv->item_count;
-    GenericTableIterator *iterator = (GenericTableIterator*) malloc(sizeof(GenericTableIterator));
-    GenericTableItem **items = (GenericTableItem**) calloc(iterator_size, sizeof(GenericTableItem*));
-    iterator->next = 0;
-    iterator->last = 0;
-    iterator->items = items;
-    for (int i = 0; i < table->priv->bucket_size; i++) 
+    _BulkTask *task = (_BulkTask*) arg;
+    task->phase(task->build, task->id);
+    return NULL;
+}
+
+/**
+ * 每個執行緒各執行一次 phase，全部結束後才回傳，無法建立執行緒時改由目前的執行緒執行
+ */
+static void _Bulk_Run(_BulkBuild *build, _BulkPhase phase)
+{
+    pthread_t threads[_BULK_MAX_THREADS];
+    _BulkTask tasks[_BULK_MAX_THREADS];
+    bool started[_BULK_MAX_THREADS];
+    for (int t = 1; t < build->threads; t++)
     {
-        GenericTableItem *item = table->priv->items[i];
-        if (!_IsValid(item)) continue;
-        iterator->items[iterator->last] = item;
-        iterator->last++;
+        tasks[t].build = build;
+        tasks[t].phase = phase;
+        tasks[t].id = t;
+        started[t] = pthread_create(&(threads[t]), NULL, _Bulk_Thread, &(tasks[t])) == 0;
+        if (!started[t]) phase(build, t);
+    }
+    phase(build, 0);
+    for (int t = 1; t < build->threads; t++)
+    {
+        if (started[t]) pthread_join(threads[t], NULL);
     }
-    return iterator;
 }
 
-bool GenericTableIterator_HasNext(GenericTableIterator *iterator)
+/**
+ * 依型別寫入值，value 的慣例與 New_GenericType_InArena 相同
+ */
+static void _Bulk_SetValue(GenericType *gen_obj, GenericTypeEnum type, const void *value)
 {
-    return iterator->next < iterator->last;
+    if (!value && type != GEN_TYPE_NULL)
+    {
+        s_out_err("GenericTable_FromArrays got a null value pointer");
+        return;
+    }
+
+    switch (type)
+    {
+        case GEN_TYPE_STR:
+            GenericType_Set_Str(gen_obj, (const char*) value);
+            break;
+        case GEN_TYPE_INT:
+            GenericType_Set_Int(gen_obj, *(const int*) value);
+            break;
+        case GEN_TYPE_LONG:
+            GenericType_Set_Long(gen_obj, *(const long*) value);
+            break;
+        case GEN_TYPE_DOUBLE:
+            GenericType_Set_Double(gen_obj, *(const double*) value);
+            break;
+        case GEN_TYPE_FLOAT:
+            GenericType_Set_Float(gen_obj, *(const float*) value);
+            break;
+        case GEN_TYPE_TABLE:
+            GenericType_Set_Table(gen_obj, (GenericTable*) value);
+            break;
+        case GEN_TYPE_LIST:
+            GenericType_Set_List(gen_obj, (struct GenericList*) value);
+            break;
+        default:
+            break;
+    }
 }
 
-GenericTableItem* GenericTableIterator_Next(GenericTableIterator *iterator)
+/**
+ * 第一階段：計算 key 長度、雜湊值，建構值，並累計需要另外存放的 key 長度
+ */
+static void _Bulk_Measure(_BulkBuild *build, int id)
 {
-    GenericTableItem *item = iterator->items[iterator->next];
-    iterator->next++;
-    return item;
+    GenericTable_Private *priv = build->priv;
+    int from = _Bulk_Bound(build->n, build->threads, id);
+    int to = _Bulk_Bound(build->n, build->threads, id + 1);
+    size_t key_bytes = 0;
+    for (int i = from; i < to; i++)
+    {
+        GenericTableItem *item = _Bulk_Item(build, i);
+        item->key_len = strlen(build->keys[i]);
+        item->hash = _Get_HashValue(priv, build->keys[i], item->key_len);
+        GenericType *value = GenericType_InitAt(_ItemValue(item), &(priv->context), priv->cow.epoch);
+        _Bulk_SetValue(value, build->types[i], build->values[i]);
+        if (!_IsInlineKey(item->key_len) && !priv->intern_keys) key_bytes += (size_t) item->key_len + 1;
+    }
+    build->key_offsets[id] = key_bytes;
 }
 
-void Delete_GenericTableIterator(GenericTableIterator **p_iterator)
+/**
+ * 第二階段：把 key 複製到映射物件或 key_block(開啟 intern_keys 時從字串池取得)，並統計每個區段的數量
+ */
+static void _Bulk_CopyKeys(_BulkBuild *build, int id)
 {
-    GenericTableIterator *iterator = *p_iterator;
-    // iterator->items 中的 GenericTableItem 還需要使用，
-    // 故釋放 iterator->items 本身，以及歸零裡面的指標即可
-    for (int i = 0; i < iterator->last; i++)
+    GenericTable_Private *priv = build->priv;
+    _GenericTableBucket *bucket = &(priv->buckets);
+    int from = _Bulk_Bound(build->n, build->threads, id);
+    int to = _Bulk_Bound(build->n, build->threads, id + 1);
+    int *counts = build->counts ? build->counts + (long) id * build->threads : NULL;
+    char *dest = build->key_block ? build->key_block + build->key_offsets[id] : NULL;
+    for (int i = from; i < to; i++)
     {
-        GenericTableItem **p = &(iterator->items[i]);
-        *p = NULL;
+        GenericTableItem *item = _Bulk_Item(build, i);
+        if (_IsInlineKey(item->key_len))
+        {
+            memcpy(item->key.inline_key, build->keys[i], (size_t) item->key_len + 1);
+        }
+        else if (priv->intern_keys)
+        {
+            item->key.heap_key = _InternKey(priv, build->keys[i], item->key_len, item->hash);
+        }
+        else
+        {
+            memcpy(dest, build->keys[i], (size_t) item->key_len + 1);
+            item->key.heap_key = dest;
+            dest += item->key_len + 1;
+        }
+        if (counts) counts[_Bulk_Partition(build, _HomeIndex(bucket, item->hash))]++;
     }
-    free(iterator->items);
-    free(iterator);
-    *p_iterator = NULL;
 }
 
+/**
+ * 第三階段：依區段分組 key 編號，每個執行緒寫入自己預先算好的位置
+ */
+static void _Bulk_Scatter(_BulkBuild *build, int id)
+{
+    _GenericTableBucket *bucket = &(build->priv->buckets);
+    int from = _Bulk_Bound(build->n, build->threads, id);
+    int to = _Bulk_Bound(build->n, build->threads, id + 1);
+    int *cursors = build->counts + (long) id * build->threads;
+    for (int i = from; i < to; i++)
+    {
+        int partition = _Bulk_Partition(build, _HomeIndex(bucket, _Bulk_Item(build, i)->hash));
+        build->order[cursors[partition]++] = i;
+    }
+}
+
+/**
+ * 放入 [home, end) 之間：遇到相同的 key 時以新的值取代並回傳 0，放入空位時回傳 1，
+ * 探測到區段結尾仍找不到空位時回傳 -1，
+ * 放在起始位置之後第一個空位，群組探測依序掃描的範圍一定會經過此位置，
+ * 依起始位置排序後放入時也符合 Robin Hood 的順序
+ */
+static int _Bulk_PlaceInRange(GenericTable_Private *priv, _GenericTableBucket *bucket, GenericTableItem *item, int end)
+{
+    signed char tag = _HashTag(item->hash);
+    for (int index = _HomeIndex(bucket, item->hash); index < end; index++)
+    {
+        signed char ctrl = bucket->ctrl[index];
+        if (ctrl == _CTRL_EMPTY)
+        {
+            bucket->items[index] = item;
+            _SetCtrl(bucket, index, tag);
+            return 1;
+        }
+
+        GenericTableItem *current = bucket->items[index];
+        if (ctrl == tag && _IsSameKey(current, _ItemKey(item), item->key_len, item->hash))
+        {
+            GenericType_Move(_ItemValue(current), _ItemValue(item));
+            _Release_ItemKey(priv, item);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * 第四階段：每個執行緒只讀寫自己區段內的位置，
+ * Robin Hood 探測先依起始位置排序，區段內的物件才會依起始位置排列
+ */
+static void _Bulk_Place(_BulkBuild *build, int id)
+{
+    GenericTable_Private *priv = build->priv;
+    _GenericTableBucket *bucket = &(priv->buckets);
+    int start = _Bulk_Bound(bucket->size, build->threads, id);
+    int end = _Bulk_Bound(bucket->size, build->threads, id + 1);
+    int *slice = build->order + build->partition_begin[id];
+    int length = build->partition_begin[id + 1] - build->partition_begin[id];
+    int *sorted = slice;
+    int *buffer = NULL;
+    if (_IsRobinHood(priv) && length > 1)
+    {
+        int *counts = (int*) calloc((size_t) (end - start) + 1, sizeof(int));
+        buffer = (int*) malloc((size_t) length * sizeof(int));
+        for (int j = 0; j < length; j++)
+        {
+            counts[_HomeIndex(bucket, _Bulk_Item(build, slice[j])->hash) - start + 1]++;
+        }
+        for (int k = 1; k <= end - start; k++)
+        {
+            counts[k] += counts[k - 1];
+        }
+        for (int j = 0; j < length; j++)
+        {
+            int home = _HomeIndex(bucket, _Bulk_Item(build, slice[j])->hash);
+            buffer[counts[home - start]++] = slice[j];
+        }
+        free(counts);
+        sorted = buffer;
+    }
+
+    int placed = 0;
+    int deferred = 0;
+    for (int j = 0; j < length; j++)
+    {
+        int i = sorted[j];
+        int result = _Bulk_PlaceInRange(priv, bucket, _Bulk_Item(build, i), end);
+        if (result > 0)
+            placed++;
+        else if (result < 0)
+            slice[deferred++] = i;
+    }
+    free(buffer);
+    build->placed[id] = placed;
+    build->deferred[id] = deferred;
+}
+
+/**
+ * 依序放入一個映射物件，key 已存在時以新的值取代
+ */
+static void _Bulk_Insert(GenericTable_Private *priv, GenericTableItem *item)
+{
+    _GenericTableBucket *bucket = &(priv->buckets);
+    int free_index = -1;
+    int index = _Bucket_FindIndex(priv, bucket, _ItemKey(item), item->key_len, item->hash, &free_index);
+    if (index >= 0)
+    {
+        GenericTableItem *current = _SlotItem(bucket, index);
+        GenericType_Move(_ItemValue(current), _ItemValue(item));
+        _Release_ItemKey(priv, item);
+        return;
+    }
+
+    // entries 已預留 n 個位置，不會壓縮、重建容器
+    if (priv->ordered) _Ordered_Append(priv, item);
+    if (_IsRobinHood(priv))
+        _RobinHood_Insert(bucket, item);
+    else
+        _Group_Place(bucket, free_index, item);
+    priv->item_count++;
+}
+
+/**
+ * 記下連續區塊，區塊中的映射物件、key 解構時不個別釋放，arena 中的映射表不需記錄
+ */
+static void* _Bulk_Alloc(GenericTable_Private *priv, size_t size)
+{
+    void *ptr = _Alloc(priv, size);
+    if (!priv->arena)
+    {
+        _GenericTableBlock *block = (_GenericTableBlock*) malloc(sizeof(_GenericTableBlock));
+        block->start = (char*) ptr;
+        block->size = size;
+        block->next = priv->blocks;
+        priv->blocks = block;
+    }
+    return ptr;
+}
+
+/**
+ * 依起始位置分組後平行放入，探測超出區段的 key 最後依序放入
+ */
+static void _Bulk_PlaceParallel(_BulkBuild *build)
+{
+    GenericTable_Private *priv = build->priv;
+    int threads = build->threads;
+    build->partition_begin[0] = 0;
+    for (int p = 0; p < threads; p++)
+    {
+        int begin = build->partition_begin[p];
+        for (int t = 0; t < threads; t++)
+        {
+            int count = build->counts[t * threads + p];
+            build->counts[t * threads + p] = begin;
+            begin += count;
+        }
+        build->partition_begin[p + 1] = begin;
+    }
+    build->order = (int*) malloc((size_t) build->n * sizeof(int));
+    _Bulk_Run(build, _Bulk_Scatter);
+    _Bulk_Run(build, _Bulk_Place);
+
+    for (int p = 0; p < threads; p++)
+    {
+        priv->buckets.used += build->placed[p];
+        priv->item_count += build->placed[p];
+    }
+    for (int p = 0; p < threads; p++)
+    {
+        int *slice = build->order + build->partition_begin[p];
+        for (int j = 0; j < build->deferred[p]; j++)
+        {
+            _Bulk_Insert(priv, _Bulk_Item(build, slice[j]));
+        }
+    }
+    free(build->order);
+}
+
+GenericTable* GenericTable_FromArrays(
+    const char **keys, const void **values, const GenericTypeEnum *types, int n, const GenericTableOptions *options
+) {
+    // 換算容器大小前先修正選項，負載係數為 0 時不可作為除數
+    GenericTableOptions defaults = GenericTable_DefaultOptions();
+    GenericTableOptions build_options = _NormalizeOptions(options ? options : &defaults);
+    if (n < 0) n = 0;
+    long size = (long) n * 100 / build_options.load_factor + 1;
+    if (size > NUMBER_UTIL_INT_MAX / 2)
+    {
+        s_out_err_f("GenericTable_FromArrays capacity for %d items is over integer max", n);
+        return NULL;
+    }
+    if (size > build_options.bucket_size) build_options.bucket_size = (int) size;
 
+    GenericTable *table = _New_GenericTable(&build_options);
+    GenericTable_Private *priv = table->priv;
+    if (n == 0) return table;
 
+    if (priv->ordered && n > priv->entries.capacity)
+    {
+        _Free(priv, priv->entries.items);
+        priv->entries.items = (GenericTableItem**) _Alloc(priv, (size_t) n * sizeof(GenericTableItem*));
+        priv->entries.capacity = n;
+    }
 
+    // arena 不可同時配置，保持插入順序時須依序放入
+    int threads = build_options.build_threads;
+    if (threads > n / _BULK_MIN_KEYS_PER_THREAD) threads = n / _BULK_MIN_KEYS_PER_THREAD;
+    if (threads > _BULK_MAX_THREADS) threads = _BULK_MAX_THREADS;
+    if (threads < 1 || priv->arena) threads = 1;
+
+    _BulkBuild build;
+    memset(&build, 0, sizeof(_BulkBuild));
+    build.priv = priv;
+    build.keys = keys;
+    build.values = values;
+    build.types = types;
+    build.n = n;
+    build.threads = threads;
+    build.item_size = _ItemSize();
+    build.items = (char*) _Bulk_Alloc(priv, (size_t) n * build.item_size);
+    _Bulk_Run(&build, _Bulk_Measure);
+
+    size_t key_bytes = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        size_t bytes = build.key_offsets[t];
+        build.key_offsets[t] = key_bytes;
+        key_bytes += bytes;
+    }
+    if (key_bytes) build.key_block = (char*) _Bulk_Alloc(priv, key_bytes);
+    bool parallel = threads > 1 && !priv->ordered;
+    if (parallel) build.counts = (int*) calloc((size_t) threads * threads, sizeof(int));
+    _Bulk_Run(&build, _Bulk_CopyKeys);
 
+    if (parallel)
+    {
+        _Bulk_PlaceParallel(&build);
+        free(build.counts);
+    }
+    else
+    {
+        for (int i = 0; i < n; i++)
+        {
+            _Bulk_Insert(priv, _Bulk_Item(&build, i));
+        }
+    }
+    priv->modified_count = priv->item_count;
+    priv->layout_version++;
+    _COUNT(&(priv->counters), inserts, priv->item_count);
+    return table;
+}
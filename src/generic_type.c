@@ -3,62 +3,220 @@
 
 #include "../include/generic_type.h"
 #include "../include/generic_list.h"
+#include "../include/generic_arena.h"
+#include "../include/generic_pool.h"
+#include "../include/generic_string.h"
+#include "../include/cow_util.h"
+#include "../include/hash_util.h"
 #include "../include/common_util.h"
 #include "../include/generic_type_enum.h"
 
 // ================================================================================
 // Private Properties
 // ================================================================================
+/**
+ * 數值直接存放在物件中，不另外配置記憶體，GenericType_Get* 回傳指向物件內的指標，
+ * 字串不在 arena 中時指向 GenericString 的內容，在 arena 中時為 arena 中的複本
+ */
 typedef union GenericValue
 {
     char *s_val;
-    int *i_val;
-    long *l_val;
-    float *f_val;
-    double *d_val;
+    int i_val;
+    long l_val;
+    float f_val;
+    double d_val;
     GenericTable *h_val;
     GenericList *a_val;
 } GenericValue;
 
+/**
+ * 物件只有 24 個位元組：值、環境指標、epoch、型別與旗標，
+ * 放入容器後 arena 與版本狀態都從容器共用的 GenericTypeContext 取得，不必每個物件各存一份
+ */
 struct GenericType
 {
-    GenericTypeEnum type;
-    GenericValue *value;
+    GenericValue value;
+    /**
+     * 放入容器後(_FLAG_CONTEXT)指向容器的 GenericTypeContext，
+     * 尚未放入容器時為配置此物件的 arena，NULL 代表以 malloc 配置
+     */
+    union
+    {
+        const GenericTypeContext *context;
+        GenericArena *arena;
+    } env;
+    /**
+     * 放入容器時的 epoch，快照用以判定此物件是否仍與凍結的版本共用
+     */
+    int epoch;
+    unsigned char type;
+    unsigned char flags;
 };
 
-static GenericType* _New_GenericType(GenericTypeEnum type, void *value)
+_Static_assert(sizeof(GenericType) <= GENERIC_TYPE_SIZE, "GenericType is larger than GENERIC_TYPE_SIZE");
+
+/**
+ * 不在 arena、也不在容器中的物件從池配置
+ */
+static GenericPool _pool = GENERIC_POOL_INIT(sizeof(GenericType));
+
+// env 指向容器的 GenericTypeContext
+#define _FLAG_CONTEXT 0x1
+// 物件存放在容器提供的記憶體中，解構時不釋放物件本身
+#define _FLAG_EMBEDDED 0x2
+// 映射表、動態陣列已記錄所在的容器為上層容器，釋放或移走時須移除記錄
+#define _FLAG_LINKED 0x4
+
+static inline GenericArena* _Arena(GenericType *obj)
 {
-    GenericType *gen_obj = (GenericType*) malloc(sizeof(GenericType));
-    GenericValue *gen_val = (GenericValue*) malloc(sizeof(GenericValue));
+    return (obj->flags & _FLAG_CONTEXT) ? obj->env.context->arena : obj->env.arena;
+}
+
+static inline CowUtil_State* _Owner(GenericType *obj)
+{
+    return (obj->flags & _FLAG_CONTEXT) ? obj->env.context->owner : NULL;
+}
+
+/**
+ * 修改容器中的物件前呼叫，容器與其上層容器記下的雜湊值失效
+ */
+static inline void _InvalidateHash(GenericType *obj)
+{
+    CowUtil_State *owner = _Owner(obj);
+    if (owner) CowUtil_InvalidateHash(owner);
+}
+
+static inline GenericString* _String(GenericType *obj)
+{
+    return GenericString_FromChars(obj->value.s_val);
+}
+
+/**
+ * 配置物件，值清為 0，由呼叫端寫入 value
+ */
+static GenericType* _New_GenericType(GenericTypeEnum type)
+{
+    GenericType *gen_obj = (GenericType*) GenericPool_Alloc(&_pool);
+    memset(&(gen_obj->value), 0, sizeof(GenericValue));
+    gen_obj->env.arena = NULL;
+    gen_obj->epoch = 0;
     gen_obj->type = type;
-    gen_obj->value = gen_val;
+    gen_obj->flags = 0;
+    return gen_obj;
+}
 
-    switch (type)
+static inline CowUtil_State* _PayloadState(GenericType *obj)
+{
+    return obj->type == GEN_TYPE_TABLE
+        ? GenericTable_GetCowState(obj->value.h_val)
+        : GenericList_GetCowState(obj->value.a_val);
+}
+
+/**
+ * 映射表、動態陣列離開此物件前呼叫，共用的子樹不再把此容器當作上層容器
+ */
+static void _Unlink_Payload(GenericType *obj)
+{
+    if (!(obj->flags & _FLAG_LINKED)) return;
+
+    CowUtil_RemoveParent(_PayloadState(obj), _Owner(obj));
+    obj->flags &= ~_FLAG_LINKED;
+}
+
+static void _Unlink_ArenaPayload(void *ptr)
+{
+    _Unlink_Payload((GenericType*) ptr);
+}
+
+/**
+ * 放入的映射表、動態陣列以所在的容器為上層容器，快照才能判定是否包含它們，
+ * 以參考計數共用的子樹每放入一個容器就多一個上層容器，
+ * arena 中的子樹不會被解構，有多個上層容器時由 arena 在解構時移除記錄，釋放記錄佔用的記憶體
+ */
+static void _Link_Payload(GenericType *obj)
+{
+    CowUtil_State *owner = _Owner(obj);
+    if (!owner || (obj->flags & _FLAG_LINKED)) return;
+    if (obj->type != GEN_TYPE_TABLE && obj->type != GEN_TYPE_LIST) return;
+
+    int count = CowUtil_AddParent(_PayloadState(obj), owner);
+    if (!count) return;
+
+    obj->flags |= _FLAG_LINKED;
+    GenericArena *arena = _Arena(obj);
+    if (count > 1 && arena) GenericArena_AddCleanup(arena, _Unlink_ArenaPayload, obj);
+}
+
+/**
+ * arena 中的物件本身不需釋放，只需解構不在 arena 中的映射表、動態陣列，
+ * 解構後指標為 NULL，arena 解構時再次呼叫也不會重複釋放
+ */
+static void _Delete_ArenaPayload(void *ptr)
+{
+    GenericType *obj = (GenericType*) ptr;
+    GenericValue *gen_val = &(obj->value);
+    _Unlink_Payload(obj);
+    if (obj->type == GEN_TYPE_TABLE && gen_val->h_val)
     {
-        case GEN_TYPE_STR:
-            gen_val->s_val = (char*) value;
-            break;
-        case GEN_TYPE_INT:
-            gen_val->i_val = (int*) value;
-            break;
-        case GEN_TYPE_LONG:
-            gen_val->l_val = (long*) value;
-            break;
-        case GEN_TYPE_DOUBLE:
-            gen_val->d_val = (double*) value;
-            break;
-        case GEN_TYPE_FLOAT:
-            gen_val->f_val = (float*) value;
-            break;
-        case GEN_TYPE_TABLE:
-            gen_val->h_val = (GenericTable*) value;
-            break;
-        case GEN_TYPE_LIST:
-            gen_val->a_val = (GenericList*) value;
-            break;
+        Delete_GenericTable(&(gen_val->h_val));
     }
+    else if (obj->type == GEN_TYPE_LIST && gen_val->a_val)
+    {
+        Delete_GenericList(&(gen_val->a_val));
+    }
+}
 
-    return gen_obj;
+/**
+ * 釋放物件目前的值，物件本身保留並轉為 GEN_TYPE_NULL，值清為 0，
+ * 數值存放在物件中不需釋放，arena 中的字串也不需釋放，只需解構不在 arena 中的映射表、動態陣列，
+ * 不在 arena 中的字串遞減參考計數
+ */
+static void _Release_Payload(GenericType *obj)
+{
+    _Unlink_Payload(obj);
+    if (_Arena(obj))
+    {
+        _Delete_ArenaPayload(obj);
+    }
+    else
+    {
+        GenericValue *gen_val = &(obj->value);
+        switch (obj->type)
+        {
+            case GEN_TYPE_STR:
+            {
+                GenericString *str = _String(obj);
+                Delete_GenericString(&str);
+                break;
+            }
+            case GEN_TYPE_TABLE:
+                Delete_GenericTable(&(gen_val->h_val));
+                break;
+            case GEN_TYPE_LIST:
+                Delete_GenericList(&(gen_val->a_val));
+                break;
+            default:
+                break;
+        }
+    }
+    memset(&(obj->value), 0, sizeof(GenericValue));
+    obj->type = GEN_TYPE_NULL;
+}
+
+/**
+ * 放入不在 arena 中的映射表、動態陣列後，交由 arena 在解構時一併解構，
+ * 同一個物件重複登記也只會解構一次
+ */
+static void _Register_ArenaPayload(GenericType *obj)
+{
+    GenericArena *arena = _Arena(obj);
+    if (!arena) return;
+
+    GenericValue *gen_val = &(obj->value);
+    bool need_cleanup = obj->type == GEN_TYPE_TABLE
+        ? !GenericTable_GetArena(gen_val->h_val)
+        : !GenericList_GetArena(gen_val->a_val);
+    if (need_cleanup) GenericArena_AddCleanup(arena, _Delete_ArenaPayload, obj);
 }
 
 // ================================================================================
@@ -67,34 +225,10 @@ static GenericType* _New_GenericType(GenericTypeEnum type, void *value)
 void Delete_GenericType(GenericType **ptr_obj)
 {
     GenericType *obj = *ptr_obj;
-    GenericValue *gen_val = obj->value;
-    switch (obj->type)
-    {
-        case GEN_TYPE_STR:
-            free(gen_val->s_val);
-            break;
-        case GEN_TYPE_INT:
-            free(gen_val->i_val);
-            break;
-        case GEN_TYPE_LONG:
-            free(gen_val->l_val);
-            break;
-        case GEN_TYPE_DOUBLE:
-            free(gen_val->d_val);
-            break;
-        case GEN_TYPE_FLOAT:
-            free(gen_val->f_val);
-            break;
-        case GEN_TYPE_TABLE:
-            Delete_GenericTable(&(gen_val->h_val));
-            break;
-        case GEN_TYPE_LIST:
-            Delete_GenericList(&(gen_val->a_val));
-            break;
-    }
-    free(gen_val);
-    free(obj);
     *ptr_obj = NULL;
+    _Release_Payload(obj);
+    // arena 中的物件隨 arena 一起釋放，存放在容器中的物件由容器釋放
+    if (!_Arena(obj) && !(obj->flags & _FLAG_EMBEDDED)) GenericPool_Free(&_pool, obj);
 }
 
 GenericType* New_Str_GenericType(const char *value)
@@ -104,35 +238,40 @@ GenericType* New_Str_GenericType(const char *value)
         s_out("the string pointer is null");
         return NULL;
     }
-    return _New_GenericType(GEN_TYPE_STR, strdup(value));
+    GenericString *str = GenericString_Intern(value, strlen(value));
+    if (!str) return NULL;
+
+    GenericType *gen_obj = _New_GenericType(GEN_TYPE_STR);
+    gen_obj->value.s_val = (char*) GenericString_Chars(str);
+    return gen_obj;
 }
 
 GenericType* New_Int_GenericType(int value)
 {
-    int *p_val = (int*) malloc(sizeof(int));
-    *p_val = value;
-    return _New_GenericType(GEN_TYPE_INT, p_val);
+    GenericType *gen_obj = _New_GenericType(GEN_TYPE_INT);
+    gen_obj->value.i_val = value;
+    return gen_obj;
 }
 
 GenericType* New_Long_GenericType(long value)
 {
-    long *p_val = (long*) malloc(sizeof(long));
-    *p_val = value;
-    return _New_GenericType(GEN_TYPE_LONG, p_val);
+    GenericType *gen_obj = _New_GenericType(GEN_TYPE_LONG);
+    gen_obj->value.l_val = value;
+    return gen_obj;
 }
 
 GenericType* New_Float_GenericType(float value)
 {
-    float *p_val = (float*) malloc(sizeof(float));
-    *p_val = value;
-    return _New_GenericType(GEN_TYPE_FLOAT, p_val);
+    GenericType *gen_obj = _New_GenericType(GEN_TYPE_FLOAT);
+    gen_obj->value.f_val = value;
+    return gen_obj;
 }
 
 GenericType* New_Double_GenericType(double value)
 {
-    double *p_val = (double*) malloc(sizeof(double));
-    *p_val = value;
-    return _New_GenericType(GEN_TYPE_DOUBLE, p_val);
+    GenericType *gen_obj = _New_GenericType(GEN_TYPE_DOUBLE);
+    gen_obj->value.d_val = value;
+    return gen_obj;
 }
 
 GenericType* New_Table_GenericType(GenericTable *value)
@@ -142,7 +281,9 @@ GenericType* New_Table_GenericType(GenericTable *value)
         s_out("the GenericTable pointer is null");
         return NULL;
     }
-    return _New_GenericType(GEN_TYPE_TABLE, value);
+    GenericType *gen_obj = _New_GenericType(GEN_TYPE_TABLE);
+    gen_obj->value.h_val = value;
+    return gen_obj;
 }
 
 GenericType* New_List_GenericType(struct GenericList *value)
@@ -152,54 +293,115 @@ GenericType* New_List_GenericType(struct GenericList *value)
         s_out("the GenericList pointer is null");
         return NULL;
     }
-    return _New_GenericType(GEN_TYPE_LIST, value);
+    GenericType *gen_obj = _New_GenericType(GEN_TYPE_LIST);
+    gen_obj->value.a_val = value;
+    return gen_obj;
+}
+
+GenericType* New_Null_GenericType(void)
+{
+    return _New_GenericType(GEN_TYPE_NULL);
+}
+
+GenericType* New_GenericType_InArena(GenericArena *arena, GenericTypeEnum type, const void *value)
+{
+    if (!value && type != GEN_TYPE_NULL) 
+    {
+        s_out("the value pointer is null");
+        return NULL;
+    }
+
+    GenericType *gen_obj = (GenericType*) GenericArena_Alloc(arena, sizeof(GenericType));
+    GenericValue *gen_val = &(gen_obj->value);
+    memset(gen_val, 0, sizeof(GenericValue));
+    gen_obj->env.arena = arena;
+    gen_obj->epoch = 0;
+    gen_obj->type = type;
+    gen_obj->flags = 0;
+
+    switch (type)
+    {
+        case GEN_TYPE_STR:
+            gen_val->s_val = GenericArena_StrDup(arena, (const char*) value);
+            break;
+        case GEN_TYPE_INT:
+            gen_val->i_val = *(const int*) value;
+            break;
+        case GEN_TYPE_LONG:
+            gen_val->l_val = *(const long*) value;
+            break;
+        case GEN_TYPE_DOUBLE:
+            gen_val->d_val = *(const double*) value;
+            break;
+        case GEN_TYPE_FLOAT:
+            gen_val->f_val = *(const float*) value;
+            break;
+        case GEN_TYPE_TABLE:
+            gen_val->h_val = (GenericTable*) value;
+            // 不在 arena 中的映射表由 arena 負責解構
+            if (!GenericTable_GetArena(gen_val->h_val)) GenericArena_AddCleanup(arena, _Delete_ArenaPayload, gen_obj);
+            break;
+        case GEN_TYPE_LIST:
+            gen_val->a_val = (GenericList*) value;
+            if (!GenericList_GetArena(gen_val->a_val)) GenericArena_AddCleanup(arena, _Delete_ArenaPayload, gen_obj);
+            break;
+        case GEN_TYPE_NULL:
+            break;
+    }
+    return gen_obj;
 }
 
-char* GenericType_GetStr(GenericType *gen_type)
+const char* GenericType_GetStr(GenericType *gen_type)
 {
     if (gen_type->type != GEN_TYPE_STR) return NULL;
-    return gen_type->value->s_val;
+    return gen_type->value.s_val;
+}
+
+GenericString* GenericType_GetString(GenericType *gen_type)
+{
+    if (gen_type->type != GEN_TYPE_STR || _Arena(gen_type)) return NULL;
+    return _String(gen_type);
 }
 
 int* GenericType_GetInt(GenericType *gen_type)
 {
     if (gen_type->type != GEN_TYPE_INT) return NULL;
-    return gen_type->value->i_val;
+    return &(gen_type->value.i_val);
 }
 
 long* GenericType_GetLong(GenericType *gen_type)
 {
     if (gen_type->type != GEN_TYPE_LONG) return NULL;
-    return gen_type->value->l_val;
+    return &(gen_type->value.l_val);
 }
 
 float* GenericType_GetFloat(GenericType *gen_type)
 {
     if (gen_type->type != GEN_TYPE_FLOAT) return NULL;
-    return gen_type->value->f_val;
+    return &(gen_type->value.f_val);
 }
 
 double* GenericType_GetDouble(GenericType *gen_type)
 {
     if (gen_type->type != GEN_TYPE_DOUBLE) return NULL;
-    return gen_type->value->d_val;
+    return &(gen_type->value.d_val);
 }
 
 GenericTable* GenericType_GetTable(GenericType *gen_type)
 {
     if (gen_type->type != GEN_TYPE_TABLE) return NULL;
-    return gen_type->value->h_val;
+    return gen_type->value.h_val;
 }
 
 struct  GenericList* GenericType_GetList(GenericType *gen_type)
 {
     if (gen_type->type != GEN_TYPE_LIST) return NULL;
-    return gen_type->value->a_val;
+    return gen_type->value.a_val;
 }
 
 GenericTypeEnum GenericType_GetType(GenericType *gen_type)
 {
-    return gen_type->type;
+    return (GenericTypeEnum) gen_type->type;
 }
 
 bool GenericType_IsType(GenericType *gen_type, GenericTypeEnum type)
@@ -207,6 +409,243 @@ bool GenericType_IsType(GenericType *gen_type, GenericTypeEnum type)
     return gen_type->type == type;
 }
 
+void GenericType_Set_Str(GenericType *gen_type, const char *value)
+{
+    if (!value)
+    {
+        s_out_err("the string pointer is null at GenericType_Set_Str!");
+        return;
+    }
+    _InvalidateHash(gen_type);
+    GenericArena *arena = _Arena(gen_type);
+    if (!arena)
+    {
+        // 先取得新字串再釋放原本的字串，value 可能是原本字串中的一部分
+        if (gen_type->type == GEN_TYPE_STR && gen_type->value.s_val == value) return;
+        GenericType_Set_String(gen_type, GenericString_Intern(value, strlen(value)));
+        return;
+    }
+
+    if (gen_type->type == GEN_TYPE_STR)
+    {
+        // arena 中的字串只屬於此物件，新字串不比原本的長時直接覆寫，value 可能與原本的字串重疊
+        char *current = gen_type->value.s_val;
+        size_t len = strlen(value);
+        if (current == value) return;
+        if (strlen(current) >= len)
+        {
+            memmove(current, value, len + 1);
+            return;
+        }
+    }
+    char *copy = GenericArena_StrDup(arena, value);
+    _Release_Payload(gen_type);
+    gen_type->value.s_val = copy;
+    gen_type->type = GEN_TYPE_STR;
+}
+
+void GenericType_Set_String(GenericType *gen_type, GenericString *value)
+{
+    if (!value)
+    {
+        s_out_err("the GenericString pointer is null at GenericType_Set_String!");
+        return;
+    }
+    _InvalidateHash(gen_type);
+    if (_Arena(gen_type))
+    {
+        GenericType_Set_Str(gen_type, GenericString_Chars(value));
+        Delete_GenericString(&value);
+        return;
+    }
+
+    _Release_Payload(gen_type);
+    gen_type->value.s_val = (char*) GenericString_Chars(value);
+    gen_type->type = GEN_TYPE_STR;
+}
+
+void GenericType_Set_Int(GenericType *gen_type, int value)
+{
+    _InvalidateHash(gen_type);
+    if (gen_type->type != GEN_TYPE_INT)
+    {
+        _Release_Payload(gen_type);
+        gen_type->type = GEN_TYPE_INT;
+    }
+    gen_type->value.i_val = value;
+}
+
+void GenericType_Set_Long(GenericType *gen_type, long value)
+{
+    _InvalidateHash(gen_type);
+    if (gen_type->type != GEN_TYPE_LONG)
+    {
+        _Release_Payload(gen_type);
+        gen_type->type = GEN_TYPE_LONG;
+    }
+    gen_type->value.l_val = value;
+}
+
+void GenericType_Set_Double(GenericType *gen_type, double value)
+{
+    _InvalidateHash(gen_type);
+    if (gen_type->type != GEN_TYPE_DOUBLE)
+    {
+        _Release_Payload(gen_type);
+        gen_type->type = GEN_TYPE_DOUBLE;
+    }
+    gen_type->value.d_val = value;
+}
+
+void GenericType_Set_Float(GenericType *gen_type, float value)
+{
+    _InvalidateHash(gen_type);
+    if (gen_type->type != GEN_TYPE_FLOAT)
+    {
+        _Release_Payload(gen_type);
+        gen_type->type = GEN_TYPE_FLOAT;
+    }
+    gen_type->value.f_val = value;
+}
+
+void GenericType_Set_Table(GenericType *gen_type, GenericTable *value)
+{
+    if (!value)
+    {
+        s_out_err("the GenericTable pointer is null at GenericType_Set_Table!");
+        return;
+    }
+    if (gen_type->type == GEN_TYPE_TABLE && gen_type->value.h_val == value) return;
+
+    _InvalidateHash(gen_type);
+    _Release_Payload(gen_type);
+    gen_type->value.h_val = value;
+    gen_type->type = GEN_TYPE_TABLE;
+    _Register_ArenaPayload(gen_type);
+    _Link_Payload(gen_type);
+}
+
+void GenericType_Set_List(GenericType *gen_type, struct GenericList *value)
+{
+    if (!value)
+    {
+        s_out_err("the GenericList pointer is null at GenericType_Set_List!");
+        return;
+    }
+    if (gen_type->type == GEN_TYPE_LIST && gen_type->value.a_val == value) return;
+
+    _InvalidateHash(gen_type);
+    _Release_Payload(gen_type);
+    gen_type->value.a_val = value;
+    gen_type->type = GEN_TYPE_LIST;
+    _Register_ArenaPayload(gen_type);
+    _Link_Payload(gen_type);
+}
+
+void GenericType_SetOwner(GenericType *gen_type, const GenericTypeContext *context, int epoch)
+{
+    _Unlink_Payload(gen_type);
+    gen_type->env.context = context;
+    gen_type->flags |= _FLAG_CONTEXT;
+    gen_type->epoch = epoch;
+    _Link_Payload(gen_type);
+}
+
+int GenericType_GetEpoch(GenericType *gen_type)
+{
+    return gen_type->epoch;
+}
+
+size_t GenericType_Sizeof(void)
+{
+    return GENERIC_TYPE_SIZE;
+}
+
+GenericType* GenericType_InitAt(void *storage, const GenericTypeContext *context, int epoch)
+{
+    GenericType *gen_obj = (GenericType*) storage;
+    memset(&(gen_obj->value), 0, sizeof(GenericValue));
+    gen_obj->env.context = context;
+    gen_obj->epoch = epoch;
+    gen_obj->type = GEN_TYPE_NULL;
+    gen_obj->flags = _FLAG_CONTEXT | _FLAG_EMBEDDED;
+    return gen_obj;
+}
+
+void GenericType_Move(GenericType *dest, GenericType *src)
+{
+    if (dest == src) return;
+
+    _InvalidateHash(dest);
+    _Release_Payload(dest);
+    _Unlink_Payload(src);
+    dest->value = src->value;
+    dest->type = src->type;
+    // src 的 arena 解構回呼看到 GEN_TYPE_NULL 時不做任何事，改由 dest 登記
+    memset(&(src->value), 0, sizeof(GenericValue));
+    src->type = GEN_TYPE_NULL;
+    if (dest->type == GEN_TYPE_TABLE || dest->type == GEN_TYPE_LIST)
+    {
+        _Register_ArenaPayload(dest);
+        _Link_Payload(dest);
+    }
+}
+
+void GenericType_Assign(GenericType *dest, GenericType *src)
+{
+    if (dest == src) return;
+
+    GenericValue *gen_val = &(src->value);
+    switch (src->type)
+    {
+        case GEN_TYPE_STR:
+            // 兩者都不在 arena 中時共用同一個字串
+            if (!_Arena(src) && !_Arena(dest))
+            {
+                if (dest->type != GEN_TYPE_STR || dest->value.s_val != gen_val->s_val)
+                    GenericType_Set_String(dest, GenericString_Retain(_String(src)));
+            }
+            else
+            {
+                GenericType_Set_Str(dest, gen_val->s_val);
+            }
+            break;
+        case GEN_TYPE_INT:
+            GenericType_Set_Int(dest, gen_val->i_val);
+            break;
+        case GEN_TYPE_LONG:
+            GenericType_Set_Long(dest, gen_val->l_val);
+            break;
+        case GEN_TYPE_DOUBLE:
+            GenericType_Set_Double(dest, gen_val->d_val);
+            break;
+        case GEN_TYPE_FLOAT:
+            GenericType_Set_Float(dest, gen_val->f_val);
+            break;
+        case GEN_TYPE_TABLE:
+            // 已經是同一個映射表時不需再增加參考
+            if (GenericType_GetTable(dest) != gen_val->h_val) GenericType_Set_Table(dest, GenericTable_Retain(gen_val->h_val));
+            break;
+        case GEN_TYPE_LIST:
+            if (GenericType_GetList(dest) != gen_val->a_val) GenericType_Set_List(dest, GenericList_Retain(gen_val->a_val));
+            break;
+        default:
+            _Release_Payload(dest);
+            break;
+    }
+}
+
+GenericType* GenericType_Clone(GenericType *gen_type)
+{
+    GenericArena *arena = _Arena(gen_type);
+    GenericType *copy = arena ? New_GenericType_InArena(arena, GEN_TYPE_NULL, NULL) : New_Null_GenericType();
+    copy->env = gen_type->env;
+    copy->flags = gen_type->flags & _FLAG_CONTEXT;
+    copy->epoch = gen_type->epoch;
+    GenericType_Assign(copy, gen_type);
+    return copy;
+}
+
 bool GenericType_Equals(GenericType *gen_type1, GenericType *gen_type2)
 {
     if (CommonUtil_IsNull(gen_type1) | CommonUtil_IsNull(gen_type2)) 
@@ -225,36 +664,90 @@ bool GenericType_Equals(GenericType *gen_type1, GenericType *gen_type2)
     if (gen_type1->type != gen_type2->type) return false;
 
     GenericValue *val1, *val2;
-    val1 = gen_type1->value;
-    val2 = gen_type2->value;
+    val1 = &(gen_type1->value);
+    val2 = &(gen_type2->value);
     bool is_equals = false;
     switch (gen_type1->type) 
     {
         case GEN_TYPE_STR:
-            is_equals = strcmp(val1->s_val, val2->s_val) == 0;
+            // 不在 arena 中的字串都來自字串池，內容相同若且唯若指標相同
+            if (!_Arena(gen_type1) && !_Arena(gen_type2))
+                is_equals = val1->s_val == val2->s_val;
+            else
+                is_equals = strcmp(val1->s_val, val2->s_val) == 0;
+            break;
         case GEN_TYPE_INT:
-            is_equals = *(val1->i_val) == *(val2->i_val);
+            is_equals = val1->i_val == val2->i_val;
+            break;
         case GEN_TYPE_LONG:
-            is_equals = *(val1->l_val) == *(val2->l_val);
+            is_equals = val1->l_val == val2->l_val;
+            break;
         case GEN_TYPE_FLOAT:
-            is_equals = *(val1->f_val) == *(val2->f_val);
+            is_equals = val1->f_val == val2->f_val;
+            break;
         case GEN_TYPE_DOUBLE:
-            is_equals = *(val1->d_val) == *(val2->d_val);
+            is_equals = val1->d_val == val2->d_val;
+            break;
         case GEN_TYPE_TABLE:
-            {
-                s_out("todo");
-                break;
-            }
+            is_equals = GenericTable_Equals(val1->h_val, val2->h_val);
+            break;
         case GEN_TYPE_LIST:
-            {
-                s_out("todo");
-                break;
-            }
+            is_equals = GenericList_Equals(val1->a_val, val2->a_val);
+            break;
+        case GEN_TYPE_NULL:
+            is_equals = true;
+            break;
     }
 
     return is_equals;
 }
 
+uint64_t GenericType_Hash(GenericType *gen_type)
+{
+    if (!gen_type)
+    {
+        s_out_err("the GenericType pointer is null at GenericType_Hash!");
+        return 0;
+    }
 
-
-
+    GenericValue *gen_val = &(gen_type->value);
+    uint64_t bits = 0;
+    switch (gen_type->type)
+    {
+        case GEN_TYPE_STR:
+            bits = _Arena(gen_type)
+                ? GenericString_HashOf(gen_val->s_val, strlen(gen_val->s_val))
+                : GenericString_Hash(_String(gen_type));
+            break;
+        case GEN_TYPE_INT:
+            bits = (uint64_t) (int64_t) gen_val->i_val;
+            break;
+        case GEN_TYPE_LONG:
+            bits = (uint64_t) gen_val->l_val;
+            break;
+        case GEN_TYPE_FLOAT:
+        {
+            // -0.0 與 0.0 相等，雜湊值也須相同
+            float f_val = gen_val->f_val == 0 ? 0.0f : gen_val->f_val;
+            uint32_t f_bits;
+            memcpy(&f_bits, &f_val, sizeof(f_bits));
+            bits = f_bits;
+            break;
+        }
+        case GEN_TYPE_DOUBLE:
+        {
+            double d_val = gen_val->d_val == 0 ? 0.0 : gen_val->d_val;
+            memcpy(&bits, &d_val, sizeof(bits));
+            break;
+        }
+        case GEN_TYPE_TABLE:
+            bits = GenericTable_Hash(gen_val->h_val);
+            break;
+        case GEN_TYPE_LIST:
+            bits = GenericList_Hash(gen_val->a_val);
+            break;
+        default:
+            break;
+    }
+    return HashUtil_Mix(bits, (uint64_t) gen_type->type);
+}
@@ -0,0 +1,159 @@
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+
+#include "../include/hash_util.h"
+
+// ================================================================================
+// Private Properties
+// ================================================================================
+static const uint64_t _WY_P0 = 0x2d358dccaa6c78a5ull;
+static const uint64_t _WY_P1 = 0x8bb84b93962eacc9ull;
+static const uint64_t _WY_P2 = 0x4b33a62ed433d4a3ull;
+static const uint64_t _WY_P3 = 0x4d5a2da51de1aa47ull;
+
+static const uint64_t _FNV_OFFSET = 0xcbf29ce484222325ull;
+static const uint64_t _FNV_PRIME = 0x100000001b3ull;
+
+// 作為舊版雜湊運算用的常數
+static const int _LEGACY_HASH_ARG = 0X11;
+
+static uint64_t _process_seed = 0;
+
+static inline void _Mum(uint64_t *a, uint64_t *b)
+{
+    __uint128_t r = (__uint128_t) *a * *b;
+    *a = (uint64_t) r;
+    *b = (uint64_t) (r >> 64);
+}
+
+static inline uint64_t _Mix(uint64_t a, uint64_t b)
+{
+    _Mum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t _Read8(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t _Read4(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t _Read3(const uint8_t *p, size_t k)
+{
+    return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) | p[k - 1];
+}
+
+// ================================================================================
+// Public properties
+// ================================================================================
+uint64_t HashUtil_WyHash(const char *key, size_t key_len, uint64_t seed)
+{
+    const uint8_t *p = (const uint8_t*) key;
+    uint64_t a, b;
+    seed ^= _Mix(seed ^ _WY_P0, _WY_P1);
+
+    if (key_len <= 16)
+    {
+        if (key_len >= 4)
+        {
+            a = (_Read4(p) << 32) | _Read4(p + ((key_len >> 3) << 2));
+            b = (_Read4(p + key_len - 4) << 32) | _Read4(p + key_len - 4 - ((key_len >> 3) << 2));
+        }
+        else if (key_len > 0)
+        {
+            a = _Read3(p, key_len);
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        size_t i = key_len;
+        if (i > 48)
+        {
+            uint64_t see1 = seed, see2 = seed;
+            do
+            {
+                seed = _Mix(_Read8(p) ^ _WY_P1, _Read8(p + 8) ^ seed);
+                see1 = _Mix(_Read8(p + 16) ^ _WY_P2, _Read8(p + 24) ^ see1);
+                see2 = _Mix(_Read8(p + 32) ^ _WY_P3, _Read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = _Mix(_Read8(p) ^ _WY_P1, _Read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = _Read8(p + i - 16);
+        b = _Read8(p + i - 8);
+    }
+
+    a ^= _WY_P1;
+    b ^= seed;
+    _Mum(&a, &b);
+    return _Mix(a ^ _WY_P0 ^ key_len, b ^ _WY_P1);
+}
+
+uint64_t HashUtil_Fnv1aHash(const char *key, size_t key_len, uint64_t seed)
+{
+    uint64_t hash = _FNV_OFFSET ^ seed;
+    for (size_t i = 0; i < key_len; i++)
+    {
+        hash ^= (uint8_t) key[i];
+        hash *= _FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t HashUtil_LegacyHash(const char *key, size_t key_len, uint64_t seed)
+{
+    (void) seed;
+    unsigned long hash = 0;
+    const int str_len = (int) key_len;
+    for (size_t i = 0; i < key_len; i++)
+    {
+        hash <<= 6;
+        hash += key[i] * _LEGACY_HASH_ARG ^ (str_len - 1);
+        hash ^= (hash >> 16) ^ (hash >> 8);
+    }
+    hash ^= (hash >> 24) ^ (hash >> 12);
+    return (uint32_t) ((int) hash ^ (hash >> 8) ^ (hash >> 4));
+}
+
+uint64_t HashUtil_ProcessSeed(void)
+{
+    uint64_t seed = __atomic_load_n(&_process_seed, __ATOMIC_ACQUIRE);
+    if (seed) return seed;
+
+    // 結合時間、CPU 時間與位址空間配置隨機化(ASLR)後的位址
+    int local;
+    uint64_t entropy = (uint64_t) time(NULL);
+    entropy = _Mix(entropy ^ _WY_P0, (uint64_t) clock() ^ _WY_P1);
+    entropy = _Mix(entropy ^ (uint64_t) (uintptr_t) &local, (uint64_t) (uintptr_t) &_process_seed ^ _WY_P2);
+    if (!entropy) entropy = _WY_P3;
+
+    uint64_t expected = 0;
+    __atomic_compare_exchange_n(&_process_seed, &expected, entropy, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&_process_seed, __ATOMIC_ACQUIRE);
+}
+
+uint64_t HashUtil_Mix(uint64_t a, uint64_t b)
+{
+    return _Mix(a ^ _WY_P0, b ^ _WY_P1);
+}
@@ -15,6 +15,7 @@ static const char *OBJECT_END = "}";
 static const char *INDENT = "  ";
 static const char *ARRAY_BEGIN = "[";
 static const char *ARRAY_END = "]";
+static const char *NULL_VALUE = "null";
 
 // 判定序列化時，是否需要縮排
 static const int NEED_INDENT = true;
@@ -44,11 +45,9 @@ static void _SerializeContent_Callback(
         case GEN_TYPE_TABLE:
         {
             GenericTable *gen_table = GenericType_GetTable(gen);
-            GenericTableIterator *iterator = GenericTable_GetIterator(gen_table);
-            char *map_str = _Callback(GEN_TYPE_TABLE, iterator, 0, level + 1, need_indent);
+            char *map_str = _Callback(GEN_TYPE_TABLE, gen_table, 0, level + 1, need_indent);
             StringBuilder_Append(builder, map_str);
             free(map_str);
-            Delete_GenericTableIterator(&iterator);
             break;
         }
         case GEN_TYPE_LIST:
@@ -60,6 +59,9 @@ static void _SerializeContent_Callback(
             free(list_str);
             break;
         }
+        case GEN_TYPE_NULL:
+            StringBuilder_Append(builder, NULL_VALUE);
+            break;
     }
 }
 
@@ -78,23 +80,23 @@ static char* _Object_ToJsonString(GenericTypeEnum type, void *items, int items_c
         StringBuilder_Append(builder, ARRAY_BEGIN);
     if (need_indent) depth++;
 
-    GenericTableIterator *iterator = NULL;
+    // 映射表以 cursor 直接走訪，不需配置迭代器
+    GenericTable_Cursor cursor;
     if (is_table) 
-        iterator = (GenericTableIterator*) items;
-    GenericTableItem *table_item = NULL;
+        cursor = GenericTable_Begin((GenericTable*) items);
+    const char *table_key = NULL;
+    GenericType *table_value = NULL;
     GenericType *array_item = NULL;
     int index = 0;
     bool keep_going;
     if (is_table)
-        keep_going = GenericTableIterator_HasNext((GenericTableIterator*) items);
+        keep_going = GenericTable_Next(&cursor, &table_key, &table_value);
     else
         keep_going = index < items_count;
     while (keep_going)
     {
-        if (is_table)
-            table_item = (GenericTableItem*) GenericTableIterator_Next(iterator);
-        else 
-            array_item = (GenericType*) GenericList_At(((GenericList*) items), index);
+        if (!is_table)
+            array_item = (GenericType*) GenericList_Get(((GenericList*) items), index);
         if (counter > 0) 
             StringBuilder_Append(builder, DELIMITER);
         if (need_indent)
@@ -107,14 +109,14 @@ static char* _Object_ToJsonString(GenericTypeEnum type, void *items, int items_c
         if (is_table)
         {
             StringBuilder_Append(builder, QUOTE);
-            StringBuilder_Append(builder, GenericTableItem_GetKey(table_item));
+            StringBuilder_Append(builder, table_key);
             StringBuilder_Append(builder, QUOTE);
             StringBuilder_Append(builder, COLON);
         }
         
         struct GenericType *gen;
         if (is_table)
-            gen = GenericTableItem_GetValue(table_item);
+            gen = table_value;
         else
             gen = array_item;
         GenericTypeEnum type = GenericType_GetType(gen);
@@ -129,7 +131,7 @@ static char* _Object_ToJsonString(GenericTypeEnum type, void *items, int items_c
         counter++;
         index++;
         if (is_table)
-            keep_going = GenericTableIterator_HasNext(iterator);
+            keep_going = GenericTable_Next(&cursor, &table_key, &table_value);
         else
             keep_going = index < items_count;
     }
@@ -152,18 +154,12 @@ static char* _Object_ToJsonString(GenericTypeEnum type, void *items, int items_c
 
 char* JsonSerializer_TableToStr(struct GenericTable *table)
 {
-    GenericTableIterator *iterator = GenericTable_GetIterator(table);
-    char *json_str = _Object_ToJsonString(GEN_TYPE_TABLE, iterator, 0, 0, NO_NEED_INDENT);
-    Delete_GenericTableIterator(&iterator);
-    return json_str;
+    return _Object_ToJsonString(GEN_TYPE_TABLE, table, 0, 0, NO_NEED_INDENT);
 }
 
 char* JsonSerializer_TableToIndentStr(struct GenericTable *table)
 {
-    GenericTableIterator *iterator = GenericTable_GetIterator(table);
-    char *json_str = _Object_ToJsonString(GEN_TYPE_TABLE, iterator, 0, 0, NEED_INDENT);
-    Delete_GenericTableIterator(&iterator);
-    return json_str;
+    return _Object_ToJsonString(GEN_TYPE_TABLE, table, 0, 0, NEED_INDENT);
 }
 
 char* JsonSerializer_ListToStr(struct GenericList *list)
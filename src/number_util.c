@@ -1,4 +1,4 @@
-#include "math.h"
+#include <stdint.h>
 
 #include "../include/number_util.h"
 #include "../include/common_util.h"
@@ -6,46 +6,76 @@
 // ================================================================================
 // Private Properties
 // ================================================================================
-static long _Next_PowerOf2(int input, int pow_number)
-{
-    int result = (long) pow(2, pow_number);
-    if (result > input)
-    {
-        return result;
-    }
-    if (result == NUMBER_UTIL_INT_MAX + 1)
-    {
-        // Integer 的最大正整數
-        return NUMBER_UTIL_INT_MAX;
-    }
-    return _Next_PowerOf2(input, pow_number + 1);
-}
-
 static bool _IsPrime(int input)
 {
-    if (input == 0 || input % 2 == 0) return false;
-    if (input < 9) return true;
-    int max = floor(sqrt((double) input));
-    int i = 3;
-    while (i < max)
+    if (input < 2) return false;
+    if (input % 2 == 0) return input == 2;
+    for (long i = 3; i * i <= input; i += 2)
     {
         if (input % i == 0) return false;
-        i += 2;
     }
     return true;
 }
 
+/**
+ * 容器大小使用的質數階梯，每一階約為前一階的 1.25 倍，
+ * 編譯時一併算出每個質數的 fastmod 常數
+ */
+#define _PRIME(p) { p, UINT64_MAX / (p) + 1 }
+
+static const NumberUtil_FastModPrime _PRIME_LADDER[] = {
+    _PRIME(17), _PRIME(23), _PRIME(29), _PRIME(37), _PRIME(47), _PRIME(59),
+    _PRIME(79), _PRIME(101), _PRIME(127), _PRIME(163), _PRIME(211), _PRIME(269),
+    _PRIME(337), _PRIME(431), _PRIME(541), _PRIME(677), _PRIME(853), _PRIME(1069),
+    _PRIME(1361), _PRIME(1709), _PRIME(2137), _PRIME(2677), _PRIME(3347), _PRIME(4201),
+    _PRIME(5261), _PRIME(6577), _PRIME(8231), _PRIME(10289), _PRIME(12889), _PRIME(16127),
+    _PRIME(20161), _PRIME(25219), _PRIME(31531), _PRIME(39419), _PRIME(49277), _PRIME(61603),
+    _PRIME(77017), _PRIME(96281), _PRIME(120371), _PRIME(150473), _PRIME(188107), _PRIME(235159),
+    _PRIME(293957), _PRIME(367453), _PRIME(459317), _PRIME(574157), _PRIME(717697), _PRIME(897133),
+    _PRIME(1121423), _PRIME(1401791), _PRIME(1752239), _PRIME(2190299), _PRIME(2737937), _PRIME(3422429),
+    _PRIME(4278037), _PRIME(5347553), _PRIME(6684443), _PRIME(8355563), _PRIME(10444457), _PRIME(13055587),
+    _PRIME(16319519), _PRIME(20399411), _PRIME(25499291), _PRIME(31874149), _PRIME(39842687), _PRIME(49803361),
+    _PRIME(62254207), _PRIME(77817767), _PRIME(97272239), _PRIME(121590311), _PRIME(151987889), _PRIME(189984863),
+    _PRIME(237481091), _PRIME(296851369), _PRIME(371064217), _PRIME(463830313), _PRIME(579787991), _PRIME(724735009),
+    _PRIME(905918777), _PRIME(1132398479), _PRIME(1415498113), _PRIME(1769372713), _PRIME(2147483647),
+};
+
+#undef _PRIME
+
+static const int _PRIME_LADDER_SIZE = sizeof(_PRIME_LADDER) / sizeof(_PRIME_LADDER[0]);
+
 // ================================================================================
 // Public properties
 // ================================================================================
 long NumberUtil_NextPowerOf_2(int input)
 {
-    int pow_number = 1;
-    return _Next_PowerOf2(input, pow_number);
+    long result = 2;
+    while (result <= input)
+    {
+        result <<= 1;
+    }
+    // Integer 的最大正整數
+    if (result > NUMBER_UTIL_INT_MAX) return NUMBER_UTIL_INT_MAX;
+    return result;
 }
 
 long NumberUtil_NextPrime(int input)
 {
-    if (_IsPrime(input)) return input;
-    return NumberUtil_NextPrime(input + 1);
+    while (!_IsPrime(input) && input < NUMBER_UTIL_INT_MAX)
+    {
+        input++;
+    }
+    return input;
+}
+
+NumberUtil_FastModPrime NumberUtil_LadderPrime(int input)
+{
+    int low = 0, high = _PRIME_LADDER_SIZE - 1;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (_PRIME_LADDER[mid].prime < input) low = mid + 1;
+        else high = mid;
+    }
+    return _PRIME_LADDER[low];
 }
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "../../include/generic_table.h"
+#include "../../include/generic_concurrent_table.h"
+#include "../../include/hash_util.h"
+#include "../../include/string_builder.h"
+#include "../../include/common_util.h"
+
+#define MAX_HISTOGRAM 8
+#define LINE_SIZE 1024
+#define MAX_THREADS 8
+#define READ_ROUNDS 4
+
+typedef struct HashCandidate
+{
+    const char *name;
+    GenericTableHashFn hash_fn;
+} HashCandidate;
+
+typedef struct KeySet
+{
+    const char *name;
+    char **keys;
+    int count;
+} KeySet;
+
+typedef struct ConcurrentWorker
+{
+    GenericConcurrentTable *table;
+    KeySet *set;
+    int begin;
+    int end;
+} ConcurrentWorker;
+
+static const HashCandidate CANDIDATES[] = {
+    {"legacy", HashUtil_LegacyHash},
+    {"fnv1a", HashUtil_Fnv1aHash},
+    {"wyhash", HashUtil_WyHash},
+};
+
+static KeySet _Generate_KeySet(const char *name, const char *prefix, const char *suffix, int count, int stride)
+{
+    KeySet set = {name, (char**) malloc(sizeof(char*) * count), count};
+    StringBuilder *builder = New_StringBuilder();
+    for (int i = 0; i < count; i++)
+    {
+        StringBuilder_Append(builder, prefix);
+        StringBuilder_Append(builder, i * stride);
+        StringBuilder_Append(builder, suffix);
+        set.keys[i] = StringBuilder_Value(builder);
+        StringBuilder_Clear(builder);
+    }
+    Delete_StringBuilder(&builder);
+    return set;
+}
+
+/**
+ * 從檔案讀取 key，每行一個
+ */
+static KeySet _Load_KeySet(const char *path)
+{
+    KeySet set = {path, NULL, 0};
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        s_out_err_f("can not open key file '%s'", path);
+        return set;
+    }
+
+    int capacity = 1024;
+    set.keys = (char**) malloc(sizeof(char*) * capacity);
+    char line[LINE_SIZE];
+    while (fgets(line, LINE_SIZE, file))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0') continue;
+        if (set.count == capacity)
+        {
+            capacity *= 2;
+            set.keys = (char**) realloc(set.keys, sizeof(char*) * capacity);
+        }
+        set.keys[set.count++] = strdup(line);
+    }
+    fclose(file);
+    return set;
+}
+
+static void _Delete_KeySet(KeySet *set)
+{
+    for (int i = 0; i < set->count; i++)
+    {
+        free(set->keys[i]);
+    }
+    free(set->keys);
+}
+
+static void _Print_Histogram(const char *label, int *histogram, long total, int max, int count)
+{
+    printf("    %-5s avg %.3f max %3d |", label, (double) total / count, max);
+    for (int i = 1; i <= MAX_HISTOGRAM; i++)
+    {
+        printf(" %s%d:%6.2f%%", i == MAX_HISTOGRAM ? ">=" : "", i, histogram[i] * 100.0 / count);
+    }
+    printf("\n");
+}
+
+static void _Bench(KeySet *set, const HashCandidate *candidate)
+{
+    int hit_histogram[MAX_HISTOGRAM + 1] = {0};
+    int miss_histogram[MAX_HISTOGRAM + 1] = {0};
+    long hit_total = 0, miss_total = 0;
+    int hit_max = 0, miss_max = 0;
+    char miss_key[LINE_SIZE + 8];
+
+    clock_t begin = clock();
+    GenericTable *table = New_GenericTable_WithHasher(0, 80, candidate->hash_fn, HashUtil_ProcessSeed());
+    for (int i = 0; i < set->count; i++)
+    {
+        GenericTable_Add(table, set->keys[i], i);
+    }
+    clock_t built = clock();
+
+    for (int i = 0; i < set->count; i++)
+    {
+        int probe = GenericTable_ProbeLength(table, set->keys[i]);
+        hit_total += probe;
+        if (probe > hit_max) hit_max = probe;
+        hit_histogram[probe < MAX_HISTOGRAM ? probe : MAX_HISTOGRAM]++;
+
+        snprintf(miss_key, sizeof(miss_key), "miss:%s", set->keys[i]);
+        probe = GenericTable_ProbeLength(table, miss_key);
+        miss_total += probe;
+        if (probe > miss_max) miss_max = probe;
+        miss_histogram[probe < MAX_HISTOGRAM ? probe : MAX_HISTOGRAM]++;
+    }
+    clock_t probed = clock();
+
+    printf("  %-8s build %8.2f ms, probe %8.2f ms\n",
+        candidate->name,
+        (double) (built - begin) / CLOCKS_PER_SEC * 1000,
+        (double) (probed - built) / CLOCKS_PER_SEC * 1000);
+    _Print_Histogram("hit", hit_histogram, hit_total, hit_max, set->count);
+    _Print_Histogram("miss", miss_histogram, miss_total, miss_max, set->count);
+    Delete_GenericTable(&table);
+}
+
+static double _Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* _Concurrent_Writer(void *arg)
+{
+    ConcurrentWorker *worker = (ConcurrentWorker*) arg;
+    for (int i = worker->begin; i < worker->end; i++)
+    {
+        GenericConcurrentTable_Add(worker->table, worker->set->keys[i], i);
+    }
+    return NULL;
+}
+
+static void* _Concurrent_Reader(void *arg)
+{
+    ConcurrentWorker *worker = (ConcurrentWorker*) arg;
+    int value;
+    for (int round = 0; round < READ_ROUNDS; round++)
+    {
+        for (int i = worker->begin; i < worker->end; i++)
+        {
+            GenericConcurrentTable_Find_Int(worker->table, worker->set->keys[i], &value);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * 以 thread_count 個執行緒各自處理一段 key，回傳經過的秒數(wall clock)
+ */
+static double _Concurrent_Run(void *(*routine)(void*), ConcurrentWorker *workers, int thread_count)
+{
+    pthread_t threads[MAX_THREADS];
+    double begin = _Now();
+    for (int i = 0; i < thread_count; i++) pthread_create(&threads[i], NULL, routine, &workers[i]);
+    for (int i = 0; i < thread_count; i++) pthread_join(threads[i], NULL);
+    return _Now() - begin;
+}
+
+/**
+ * 分片映射表在不同執行緒數量下的寫入、讀取吞吐量，
+ * 讀取只取分片的讀鎖，執行緒數量不超過 CPU 數量時應接近線性成長
+ */
+static void _Bench_Concurrent(KeySet *set)
+{
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("concurrent table, key set '%s', %d keys, %ld cpus online\n", set->name, set->count, cpu_count);
+
+    double single_read_mops = 0;
+    for (int thread_count = 1; thread_count <= MAX_THREADS; thread_count *= 2)
+    {
+        GenericConcurrentTable *table = New_GenericConcurrentTable(0);
+        ConcurrentWorker workers[MAX_THREADS];
+        int per_thread = set->count / thread_count;
+        for (int i = 0; i < thread_count; i++)
+        {
+            workers[i].table = table;
+            workers[i].set = set;
+            workers[i].begin = i * per_thread;
+            workers[i].end = i == thread_count - 1 ? set->count : (i + 1) * per_thread;
+        }
+
+        double write_mops = set->count / _Concurrent_Run(_Concurrent_Writer, workers, thread_count) / 1e6;
+        double read_mops = (double) set->count * READ_ROUNDS / _Concurrent_Run(_Concurrent_Reader, workers, thread_count) / 1e6;
+        if (thread_count == 1) single_read_mops = read_mops;
+
+        // 只有執行緒數量以內的 CPU 能同時執行，以此估計應有的倍數
+        int parallel = thread_count < cpu_count ? thread_count : (int) cpu_count;
+        double speedup = read_mops / single_read_mops;
+        printf("  %d threads: write %8.2f Mops/s, read %8.2f Mops/s, read speedup %.2fx%s\n",
+            thread_count, write_mops, read_mops, speedup, speedup < parallel * 0.5 ? " (below half of linear)" : "");
+        Delete_GenericConcurrentTable(&table);
+    }
+}
+
+/**
+ * 比較各雜湊函式在不同 key 集合上的探測長度(單位：16 個位置的群組)，
+ * 可傳入檔案路徑作為額外的 key 集合，每行一個 key，
+ * 最後量測分片映射表在不同執行緒數量下的吞吐量
+ */
+int main(int argc, char **argv)
+{
+    int count = argc > 2 ? atoi(argv[2]) : 200000;
+    KeySet sets[4];
+    int set_count = 0;
+    sets[set_count++] = _Generate_KeySet("user:<id>", "user:", "", count, 1);
+    sets[set_count++] = _Generate_KeySet("Prefix_<id>_Suffix", "Prefix_", "_Suffix", count, 1);
+    sets[set_count++] = _Generate_KeySet("order:<id*1024>", "order:", "", count, 1024);
+    if (argc > 1) sets[set_count++] = _Load_KeySet(argv[1]);
+
+    int candidate_count = sizeof(CANDIDATES) / sizeof(CANDIDATES[0]);
+    for (int s = 0; s < set_count; s++)
+    {
+        if (sets[s].count == 0) continue;
+        printf("key set '%s', %d keys\n", sets[s].name, sets[s].count);
+        for (int c = 0; c < candidate_count; c++)
+        {
+            _Bench(&sets[s], &CANDIDATES[c]);
+        }
+    }
+    _Bench_Concurrent(&sets[0]);
+
+    for (int s = 0; s < set_count; s++)
+    {
+        _Delete_KeySet(&sets[s]);
+    }
+    return 0;
+}
@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "../../include/generic_concurrent_table.h"
+#include "../../include/generic_read_mostly_table.h"
+#include "../../include/generic_table.h"
+#include "../../include/generic_type.h"
+#include "../../include/common_util.h"
+
+#define KEY_COUNT 200000
+
+typedef struct Worker
+{
+    GenericConcurrentTable *table;
+    int begin;
+    int end;
+    int found;
+} Worker;
+
+static double _Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* _Writer(void *arg)
+{
+    Worker *worker = (Worker*) arg;
+    char key[32];
+    for (int i = worker->begin; i < worker->end; i++)
+    {
+        sprintf(key, "key_%d", i);
+        GenericConcurrentTable_Add(worker->table, key, i);
+    }
+    return NULL;
+}
+
+static void* _Reader(void *arg)
+{
+    Worker *worker = (Worker*) arg;
+    char key[32];
+    for (int round = 0; round < 4; round++)
+    {
+        for (int i = worker->begin; i < worker->end; i++)
+        {
+            sprintf(key, "key_%d", i);
+            int value;
+            if (GenericConcurrentTable_Find_Int(worker->table, key, &value) && value == i) worker->found++;
+        }
+    }
+    return NULL;
+}
+
+static void _Run(void *(*routine)(void*), Worker *workers, int thread_count)
+{
+    pthread_t threads[16];
+    for (int i = 0; i < thread_count; i++) pthread_create(&threads[i], NULL, routine, &workers[i]);
+    for (int i = 0; i < thread_count; i++) pthread_join(threads[i], NULL);
+}
+
+static void _CountVisitor(const char *key, GenericType *value, void *context)
+{
+    int *count = (int*) context;
+    if (GenericType_GetType(value) == GEN_TYPE_INT && *GenericType_GetInt(value) == atoi(key + 4)) (*count)++;
+}
+
+void Concurrent_Basic_Test()
+{
+    s_out("\n\nBegin concurrent table basic test");
+    GenericConcurrentTable *table = New_GenericConcurrentTable(8);
+    GenericConcurrentTable_Add(table, "name", "tester");
+    GenericConcurrentTable_Add(table, "age", 30);
+    GenericConcurrentTable_Add(table, "pi", 3.14);
+
+    char *name = GenericConcurrentTable_Find_Str(table, "name");
+    int age = 0;
+    double pi = 0;
+    if (name && strcmp(name, "tester") == 0)
+    {
+        s_out("find name success");
+    }
+    else
+    {
+        s_out("find name fail");
+    }
+    free(name);
+    if (GenericConcurrentTable_Find_Int(table, "age", &age) && age == 30)
+    {
+        s_out("find age success");
+    }
+    else
+    {
+        s_out("find age fail");
+    }
+    if (GenericConcurrentTable_Find_Double(table, "pi", &pi) && pi == 3.14)
+    {
+        s_out("find pi success");
+    }
+    else
+    {
+        s_out("find pi fail");
+    }
+    if (!GenericConcurrentTable_Find_Int(table, "name", &age))
+    {
+        s_out("find int of a string is rejected");
+    }
+    else
+    {
+        s_out("find int of a string fail");
+    }
+
+    GenericConcurrentTable_Delete(table, "age");
+    if (!GenericConcurrentTable_HasKey(table, "age") && GenericConcurrentTable_Size(table) == 2)
+    {
+        s_out("delete success");
+    }
+    else
+    {
+        s_out("delete fail");
+    }
+    Delete_GenericConcurrentTable(&table);
+}
+
+void Concurrent_Threads_Test()
+{
+    s_out("\n\nBegin concurrent table threads test");
+    int thread_counts[] = {1, 2, 4, 8};
+    for (int t = 0; t < 4; t++)
+    {
+        int thread_count = thread_counts[t];
+        GenericConcurrentTable *table = New_GenericConcurrentTable(0);
+        Worker workers[16];
+        int per_thread = KEY_COUNT / thread_count;
+        for (int i = 0; i < thread_count; i++)
+        {
+            workers[i].table = table;
+            workers[i].begin = i * per_thread;
+            workers[i].end = i == thread_count - 1 ? KEY_COUNT : (i + 1) * per_thread;
+            workers[i].found = 0;
+        }
+
+        // 吞吐量與擴展性由 bench_hash 量測，這裡只檢查結果
+        _Run(_Writer, workers, thread_count);
+        _Run(_Reader, workers, thread_count);
+
+        int found = 0;
+        for (int i = 0; i < thread_count; i++) found += workers[i].found;
+        int visited = 0;
+        GenericConcurrentTable_ForEach(table, _CountVisitor, &visited);
+        int size = GenericConcurrentTable_Size(table);
+
+        if (size == KEY_COUNT && visited == KEY_COUNT && found == KEY_COUNT * 4)
+        {
+            s_out_f("%d threads: every key written, visited and found", thread_count);
+        }
+        else
+        {
+            s_out_f("threads test fail, size = %d, visited = %d, found = %d", size, visited, found);
+        }
+        Delete_GenericConcurrentTable(&table);
+    }
+}
+
+typedef struct ReadMostlyWorker
+{
+    GenericReadMostlyTable *table;
+    atomic_int *stop;
+    long reads;
+    long wrong;
+} ReadMostlyWorker;
+
+static void* _ReadMostlyReader(void *arg)
+{
+    ReadMostlyWorker *worker = (ReadMostlyWorker*) arg;
+    char key[32];
+    unsigned int seed = 7;
+    while (!atomic_load(worker->stop))
+    {
+        int i = rand_r(&seed) % KEY_COUNT;
+        sprintf(key, "key_%d", i);
+        long value;
+        // 寫入端只會寫入 i 或 -i，讀到其他值代表讀到已釋放的記憶體
+        if (GenericReadMostlyTable_Find_Long(worker->table, key, &value) && value != i && value != -i) worker->wrong++;
+        worker->reads++;
+    }
+    return NULL;
+}
+
+void ReadMostly_Test()
+{
+    s_out("\n\nBegin read mostly table test");
+    GenericReadMostlyTable *table = New_GenericReadMostlyTable();
+    char key[32];
+    for (int i = 0; i < KEY_COUNT / 2; i++)
+    {
+        sprintf(key, "key_%d", i);
+        GenericReadMostlyTable_Add(table, key, (long) i);
+    }
+
+    atomic_int stop = 0;
+    ReadMostlyWorker workers[4];
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++)
+    {
+        workers[i] = (ReadMostlyWorker) {table, &stop, 0, 0};
+        pthread_create(&threads[i], NULL, _ReadMostlyReader, &workers[i]);
+    }
+
+    // 讀取端持續查找時，更新、刪除並新增到擴充容器
+    double begin = _Now();
+    for (int i = 0; i < KEY_COUNT / 2; i++)
+    {
+        sprintf(key, "key_%d", i);
+        if (i % 3 == 0) GenericReadMostlyTable_Delete(table, key);
+        else GenericReadMostlyTable_Add(table, key, (long) -i);
+        sprintf(key, "key_%d", KEY_COUNT / 2 + i);
+        GenericReadMostlyTable_Add(table, key, (long) (KEY_COUNT / 2 + i));
+    }
+    double seconds = _Now() - begin;
+    atomic_store(&stop, 1);
+
+    long reads = 0, wrong = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_join(threads[i], NULL);
+        reads += workers[i].reads;
+        wrong += workers[i].wrong;
+    }
+    s_out_f("4 readers: %.2f Mops/s during writes", reads / seconds / 1e6);
+
+    int expected = KEY_COUNT - (KEY_COUNT / 2 + 2) / 3;
+    long value = 0;
+    bool ok = GenericReadMostlyTable_Size(table) == expected && wrong == 0
+        && !GenericReadMostlyTable_HasKey(table, "key_3")
+        && GenericReadMostlyTable_Find_Long(table, "key_4", &value) && value == -4;
+    GenericReadMostlyTable_ReadBegin(table);
+    GenericType *found = GenericReadMostlyTable_Find(table, "key_150000");
+    ok = ok && found && *GenericType_GetLong(found) == 150000;
+    GenericReadMostlyTable_ReadEnd(table);
+    if (ok)
+    {
+        s_out("read mostly table test success");
+    }
+    else
+    {
+        s_out_f("read mostly table test fail, size = %d, wrong = %ld", GenericReadMostlyTable_Size(table), wrong);
+    }
+    Delete_GenericReadMostlyTable(&table);
+}
+
+void ReadMostly_Delete_Test()
+{
+    s_out("\n\nBegin read mostly table delete test");
+    GenericReadMostlyTable *outer = New_GenericReadMostlyTable();
+    GenericReadMostlyTable_Add(outer, "name", "outer");
+
+    // 在另一個映射表的讀取區段中解構，世代無法推進，只能直接釋放自己延後釋放的記憶體
+    GenericReadMostlyTable_ReadBegin(outer);
+    GenericReadMostlyTable *inner = New_GenericReadMostlyTable();
+    char key[32];
+    for (int i = 0; i < 1000; i++)
+    {
+        sprintf(key, "key_%d", i);
+        GenericReadMostlyTable_Add(inner, key, i);
+        GenericReadMostlyTable_Add(inner, key, -i);
+    }
+    Delete_GenericReadMostlyTable(&inner);
+    Delete_GenericReadMostlyTable(&inner);
+    GenericType *name = GenericReadMostlyTable_Find(outer, "name");
+    bool ok = !inner && name && strcmp(GenericType_GetStr(name), "outer") == 0;
+    GenericReadMostlyTable_ReadEnd(outer);
+
+    if (ok)
+    {
+        s_out("read mostly table delete test success");
+    }
+    else
+    {
+        s_out("read mostly table delete test fail");
+    }
+    Delete_GenericReadMostlyTable(&outer);
+}
+
+int main(int argc, char **argv)
+{
+    Concurrent_Basic_Test();
+    Concurrent_Threads_Test();
+    ReadMostly_Test();
+    ReadMostly_Delete_Test();
+}
@@ -49,7 +49,32 @@ void List_Basic_Test()
     Delete_GenericList(&list);
 }
 
+void List_Grow_Test()
+{
+    s_out("\n\nBegin list grow test");
+    GenericList *list = New_GenericList();
+    for (int i = 0; i < 1000; i++)
+    {
+        GenericList_Add(list, i);
+    }
+    bool all_correct = GenericList_Size(list) == 1000;
+    for (int i = 0; i < GenericList_Size(list); i++)
+    {
+        if (*GenericType_GetInt(GenericList_At(list, i)) != i) all_correct = false;
+    }
+    if (all_correct)
+    {
+        s_out("list grows to 1000 elements");
+    }
+    else
+    {
+        s_out("list grow failed");
+    }
+    Delete_GenericList(&list);
+}
+
 int main(int argc, char **argv)
 {
     List_Basic_Test();
+    List_Grow_Test();
 }
\ No newline at end of file
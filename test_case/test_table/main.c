@@ -2,13 +2,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
 
 #include "../../include/json_serializer.h"
 #include "../../include/generic_list.h"
 #include "../../include/generic_table.h"
+#include "../../include/generic_arena.h"
 #include "../../include/generic_type.h"
 #include "../../include/string_builder.h"
 #include "../../include/common_util.h"
+#include "../../include/hash_util.h"
+#include "../../include/number_util.h"
+#include "../../include/generic_string.h"
+#include "../../include/generic_dedup.h"
 
 void GenericTable_Simple_Test(void)
 {
@@ -21,7 +27,7 @@ void GenericTable_Simple_Test(void)
     const char *value = "World";
     GenericTable_Add(table, key, value);
 
-    char *v = GenericTable_Find_Str(table, key);
+    const char *v = GenericTable_Find_Str(table, key);
     if (strcmp(value, v) == 0)
     {
         s_out("the value from generic table is the same as input");
@@ -231,12 +237,1464 @@ void NestHybridStructure_Test()
     Delete_GenericTable(&table1);
 }
 
+static uint64_t _Constant_Hash(const char *key, size_t key_len, uint64_t seed)
+{
+    return seed;
+}
+
+void Hasher_Test()
+{
+    s_out("\n\nBegin GenericTable custom hasher test\n");
+
+    s_out("every key collides when the hash function is constant, the table should still work");
+    GenericTable *table = New_GenericTable_WithHasher(0, 80, _Constant_Hash, 0x2a);
+    char key[32];
+    for (int i = 0; i < 500; i++)
+    {
+        sprintf(key, "key_%d", i);
+        GenericTable_Add(table, key, i);
+    }
+    bool all_found = GenericTable_Size(table) == 500;
+    for (int i = 0; i < 500; i++)
+    {
+        sprintf(key, "key_%d", i);
+        int *val = GenericTable_Find_Int(table, key);
+        if (!val || *val != i) all_found = false;
+    }
+    if (all_found)
+        s_out("OK, all 500 colliding keys are found");
+    else
+        s_out("failed, some colliding keys are missing");
+    s_out_f("probe length of 'key_499' is %d groups", GenericTable_ProbeLength(table, "key_499"));
+    Delete_GenericTable(&table);
+
+    s_out("\nthe same key set with seeded wyhash");
+    table = New_GenericTable_WithHasher(0, 80, HashUtil_WyHash, HashUtil_ProcessSeed());
+    for (int i = 0; i < 500; i++)
+    {
+        sprintf(key, "key_%d", i);
+        GenericTable_Add(table, key, i);
+    }
+    s_out_f("probe length of 'key_499' is %d groups", GenericTable_ProbeLength(table, "key_499"));
+    Delete_GenericTable(&table);
+}
+
+void Incremental_Rehash_Test()
+{
+    s_out("\n\nBegin GenericTable incremental rehash test\n");
+
+    int count = 1000 * 1000;
+    s_out_f("put %d keys into a table with default bucket size, and record the slowest single put", count);
+    GenericTable *table = New_GenericTable();
+    char key[32];
+    double slowest = 0;
+    for (int i = 0; i < count; i++)
+    {
+        sprintf(key, "user:%d", i);
+        clock_t begin = clock();
+        GenericTable_Add(table, key, i);
+        double period = (double) (clock() - begin) / CLOCKS_PER_SEC * 1000;
+        if (period > slowest) slowest = period;
+    }
+    s_out_f("the slowest put took %f milli seconds", slowest);
+
+    bool all_found = GenericTable_Size(table) == count;
+    for (int i = 0; i < count; i++)
+    {
+        sprintf(key, "user:%d", i);
+        int *val = GenericTable_Find_Int(table, key);
+        if (!val || *val != i) all_found = false;
+    }
+    if (all_found)
+        s_out("OK, all keys are found while old and new buckets coexist");
+    else
+        s_out("failed, some keys are missing");
+    Delete_GenericTable(&table);
+}
+
+void RobinHood_Test()
+{
+    s_out("\n\nBegin GenericTable Robin Hood probing test\n");
+
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    options.probing = GENERIC_TABLE_PROBE_ROBIN_HOOD;
+    GenericTable *table = New_GenericTable_WithOptions(&options);
+
+    int count = 10000;
+    char key[32];
+    for (int i = 0; i < count; i++)
+    {
+        sprintf(key, "session:%d", i);
+        GenericTable_Add(table, key, i);
+    }
+
+    s_out_f("churn %d keys by deleting the oldest key and adding a new one, the size stays the same", count * 10);
+    for (int i = 0; i < count * 10; i++)
+    {
+        sprintf(key, "session:%d", i);
+        GenericTable_Delete(table, key);
+        sprintf(key, "session:%d", i + count);
+        GenericTable_Add(table, key, i + count);
+    }
+
+    bool all_found = GenericTable_Size(table) == count;
+    int longest = 0;
+    for (int i = count * 10; i < count * 11; i++)
+    {
+        sprintf(key, "session:%d", i);
+        int *val = GenericTable_Find_Int(table, key);
+        if (!val || *val != i) all_found = false;
+        int probe = GenericTable_ProbeLength(table, key);
+        if (probe > longest) longest = probe;
+    }
+    sprintf(key, "session:%d", 0);
+    if (all_found && !GenericTable_HasKey(table, key))
+    {
+        s_out_f("OK, all live keys are found, deleted keys are gone, the longest probe is %d slots", longest);
+    }
+    else
+    {
+        s_out("failed, the table content is not correct after churn");
+    }
+    Delete_GenericTable(&table);
+}
+
+void FindMany_Test()
+{
+    s_out("\n\nBegin GenericTable batched lookup test\n");
+
+    int count = 1000 * 1000;
+    int batch = 256;
+    GenericTable *table = New_GenericTable_WithBucketSize(count * 2);
+    char **keys = (char**) malloc(sizeof(char*) * count);
+    for (int i = 0; i < count; i++)
+    {
+        keys[i] = (char*) malloc(32);
+        sprintf(keys[i], "user:%d", i);
+        if (i % 2 == 0) GenericTable_Add(table, keys[i], i);
+    }
+
+    s_out_f("look up %d keys, half of them exist, %d keys per batch", count, batch);
+    GenericType **values = (GenericType**) malloc(sizeof(GenericType*) * batch);
+    bool *exists = (bool*) malloc(sizeof(bool) * batch);
+    bool all_correct = true;
+    clock_t begin = clock();
+    for (int i = 0; i + batch <= count; i += batch)
+    {
+        GenericTable_FindMany(table, (const char**) keys + i, batch, values);
+        GenericTable_HasKeyMany(table, (const char**) keys + i, batch, exists);
+        for (int j = 0; j < batch; j++)
+        {
+            int index = i + j;
+            bool expected = index % 2 == 0;
+            if ((values[j] != NULL) != expected || exists[j] != expected) all_correct = false;
+            if (values[j] && *GenericType_GetInt(values[j]) != index) all_correct = false;
+        }
+    }
+    s_out_f("batched lookup took %f milli seconds", (double) (clock() - begin) / CLOCKS_PER_SEC * 1000);
+
+    begin = clock();
+    for (int i = 0; i < count; i++)
+    {
+        int *val = GenericTable_Find_Int(table, keys[i]);
+        if ((val != NULL) != (i % 2 == 0)) all_correct = false;
+    }
+    s_out_f("one by one lookup took %f milli seconds", (double) (clock() - begin) / CLOCKS_PER_SEC * 1000);
+
+    if (all_correct)
+    {
+        s_out("OK, batched results are the same as one by one lookup");
+    }
+    else
+    {
+        s_out("failed, batched results are different from one by one lookup");
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        free(keys[i]);
+    }
+    free(keys);
+    free(values);
+    free(exists);
+    Delete_GenericTable(&table);
+}
+
+void InlineKey_Test()
+{
+    s_out("\n\nBegin GenericTable inline key test\n");
+
+    // 長度 0 ~ 63 的 key，涵蓋直接存放與另外配置的邊界
+    GenericTable *table = New_GenericTable();
+    char key[64];
+    for (int len = 0; len < 64; len++)
+    {
+        for (int i = 0; i < len; i++) key[i] = 'a' + (i + len) % 26;
+        key[len] = '\0';
+        GenericTable_Add(table, key, len);
+    }
+    for (int i = 0; i < 1000; i++)
+    {
+        sprintf(key, "k%d", i);
+        GenericTable_Add(table, key, i);
+    }
+
+    bool all_correct = GenericTable_Size(table) == 1064;
+    for (int len = 0; len < 64; len++)
+    {
+        for (int i = 0; i < len; i++) key[i] = 'a' + (i + len) % 26;
+        key[len] = '\0';
+        int *val = GenericTable_Find_Int(table, key);
+        if (!val || *val != len) all_correct = false;
+        key[len / 2] = '#';
+        if (len > 0 && GenericTable_HasKey(table, key)) all_correct = false;
+    }
+
+    int key_count = 0;
+    GenericTableIterator *iterator = GenericTable_GetIterator(table);
+    while (GenericTableIterator_HasNext(iterator))
+    {
+        GenericTableItem *item = GenericTableIterator_Next(iterator);
+        if (GenericTable_Find_Int(table, GenericTableItem_GetKey(item))) key_count++;
+    }
+    Delete_GenericTableIterator(&iterator);
+    if (key_count != 1064) all_correct = false;
+
+    if (all_correct)
+    {
+        s_out("OK, short and long keys are all found");
+    }
+    else
+    {
+        s_out("failed, some keys are lost");
+    }
+    Delete_GenericTable(&table);
+}
+
+/**
+ * 建立一份模擬請求的文件樹，arena 為 NULL 時以 malloc 配置
+ */
+static GenericTable* _BuildDocument(GenericArena *arena, int id)
+{
+    GenericTable *doc = arena ? New_GenericTable_InArena(arena) : New_GenericTable();
+    GenericTable_Add(doc, "id", id);
+    GenericTable_Add(doc, "name", "document with a fairly long name");
+    GenericTable_Add(doc, "score", 0.5 * id);
+    GenericList *tags = arena ? New_GenericList_InArena(arena) : New_GenericList();
+    for (int i = 0; i < 40; i++)
+    {
+        GenericList_Add(tags, i);
+    }
+    GenericTable_Add(doc, "tags", tags);
+    for (int i = 0; i < 8; i++)
+    {
+        GenericTable *field = arena ? New_GenericTable_InArena(arena) : New_GenericTable();
+        GenericTable_Add(field, "index", i);
+        GenericTable_Add(field, "label", "field");
+        char key[32];
+        sprintf(key, "field_%d", i);
+        GenericTable_Add(doc, key, field);
+    }
+    return doc;
+}
+
+void Arena_Test()
+{
+    s_out("\n\nBegin GenericTable arena test\n");
+
+    int rounds = 20000;
+    clock_t begin = clock();
+    for (int i = 0; i < rounds; i++)
+    {
+        GenericTable *doc = _BuildDocument(NULL, i);
+        Delete_GenericTable(&doc);
+    }
+    s_out_f("build and delete %d documents with malloc took %f milli seconds",
+        rounds, (double) (clock() - begin) / CLOCKS_PER_SEC * 1000);
+
+    GenericArena *arena = New_GenericArena();
+    begin = clock();
+    for (int i = 0; i < rounds; i++)
+    {
+        GenericTable *doc = _BuildDocument(arena, i);
+        Delete_GenericTable(&doc);
+        GenericArena_Reset(arena);
+    }
+    s_out_f("build and reset %d documents in arena took %f milli seconds",
+        rounds, (double) (clock() - begin) / CLOCKS_PER_SEC * 1000);
+
+    // arena 與 malloc 建立的文件應輸出相同的 JSON，放入 arena 的 malloc 映射表由 arena 解構
+    GenericTable *heap_doc = _BuildDocument(NULL, 7);
+    GenericTable *arena_doc = _BuildDocument(arena, 7);
+    GenericTable *heap_child = New_GenericTable();
+    GenericTable_Add(heap_child, "from", "heap");
+    GenericTable_Add(arena_doc, "child", heap_child);
+    GenericTable_Add(arena_doc, "replaced", New_GenericTable());
+    GenericTable_Add(arena_doc, "replaced", 1);
+    GenericTable_Delete(arena_doc, "child");
+    GenericTable_Delete(arena_doc, "replaced");
+    char *heap_str = JsonSerializer_ToStr(heap_doc);
+    char *arena_str = JsonSerializer_ToStr(arena_doc);
+    if (strcmp(heap_str, arena_str) == 0 && GenericTable_GetArena(arena_doc) == arena)
+    {
+        s_out_f("OK, arena document is the same as malloc document, arena used %zu bytes", GenericArena_BytesUsed(arena));
+    }
+    else
+    {
+        s_out("failed, arena document is different from malloc document");
+    }
+    free(heap_str);
+    free(arena_str);
+    Delete_GenericTable(&heap_doc);
+
+    GenericTable *kept = _BuildDocument(arena, 9);
+    GenericTable_Add(kept, "child", New_GenericTable());
+    Delete_GenericArena(&arena);
+}
+
+void Reserve_Test()
+{
+    s_out("\n\nBegin GenericTable reserve test\n");
+
+    int count = 100000;
+    char key[32];
+    GenericTable *table = New_GenericTable();
+    GenericTable_Reserve(table, count);
+    int reserved = GenericTable_Capacity(table);
+    bool resized = false;
+    for (int i = 0; i < count; i++)
+    {
+        sprintf(key, "key_%d", i);
+        GenericTable_Add(table, key, i);
+        if (GenericTable_Capacity(table) != reserved) resized = true;
+    }
+    if (!resized)
+    {
+        s_out_f("OK, %d keys are added into reserved capacity %d without resize", count, reserved);
+    }
+    else
+    {
+        s_out_f("failed, capacity changed from %d to %d", reserved, GenericTable_Capacity(table));
+    }
+
+    // 關閉自動縮減，刪除後容器維持原本大小，直到呼叫 GenericTable_ShrinkToFit
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    options.auto_shrink = false;
+    GenericTable *no_shrink = New_GenericTable_WithOptions(&options);
+    for (int i = 0; i < count; i++)
+    {
+        sprintf(key, "key_%d", i);
+        GenericTable_Add(no_shrink, key, i);
+    }
+    int grown = GenericTable_Capacity(no_shrink);
+    for (int i = 10; i < count; i++)
+    {
+        sprintf(key, "key_%d", i);
+        GenericTable_Delete(no_shrink, key);
+    }
+    int after_delete = GenericTable_Capacity(no_shrink);
+    GenericTable_ShrinkToFit(no_shrink);
+    int after_shrink = GenericTable_Capacity(no_shrink);
+    int *val = GenericTable_Find_Int(no_shrink, "key_9");
+    s_out_f("capacity %d after adds, %d after deletes, %d after shrink to fit", grown, after_delete, after_shrink);
+    if (after_delete == grown && after_shrink < grown && GenericTable_Size(no_shrink) == 10 && val && *val == 9)
+    {
+        s_out("OK, capacity only shrinks on demand");
+    }
+    else
+    {
+        s_out("failed, capacity changed unexpectedly");
+    }
+
+    Delete_GenericTable(&table);
+    Delete_GenericTable(&no_shrink);
+}
+
+void Sizing_Test()
+{
+    s_out("\n\nBegin GenericTable sizing test\n");
+
+    GenericTableSizing modes[] = {GENERIC_TABLE_SIZE_PRIME, GENERIC_TABLE_SIZE_POW2};
+    const char *names[] = {"prime", "power of 2"};
+    char key[32];
+    for (int m = 0; m < 2; m++)
+    {
+        GenericTableOptions options = GenericTable_DefaultOptions();
+        options.sizing = modes[m];
+        GenericTable *table = New_GenericTable_WithOptions(&options);
+        bool all_correct = true;
+        for (int i = 0; i < 50000; i++)
+        {
+            sprintf(key, "key_%d", i);
+            GenericTable_Add(table, key, i);
+            int capacity = GenericTable_Capacity(table);
+            bool valid = modes[m] == GENERIC_TABLE_SIZE_POW2
+                ? (capacity & (capacity - 1)) == 0
+                : NumberUtil_NextPrime(capacity) == capacity;
+            if (!valid) all_correct = false;
+        }
+        for (int i = 0; i < 50000; i++)
+        {
+            sprintf(key, "key_%d", i);
+            int *val = GenericTable_Find_Int(table, key);
+            if (!val || *val != i) all_correct = false;
+        }
+        if (all_correct)
+        {
+            s_out_f("OK, %s sizing keeps all keys, capacity %d", names[m], GenericTable_Capacity(table));
+        }
+        else
+        {
+            s_out_f("failed, %s sizing lost keys or used an invalid capacity", names[m]);
+        }
+        Delete_GenericTable(&table);
+    }
+}
+
+/**
+ * 以相同順序放入相同的 key，但使用不同的種子
+ */
+static GenericTable* _BuildOrdered(uint64_t seed, GenericTableProbing probing)
+{
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    options.ordered = true;
+    options.seed = seed;
+    options.probing = probing;
+    GenericTable *table = New_GenericTable_WithOptions(&options);
+    char key[32];
+    for (int i = 0; i < 3000; i++)
+    {
+        sprintf(key, "key_%d", (i * 7919) % 3000);
+        GenericTable_Add(table, key, i);
+    }
+    // 刪除、更新都不影響其餘 key 的順序，重新放入的 key 排在最後
+    for (int i = 0; i < 3000; i += 3)
+    {
+        sprintf(key, "key_%d", (i * 7919) % 3000);
+        GenericTable_Delete(table, key);
+    }
+    for (int i = 1; i < 3000; i += 3)
+    {
+        sprintf(key, "key_%d", (i * 7919) % 3000);
+        GenericTable_Add(table, key, -i);
+    }
+    GenericTable_Add(table, "key_0", 0);
+    return table;
+}
+
+void LoadFactor_Test()
+{
+    s_out("\n\nBegin GenericTable load factor test\n");
+
+    GenericTableProbing probings[] = {GENERIC_TABLE_PROBE_GROUP, GENERIC_TABLE_PROBE_ROBIN_HOOD};
+    int load_factors[] = {0, 100, 150};
+    int count = 20000;
+    char key[32];
+    for (int p = 0; p < 2; p++)
+    {
+        for (int l = 0; l < 3; l++)
+        {
+            GenericTableOptions options = GenericTable_DefaultOptions();
+            options.probing = probings[p];
+            options.load_factor = load_factors[l];
+            GenericTable *table = New_GenericTable_WithOptions(&options);
+            for (int i = 0; i < count; i++)
+            {
+                sprintf(key, "load:%d", i);
+                GenericTable_Add(table, key, i);
+            }
+            int missing = 0;
+            for (int i = 0; i < count; i++)
+            {
+                sprintf(key, "load:%d", i);
+                int *val = GenericTable_Find_Int(table, key);
+                if (!val || *val != i) missing++;
+            }
+            if (GenericTable_Size(table) == count && missing == 0)
+            {
+                s_out_f("OK, load factor %d is replaced by the default, all %d keys are kept", load_factors[l], count);
+            }
+            else
+            {
+                s_out_f("failed, load factor %d keeps %d keys and loses %d", load_factors[l], GenericTable_Size(table), missing);
+            }
+            Delete_GenericTable(&table);
+        }
+    }
+
+    // 負載係數低於 50 時，重構後的容器大小也要依負載係數換算，否則每次新增都會以相同大小重構
+    int low_factors[] = {10, 30, 40};
+    for (int l = 0; l < 3; l++)
+    {
+        GenericTableOptions options = GenericTable_DefaultOptions();
+        options.load_factor = low_factors[l];
+        GenericTable *table = New_GenericTable_WithOptions(&options);
+        for (int i = 0; i < count; i++)
+        {
+            sprintf(key, "load:%d", i);
+            GenericTable_Add(table, key, i);
+        }
+        GenericTableStats stats;
+        GenericTable_GetStats(table, &stats);
+        if (stats.rehash_count == 0)
+        {
+            s_out_f("OK, load factor %d grows %d times without same size rehash", low_factors[l], stats.grow_count);
+        }
+        else
+        {
+            s_out_f("failed, load factor %d rehashes %d times at the same size", low_factors[l], stats.rehash_count);
+        }
+        Delete_GenericTable(&table);
+    }
+}
+
+void Ordered_Test()
+{
+    s_out("\n\nBegin GenericTable ordered test\n");
+
+    GenericTable *table = _BuildOrdered(1, GENERIC_TABLE_PROBE_GROUP);
+    bool in_order = true;
+    int previous = -1;
+    int count = 0;
+    GenericTableIterator *iterator = GenericTable_GetIterator(table);
+    while (GenericTableIterator_HasNext(iterator))
+    {
+        GenericTableItem *item = GenericTableIterator_Next(iterator);
+        int value = *GenericType_GetInt(GenericTableItem_GetValue(item));
+        int order = value < 0 ? -value : value;
+        if (strcmp(GenericTableItem_GetKey(item), "key_0") == 0)
+        {
+            order = 3000;
+        }
+        if (order <= previous) in_order = false;
+        previous = order;
+        count++;
+    }
+    Delete_GenericTableIterator(&iterator);
+    if (in_order && count == 2001)
+    {
+        s_out("OK, iterator follows insertion order");
+    }
+    else
+    {
+        s_out_f("failed, iterator is out of insertion order, count = %d", count);
+    }
+
+    GenericTable *other_seed = _BuildOrdered(2, GENERIC_TABLE_PROBE_GROUP);
+    GenericTable *robin_hood = _BuildOrdered(3, GENERIC_TABLE_PROBE_ROBIN_HOOD);
+    char *json1 = JsonSerializer_ToStr(table);
+    char *json2 = JsonSerializer_ToStr(other_seed);
+    char *json3 = JsonSerializer_ToStr(robin_hood);
+    if (strcmp(json1, json2) == 0 && strcmp(json1, json3) == 0)
+    {
+        s_out("OK, JSON output is the same for different seeds and probing");
+    }
+    else
+    {
+        s_out("failed, JSON output depends on the seed");
+    }
+    free(json1);
+    free(json2);
+    free(json3);
+    Delete_GenericTable(&table);
+    Delete_GenericTable(&other_seed);
+    Delete_GenericTable(&robin_hood);
+}
+
+void Cursor_Test()
+{
+    s_out("\n\nBegin GenericTable cursor test\n");
+
+    // 關閉 rehash_on_lookup，迭代時會同時走訪重構中的舊容器
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    options.rehash_on_lookup = false;
+    GenericTable *table = New_GenericTable_WithOptions(&options);
+    char key[32];
+    long sum = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        sprintf(key, "key_%d", i);
+        GenericTable_Add(table, key, i);
+        sum += i;
+    }
+
+    int count = 0;
+    long visited_sum = 0;
+    const char *cursor_key;
+    GenericType *cursor_value;
+    GenericTable_Cursor cursor = GenericTable_Begin(table);
+    while (GenericTable_Next(&cursor, &cursor_key, &cursor_value))
+    {
+        if (*GenericTable_Find_Int(table, cursor_key) != *GenericType_GetInt(cursor_value)) break;
+        visited_sum += *GenericType_GetInt(cursor_value);
+        count++;
+    }
+    if (count == 1000 && visited_sum == sum && !GenericTable_CursorInvalidated(&cursor))
+    {
+        s_out("OK, cursor visits every item once");
+    }
+    else
+    {
+        s_out_f("failed, cursor visits %d items", count);
+    }
+
+    // 迭代中新增 key 後，cursor 中斷
+    count = 0;
+    cursor = GenericTable_Begin(table);
+    while (GenericTable_Next(&cursor, NULL, NULL))
+    {
+        if (++count == 10) GenericTable_Add(table, "new_key", 0);
+    }
+    if (count == 10 && GenericTable_CursorInvalidated(&cursor))
+    {
+        s_out("OK, cursor stops after the table is modified");
+    }
+    else
+    {
+        s_out_f("failed, cursor visits %d items after the table is modified", count);
+    }
+
+    GenericTable *empty = New_GenericTable();
+    cursor = GenericTable_Begin(empty);
+    if (!GenericTable_Next(&cursor, NULL, NULL) && !GenericTable_CursorInvalidated(&cursor))
+    {
+        s_out("OK, cursor of an empty table ends immediately");
+    }
+    Delete_GenericTable(&empty);
+    Delete_GenericTable(&table);
+}
+
+/**
+ * 深入統計的命中分布應與逐一查找每個 key 的探測長度相同
+ */
+static bool _Stats_MatchProbeLength(GenericTable *table, const GenericTableStats *stats)
+{
+    int histogram[GENERIC_TABLE_PROBE_HISTOGRAM_SIZE] = {0};
+    GenericTable_Cursor cursor = GenericTable_Begin(table);
+    const char *key;
+    while (GenericTable_Next(&cursor, &key, NULL))
+    {
+        int probe = GenericTable_ProbeLength(table, key);
+        histogram[(probe < GENERIC_TABLE_PROBE_HISTOGRAM_SIZE ? probe : GENERIC_TABLE_PROBE_HISTOGRAM_SIZE) - 1]++;
+    }
+    return memcmp(histogram, stats->hit_histogram, sizeof(histogram)) == 0;
+}
+
+void Stats_Test()
+{
+    s_out("\n\nBegin GenericTable stats test\n");
+
+    GenericTableProbing probings[] = {GENERIC_TABLE_PROBE_GROUP, GENERIC_TABLE_PROBE_ROBIN_HOOD};
+    for (int p = 0; p < 2; p++)
+    {
+        GenericTableOptions options = GenericTable_DefaultOptions();
+        options.probing = probings[p];
+        options.load_factor = 90;
+        GenericTable *table = New_GenericTable_WithOptions(&options);
+        char key[64];
+        for (int i = 0; i < 5000; i++)
+        {
+            sprintf(key, "stats_key_with_a_long_name_%d", i);
+            GenericTable_Add(table, key, i);
+        }
+        for (int i = 0; i < 5000; i += 2)
+        {
+            sprintf(key, "stats_key_with_a_long_name_%d", i);
+            GenericTable_Delete(table, key);
+        }
+
+        GenericTableStats stats;
+        GenericTable_GetStats(table, &stats);
+        bool cheap_ok = stats.item_count == 2500 && stats.hit_histogram[0] == 0 && stats.miss_histogram[0] == 0;
+        long probe_count = stats.probe_count;
+
+        GenericTable_GetDeepStats(table, &stats);
+        int hits = 0;
+        int misses = 0;
+        for (int i = 0; i < GENERIC_TABLE_PROBE_HISTOGRAM_SIZE; i++)
+        {
+            hits += stats.hit_histogram[i];
+            misses += stats.miss_histogram[i];
+        }
+        s_out_f("%s probing:", probings[p] == GENERIC_TABLE_PROBE_GROUP ? "group" : "robin hood");
+        s_out_f("capacity = %d, items = %d, tombstones = %d, load factor = %.2f",
+            stats.capacity, stats.item_count, stats.tombstones, stats.load_factor);
+        s_out_f("grow = %d, shrink = %d, rehash = %d, bytes used = %zu",
+            stats.grow_count, stats.shrink_count, stats.rehash_count, stats.bytes_used);
+        s_out_f("average probe: hit = %.3f, miss = %.3f, max = %d",
+            stats.average_hit_probe, stats.average_miss_probe, stats.max_probe);
+        if (stats.counters_enabled)
+        {
+            s_out_f("finds = %ld, inserts = %ld, probes = %ld", stats.find_count, stats.insert_count, stats.probe_count);
+        }
+        // 深入統計不經過計數的探測迴圈，查找計數不變
+        if (cheap_ok && hits == 2500 && misses == stats.capacity && stats.grow_count > 0 && stats.bytes_used > 0
+            && stats.probe_count == probe_count && _Stats_MatchProbeLength(table, &stats))
+        {
+            s_out("OK, stats are consistent with the table");
+        }
+        else
+        {
+            s_out_f("failed, histogram has %d hits and %d misses", hits, misses);
+        }
+        Delete_GenericTable(&table);
+    }
+}
+
+void Upsert_Test()
+{
+    s_out("\n\nBegin GenericTable upsert test\n");
+
+    GenericTable *table = New_GenericTable();
+    const char *words[] = { "apple", "banana", "apple", "cherry", "banana", "apple" };
+    for (int i = 0; i < 6; i++)
+    {
+        bool inserted;
+        GenericType *count = GenericTable_GetOrInsert(table, words[i], &inserted);
+        if (inserted)
+            GenericType_Set_Int(count, 1);
+        else
+            (*GenericType_GetInt(count))++;
+    }
+    int *apple = GenericTable_Find_Int(table, "apple");
+    int *banana = GenericTable_Find_Int(table, "banana");
+    int *cherry = GenericTable_Find_Int(table, "cherry");
+    if (*apple == 3 && *banana == 2 && *cherry == 1 && GenericTable_Size(table) == 3)
+    {
+        s_out("OK, word counts are correct");
+    }
+    else
+    {
+        s_out_f("failed, apple = %d, banana = %d, cherry = %d", *apple, *banana, *cherry);
+    }
+
+    // 型別相同時就地更新，原本取得的指標仍指向新的值
+    GenericTable_Add(table, "apple", 100);
+    if (GenericTable_Find_Int(table, "apple") == apple && *apple == 100)
+    {
+        s_out("OK, updating an integer reuses the existing value");
+    }
+    else
+    {
+        s_out("failed, updating an integer reallocates the value");
+    }
+
+    GenericTable_Add(table, "apple", "red");
+    GenericTable_Add(table, "apple", "green");
+    if (GenericTable_ValueType(table, "apple") == GEN_TYPE_STR && strcmp(GenericTable_Find_Str(table, "apple"), "green") == 0)
+    {
+        s_out("OK, updating with another type replaces the value");
+    }
+    else
+    {
+        s_out("failed, value type is not changed");
+    }
+
+    bool inserted;
+    GenericTable_GetOrInsert(table, "empty", &inserted);
+    char *json = JsonSerializer_ToStr(table);
+    s_out_f("%s", json);
+    if (inserted && GenericTable_ValueType(table, "empty") == GEN_TYPE_NULL && strstr(json, "\"empty\":null"))
+    {
+        s_out("OK, value of a new key is null before it is set");
+    }
+    else
+    {
+        s_out("failed, value of a new key is not null");
+    }
+    free(json);
+    Delete_GenericTable(&table);
+}
+
+typedef struct _SnapshotReader
+{
+    GenericTableSnapshot *snapshot;
+    const char *expected;
+    int mismatches;
+} _SnapshotReader;
+
+static void* _ReadSnapshot(void *arg)
+{
+    _SnapshotReader *reader = (_SnapshotReader*) arg;
+    for (int i = 0; i < 50; i++)
+    {
+        GenericTable *root = GenericTableSnapshot_Begin(reader->snapshot);
+        char *json = JsonSerializer_ToStr(root);
+        GenericTableSnapshot_End(reader->snapshot);
+        if (strcmp(json, reader->expected) != 0) reader->mismatches++;
+        free(json);
+    }
+    return NULL;
+}
+
+static char* _SnapshotJson(GenericTableSnapshot *snapshot)
+{
+    GenericTable *root = GenericTableSnapshot_Begin(snapshot);
+    char *json = JsonSerializer_ToStr(root);
+    GenericTableSnapshot_End(snapshot);
+    return json;
+}
+
+void Snapshot_Test()
+{
+    s_out("\n\nBegin GenericTable snapshot test\n");
+
+    GenericTable *doc = _BuildDocument(NULL, 7);
+    char *before = JsonSerializer_ToStr(doc);
+    GenericTableSnapshot *snapshot = GenericTable_Snapshot(doc);
+    GenericTableSnapshot *middle = NULL;
+    char *middle_json = NULL;
+
+    // 讀取端在另一個執行緒輸出快照，寫入端同時修改每一層
+    _SnapshotReader reader = { snapshot, before, 0 };
+    pthread_t thread;
+    pthread_create(&thread, NULL, _ReadSnapshot, &reader);
+    for (int round = 0; round < 200; round++)
+    {
+        if (round == 100)
+        {
+            middle_json = JsonSerializer_ToStr(doc);
+            middle = GenericTable_Snapshot(doc);
+        }
+        (*GenericTable_Find_Int(doc, "id"))++;
+        GenericTable_Add(doc, "name", "renamed");
+        GenericTable_Add(GenericTable_Find_Table(doc, "field_3"), "index", round);
+
+        GenericList *tags = GenericType_GetList(GenericTable_GetOrInsert(doc, "tags", NULL));
+        GenericList_Add(tags, round);
+        GenericList_DeleteAt(tags, 0);
+        GenericType_Set(GenericList_At(tags, 0), -round);
+
+        char key[32];
+        sprintf(key, "extra_%d", round);
+        GenericTable_Add(doc, key, round);
+        if (round % 2) GenericTable_Delete(doc, key);
+    }
+    GenericTable_Delete(doc, "field_5");
+    pthread_join(thread, NULL);
+
+    char *after = _SnapshotJson(snapshot);
+    char *middle_after = _SnapshotJson(middle);
+    if (reader.mismatches == 0 && strcmp(before, after) == 0 && strcmp(middle_json, middle_after) == 0)
+    {
+        s_out("OK, snapshots keep the document as it was when they were taken");
+    }
+    else
+    {
+        s_out_f("failed, %d mismatches while writing\nbefore: %s\nafter:  %s", reader.mismatches, before, after);
+    }
+
+    GenericTable *field = GenericTable_Find_Table(doc, "field_3");
+    if (*GenericTable_Find_Int(doc, "id") == 207 && *GenericTable_Find_Int(field, "index") == 199
+        && !GenericTable_HasKey(doc, "field_5") && GenericTable_Size(doc) == 111)
+    {
+        s_out("OK, the live document has every write");
+    }
+    else
+    {
+        s_out_f("failed, live id = %d, size = %d", *GenericTable_Find_Int(doc, "id"), GenericTable_Size(doc));
+    }
+
+    // 快照持有映射表的參考，解構目前的映射表後仍可讀取
+    Delete_GenericTable(&doc);
+    char *orphan = _SnapshotJson(snapshot);
+    if (strcmp(before, orphan) == 0)
+    {
+        s_out("OK, snapshot is readable after the live table is deleted");
+    }
+    else
+    {
+        s_out("failed, snapshot changed after the live table is deleted");
+    }
+
+    free(before);
+    free(after);
+    free(middle_json);
+    free(middle_after);
+    free(orphan);
+    Delete_GenericTableSnapshot(&middle);
+    Delete_GenericTableSnapshot(&snapshot);
+
+    // 快照存在時，輸出 JSON 與去重只讀取動態陣列的元素，不會複製與快照共用的元素
+    GenericTable *live = _BuildDocument(NULL, 3);
+    GenericList *tags = GenericType_GetList(GenericTable_GetOrInsert(live, "tags", NULL));
+    GenericType *first_tag = GenericList_Get(tags, 0);
+    GenericType *last_tag = GenericList_Get(tags, GenericList_Size(tags) - 1);
+    GenericTableSnapshot *held = GenericTable_Snapshot(live);
+    char *json = JsonSerializer_ToStr(live);
+    GenericDedup *dedup = New_GenericDedup();
+    GenericDedup_Table(dedup, live);
+    if (GenericList_Get(tags, 0) == first_tag && GenericList_Get(tags, GenericList_Size(tags) - 1) == last_tag)
+    {
+        s_out("OK, serializing and dedup keep list elements shared with the snapshot");
+    }
+    else
+    {
+        s_out("failed, list elements are copied by a read only walk");
+    }
+    free(json);
+    Delete_GenericDedup(&dedup);
+    Delete_GenericTableSnapshot(&held);
+    Delete_GenericTable(&live);
+}
+
+void SharedSubtree_Test()
+{
+    s_out("\n\nBegin GenericTable shared subtree test\n");
+
+    GenericTable *config = New_GenericTable();
+    GenericTable_Add(config, "timeout", 30);
+    GenericList *hosts = New_GenericList();
+    GenericList_Add(hosts, "a.example.com");
+    GenericList_Add(hosts, "b.example.com");
+    GenericTable_Add(config, "hosts", hosts);
+
+    // 同一個設定片段放入 1000 個上層映射表與一個動態陣列，不複製
+    GenericTable *parents[1000];
+    GenericList *all = New_GenericList();
+    for (int i = 0; i < 1000; i++)
+    {
+        parents[i] = New_GenericTable();
+        GenericTable_Add(parents[i], "id", i);
+        GenericTable_Add(parents[i], "config", GenericTable_Retain(config));
+    }
+    GenericList_Add(all, GenericTable_Retain(config));
+    Delete_GenericTable(&config);
+
+    bool correct = GenericTable_Find_Table(parents[0], "config") == GenericTable_Find_Table(parents[999], "config")
+        && GenericType_GetTable(GenericList_At(all, 0)) == GenericTable_Find_Table(parents[0], "config");
+
+    // 快照任一個上層映射表都包含共用的子樹，之後經由另一個上層映射表修改也不影響快照
+    GenericTableSnapshot *snapshot = GenericTable_Snapshot(parents[500]);
+    *GenericTable_Find_Int(GenericTable_Find_Table(parents[0], "config"), "timeout") = 60;
+    GenericTable *root = GenericTableSnapshot_Begin(snapshot);
+    correct = correct && *GenericTable_Find_Int(GenericTable_Find_Table(root, "config"), "timeout") == 30;
+    GenericTableSnapshot_End(snapshot);
+    correct = correct && *GenericTable_Find_Int(GenericTable_Find_Table(parents[999], "config"), "timeout") == 60;
+
+    // 上層映射表依任意順序解構，最後一個上層容器解構時才釋放子樹
+    for (int i = 0; i < 1000; i += 2)
+    {
+        Delete_GenericTable(&(parents[i]));
+    }
+    Delete_GenericTableSnapshot(&snapshot);
+    for (int i = 1; i < 1000; i += 2)
+    {
+        Delete_GenericTable(&(parents[i]));
+    }
+    GenericTable *left = GenericType_GetTable(GenericList_At(all, 0));
+    correct = correct && *GenericTable_Find_Int(left, "timeout") == 60
+        && GenericList_Size(GenericType_GetList(GenericTable_GetOrInsert(left, "hosts", NULL))) == 2;
+    Delete_GenericList(&all);
+
+    s_out(correct ? "OK, one subtree shared by 1001 parents" : "failed, shared subtree");
+}
+
+#define _BULK_UNIQUE 100000
+#define _BULK_REPEATED 1000
+
+/**
+ * 檢查 FromArrays 建構的映射表：最後 _BULK_REPEATED 組重複前面的 key，值應為最後一組
+ */
+static bool _CheckBulkTable(GenericTable *table, char **keys)
+{
+    if (GenericTable_Size(table) != _BULK_UNIQUE) return false;
+
+    for (int i = 0; i < _BULK_UNIQUE; i++)
+    {
+        if (i >= _BULK_REPEATED && i % 11 == 0)
+        {
+            const char *str = GenericTable_Find_Str(table, keys[i]);
+            if (!str || strcmp(str, keys[i]) != 0) return false;
+            continue;
+        }
+        int *value = GenericTable_Find_Int(table, keys[i]);
+        if (!value || *value != (i < _BULK_REPEATED ? -i : i)) return false;
+    }
+    return true;
+}
+
+void FromArrays_Test()
+{
+    s_out("\n\nBegin GenericTable from arrays test\n");
+
+    int n = _BULK_UNIQUE + _BULK_REPEATED;
+    char **keys = (char**) malloc(sizeof(char*) * n);
+    const void **values = (const void**) malloc(sizeof(void*) * n);
+    GenericTypeEnum *types = (GenericTypeEnum*) malloc(sizeof(GenericTypeEnum) * n);
+    int *ints = (int*) malloc(sizeof(int) * n);
+    for (int i = 0; i < _BULK_UNIQUE; i++)
+    {
+        // 一部分 key 超過 inline 的長度，放在另外配置的連續記憶體
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), i % 7 == 0 ? "a_key_longer_than_the_inline_buffer_%d" : "key_%d", i);
+        keys[i] = strdup(buffer);
+        ints[i] = i;
+        types[i] = i % 11 == 0 ? GEN_TYPE_STR : GEN_TYPE_INT;
+        values[i] = i % 11 == 0 ? (const void*) keys[i] : (const void*) &ints[i];
+    }
+    for (int i = _BULK_UNIQUE; i < n; i++)
+    {
+        int repeated = i - _BULK_UNIQUE;
+        keys[i] = keys[repeated];
+        ints[i] = -repeated;
+        types[i] = GEN_TYPE_INT;
+        values[i] = &ints[i];
+    }
+
+    const char *labels[] = {
+        "single thread", "4 threads", "4 threads robin hood", "4 threads pow2", "4 threads ordered", "4 threads intern keys"
+    };
+    for (int config = 0; config < 6; config++)
+    {
+        GenericTableOptions options = GenericTable_DefaultOptions();
+        options.build_threads = config == 0 ? 1 : 4;
+        if (config == 2) options.probing = GENERIC_TABLE_PROBE_ROBIN_HOOD;
+        if (config == 3) options.sizing = GENERIC_TABLE_SIZE_POW2;
+        if (config == 4) options.ordered = true;
+        if (config == 5) options.intern_keys = true;
+
+        GenericTable *table = GenericTable_FromArrays((const char**) keys, values, types, n, &options);
+        bool correct = _CheckBulkTable(table, keys);
+        int capacity = GenericTable_Capacity(table);
+
+        // 建構後照常新增、刪除，連續記憶體中的映射物件不會個別釋放
+        for (int i = 0; i < _BULK_UNIQUE; i += 2)
+        {
+            GenericTable_Delete(table, keys[i]);
+        }
+        for (int i = 0; i < _BULK_UNIQUE; i += 2)
+        {
+            GenericTable_Add(table, keys[i], i < _BULK_REPEATED ? -i : i);
+            if (i >= _BULK_REPEATED && i % 11 == 0) GenericTable_Add(table, keys[i], keys[i]);
+        }
+        correct = correct && _CheckBulkTable(table, keys);
+
+        if (config == 4)
+        {
+            int index = 0;
+            GenericTable_Cursor cursor = GenericTable_Begin(table);
+            const char *key;
+            struct GenericType *value;
+            while (GenericTable_Next(&cursor, &key, &value) && index < _BULK_UNIQUE / 2)
+            {
+                if (strcmp(key, keys[index * 2 + 1]) != 0) correct = false;
+                index++;
+            }
+        }
+
+        if (correct)
+        {
+            s_out_f("OK, %s, capacity = %d", labels[config], capacity);
+        }
+        else
+        {
+            s_out_f("failed, %s", labels[config]);
+        }
+        Delete_GenericTable(&table);
+    }
+
+    clock_t begin = clock();
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    options.build_threads = 4;
+    GenericTable *bulk = GenericTable_FromArrays((const char**) keys, values, types, n, &options);
+    double bulk_ms = (double) (clock() - begin) / CLOCKS_PER_SEC * 1000;
+
+    begin = clock();
+    GenericTable *added = New_GenericTable();
+    for (int i = 0; i < n; i++)
+    {
+        if (types[i] == GEN_TYPE_STR)
+            GenericTable_Add(added, keys[i], keys[i]);
+        else
+            GenericTable_Add(added, keys[i], ints[i]);
+    }
+    double add_ms = (double) (clock() - begin) / CLOCKS_PER_SEC * 1000;
+    s_out_f("from arrays: %f ms (cpu), add one by one: %f ms", bulk_ms, add_ms);
+    Delete_GenericTable(&bulk);
+    Delete_GenericTable(&added);
+
+    // 負載係數為 0 或選項全部歸零時，換算容器大小前改用預設的負載係數
+    for (int config = 0; config < 2; config++)
+    {
+        GenericTableOptions zero_options = GenericTable_DefaultOptions();
+        if (config == 0) zero_options.load_factor = 0;
+        else memset(&zero_options, 0, sizeof(GenericTableOptions));
+
+        GenericTable *table = GenericTable_FromArrays((const char**) keys, values, types, n, &zero_options);
+        if (table && _CheckBulkTable(table, keys))
+        {
+            s_out_f("OK, %s, capacity = %d", config == 0 ? "load factor 0" : "zeroed options", GenericTable_Capacity(table));
+        }
+        else
+        {
+            s_out_f("failed, %s", config == 0 ? "load factor 0" : "zeroed options");
+        }
+        Delete_GenericTable(&table);
+    }
+
+    for (int i = 0; i < _BULK_UNIQUE; i++)
+    {
+        free(keys[i]);
+    }
+    free(keys);
+    free(values);
+    free(types);
+    free(ints);
+}
+
+void InternKeys_Test()
+{
+    s_out("\n\nBegin GenericTable intern keys test\n");
+
+    size_t before = GenericString_InternedCount();
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    options.intern_keys = true;
+    GenericTable *first = New_GenericTable_WithOptions(&options);
+    options.hash_fn = HashUtil_Fnv1aHash;
+    GenericTable *second = New_GenericTable_WithOptions(&options);
+
+    // 1000 筆紀錄只有 4 種長 key 與 3 種字串值
+    const char *fields[] = {
+        "customer_account_status_code", "customer_billing_region_name",
+        "customer_preferred_language", "customer_subscription_tier"
+    };
+    const char *states[] = { "active", "suspended", "closed" };
+    char key[64];
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(key, sizeof(key), "%s", fields[i % 4]);
+        GenericTable *table = (i / 4) % 2 ? first : second;
+        GenericTable_Add(table, key, states[i % 3]);
+        GenericTable_Add(table, "short", i);
+    }
+    size_t interned = GenericString_InternedCount() - before;
+    s_out_f("interned strings: %zu (4 keys + 3 values)", interned);
+
+    GenericTable_Add(second, fields[1], "suspended");
+    bool correct = interned == 7
+        && GenericTable_Find_Str(first, fields[1]) == GenericTable_Find_Str(second, fields[1])
+        && *GenericTable_Find_Int(first, "short") == 999;
+
+    // 快照後寫入會複製映射物件，複製的 key 仍共用同一個字串
+    GenericTableSnapshot *snapshot = GenericTable_Snapshot(first);
+    GenericTable_Add(first, fields[1], "closed");
+    GenericTable_Delete(first, fields[3]);
+    GenericTable *root = GenericTableSnapshot_Begin(snapshot);
+    correct = correct && strcmp(GenericTable_Find_Str(root, fields[1]), "suspended") == 0 && GenericTable_HasKey(root, fields[3]);
+    GenericTableSnapshot_End(snapshot);
+    Delete_GenericTableSnapshot(&snapshot);
+    correct = correct && strcmp(GenericTable_Find_Str(first, fields[1]), "closed") == 0
+        && !GenericTable_HasKey(first, fields[3]);
+
+    Delete_GenericTable(&first);
+    Delete_GenericTable(&second);
+    correct = correct && GenericString_InternedCount() == before;
+    s_out(correct ? "OK, keys and values shared across tables" : "failed, intern keys");
+}
+
+/**
+ * 以 count 份文件組成一棵大型文件樹
+ */
+static GenericTable* _BuildLargeDocument(int count)
+{
+    GenericTable *root = New_GenericTable();
+    GenericList *docs = New_GenericList();
+    for (int i = 0; i < count; i++)
+    {
+        GenericList_Add(docs, _BuildDocument(NULL, i));
+    }
+    GenericTable_Add(root, "docs", docs);
+    GenericTable_Add(root, "version", 1);
+    return root;
+}
+
+void Equals_Test()
+{
+    s_out("\n\nBegin GenericTable equals and hash test\n");
+
+    // malloc 與 arena 建立的文件內容相同，雜湊值也相同
+    GenericArena *arena = New_GenericArena();
+    GenericTable *heap_doc = _BuildDocument(NULL, 7);
+    GenericTable *arena_doc = _BuildDocument(arena, 7);
+    bool correct = GenericTable_Equals(heap_doc, arena_doc) && GenericTable_Hash(heap_doc) == GenericTable_Hash(arena_doc);
+
+    // 映射表與插入順序、雜湊函式無關，動態陣列與元素順序有關
+    GenericTableOptions options = GenericTable_DefaultOptions();
+    options.hash_fn = HashUtil_Fnv1aHash;
+    options.ordered = true;
+    GenericTable *forward = New_GenericTable();
+    GenericTable *backward = New_GenericTable_WithOptions(&options);
+    GenericList *ascending = New_GenericList();
+    GenericList *descending = New_GenericList();
+    for (int i = 0; i < 100; i++)
+    {
+        char key[32];
+        sprintf(key, "key_%d", i);
+        GenericTable_Add(forward, key, i);
+        sprintf(key, "key_%d", 99 - i);
+        GenericTable_Add(backward, key, 99 - i);
+        GenericList_Add(ascending, i);
+        GenericList_Add(descending, 99 - i);
+    }
+    correct = correct && GenericTable_Equals(forward, backward) && GenericTable_Hash(forward) == GenericTable_Hash(backward)
+        && !GenericList_Equals(ascending, descending) && GenericList_Hash(ascending) != GenericList_Hash(descending);
+    GenericTable_Add(backward, "key_0", 0L);
+    correct = correct && !GenericTable_Equals(forward, backward) && GenericTable_Hash(forward) != GenericTable_Hash(backward);
+    Delete_GenericTable(&forward);
+    Delete_GenericTable(&backward);
+    Delete_GenericList(&ascending);
+    Delete_GenericList(&descending);
+
+    // 記下雜湊值後修改巢狀的值，文件與所有上層容器都須重算
+    uint64_t hash = GenericTable_Hash(heap_doc);
+    GenericTable *field = GenericTable_Find_Table(heap_doc, "field_3");
+    GenericTable_Add(field, "label", "changed");
+    correct = correct && GenericTable_Hash(heap_doc) != hash && !GenericTable_Equals(heap_doc, arena_doc);
+    GenericTable_Add(field, "label", "field");
+    correct = correct && GenericTable_Hash(heap_doc) == hash && GenericTable_Equals(heap_doc, arena_doc);
+    *GenericTable_Find_Int(field, "index") = 30;
+    correct = correct && GenericTable_Hash(heap_doc) != hash;
+    *GenericTable_Find_Int(field, "index") = 3;
+    GenericType_Set(GenericList_At(GenericType_GetList(GenericTable_GetOrInsert(heap_doc, "tags", NULL)), 5), 50);
+    correct = correct && GenericTable_Hash(heap_doc) != hash && !GenericTable_Equals(heap_doc, arena_doc);
+    Delete_GenericTable(&heap_doc);
+    Delete_GenericArena(&arena);
+
+    // 共用的子樹修改後，每個上層容器都須重算
+    GenericTable *shared = New_GenericTable();
+    GenericTable_Add(shared, "timeout", 30);
+    GenericTable *left = New_GenericTable();
+    GenericTable *right = New_GenericTable();
+    GenericTable_Add(left, "config", GenericTable_Retain(shared));
+    GenericTable_Add(right, "config", shared);
+    uint64_t left_hash = GenericTable_Hash(left);
+    uint64_t right_hash = GenericTable_Hash(right);
+    GenericTable_Add(shared, "timeout", 60);
+    correct = correct && left_hash == right_hash && GenericTable_Hash(left) != left_hash && GenericTable_Hash(right) != right_hash
+        && GenericTable_Equals(left, right);
+    Delete_GenericTable(&left);
+    Delete_GenericTable(&right);
+
+    s_out(correct ? "OK, deep equality and structural hash" : "failed, equals and hash");
+
+    // 大型文件：第一次計算走訪整棵樹，之後只重算修改過的路徑
+    int count = 2000;
+    GenericTable *large = _BuildLargeDocument(count);
+    GenericTable *copy = _BuildLargeDocument(count);
+    char *json = JsonSerializer_ToStr(large);
+    s_out_f("large document json is %zu bytes", strlen(json));
+    free(json);
+
+    clock_t begin = clock();
+    GenericTable_Equals(large, copy);
+    s_out_f("deep equals took %f milli seconds", (double) (clock() - begin) / CLOCKS_PER_SEC * 1000);
+
+    begin = clock();
+    uint64_t first = GenericTable_Hash(large);
+    GenericTable_Hash(copy);
+    s_out_f("first hash of both took %f milli seconds", (double) (clock() - begin) / CLOCKS_PER_SEC * 1000);
+
+    GenericList *docs = GenericType_GetList(GenericTable_GetOrInsert(large, "docs", NULL));
+    GenericTable *doc = GenericType_GetTable(GenericList_At(docs, count / 2));
+    begin = clock();
+    int rounds = 1000;
+    bool detected = true;
+    for (int i = 0; i < rounds; i++)
+    {
+        GenericTable_Add(doc, "id", i % 2 ? count / 2 : -1);
+        detected = detected && (GenericTable_Hash(large) == first) == (i % 2 == 1);
+    }
+    s_out_f("%d changes detected by hash took %f milli seconds", rounds, (double) (clock() - begin) / CLOCKS_PER_SEC * 1000);
+
+    // 兩者都記下雜湊值時，不相等通常只需比較雜湊值
+    GenericTable_Add(doc, "id", -1);
+    GenericTable_Hash(large);
+    begin = clock();
+    for (int i = 0; i < rounds; i++)
+    {
+        detected = detected && !GenericTable_Equals(large, copy);
+    }
+    s_out_f("%d unequal compares took %f milli seconds", rounds, (double) (clock() - begin) / CLOCKS_PER_SEC * 1000);
+    s_out(detected ? "OK, every change detected" : "failed, change detection");
+    Delete_GenericTable(&large);
+    Delete_GenericTable(&copy);
+
+    // 找不到、型態不符的查找與唯讀的字串查找不會修改值，記下的雜湊值仍可使用，不需每次重新走訪
+    GenericTable *flat = New_GenericTable();
+    GenericTable_Add(flat, "label", "flat");
+    for (int i = 0; i < 100000; i++)
+    {
+        char key[32];
+        sprintf(key, "key_%d", i);
+        GenericTable_Add(flat, key, i);
+    }
+    begin = clock();
+    uint64_t flat_hash = GenericTable_Hash(flat);
+    clock_t full = clock() - begin;
+    bool kept = true;
+    begin = clock();
+    for (int i = 0; i < rounds; i++)
+    {
+        kept = kept && !GenericTable_Find_Int(flat, "missing") && !GenericTable_Find_Double(flat, "key_7")
+            && GenericTable_Find_Str(flat, "label");
+        kept = kept && GenericTable_Hash(flat) == flat_hash;
+    }
+    clock_t cached = clock() - begin;
+    *GenericTable_Find_Int(flat, "key_7") = -7;
+    kept = kept && GenericTable_Hash(flat) != flat_hash;
+    if (kept && cached < full)
+    {
+        s_out_f("OK, %d read only finds keep the cached hash, %f milli seconds", rounds, (double) cached / CLOCKS_PER_SEC * 1000);
+    }
+    else
+    {
+        s_out_f("failed, %d read only finds took %f milli seconds, one full hash took %f milli seconds",
+            rounds, (double) cached / CLOCKS_PER_SEC * 1000, (double) full / CLOCKS_PER_SEC * 1000);
+    }
+    Delete_GenericTable(&flat);
+}
+
+/**
+ * 模擬一筆紀錄：設定、地址、標籤只有少數幾種，id 每筆不同
+ */
+static GenericTable* _BuildRecord(int id)
+{
+    GenericTable *record = New_GenericTable();
+    GenericTable_Add(record, "id", id);
+
+    GenericTable *config = New_GenericTable();
+    GenericTable_Add(config, "timeout", 30);
+    GenericTable_Add(config, "retries", 3);
+    GenericTable_Add(config, "endpoint", "https://api.example.com/v1/records");
+    GenericList *hosts = New_GenericList();
+    GenericList_Add(hosts, "a.example.com");
+    GenericList_Add(hosts, "b.example.com");
+    GenericTable_Add(config, "hosts", hosts);
+    GenericTable_Add(record, "config", config);
+
+    GenericTable *address = New_GenericTable();
+    char city[32];
+    sprintf(city, "city_%d", id % 10);
+    GenericTable_Add(address, "city", city);
+    GenericTable_Add(address, "country", "TW");
+    GenericTable_Add(address, "zip", 100 + id % 10);
+    GenericTable_Add(record, "address", address);
+
+    GenericList *tags = New_GenericList();
+    for (int i = 0; i < 16; i++)
+    {
+        GenericList_Add(tags, (id + i) % 4);
+    }
+    GenericTable_Add(record, "tags", tags);
+    return record;
+}
+
+/**
+ * 子樹中每個映射表、動態陣列本身的位元組數，共用的節點重複計算
+ */
+static size_t _TreeBytes(GenericType *value)
+{
+    size_t bytes = 0;
+    if (GenericType_IsType(value, GEN_TYPE_TABLE))
+    {
+        GenericTable *table = GenericType_GetTable(value);
+        bytes += GenericTable_BytesUsed(table);
+        GenericTable_Cursor cursor = GenericTable_Begin(table);
+        GenericType *child;
+        while (GenericTable_Next(&cursor, NULL, &child))
+        {
+            bytes += _TreeBytes(child);
+        }
+    }
+    else if (GenericType_IsType(value, GEN_TYPE_LIST))
+    {
+        GenericList *list = GenericType_GetList(value);
+        bytes += GenericList_BytesUsed(list);
+        for (int i = 0; i < GenericList_Size(list); i++)
+        {
+            bytes += _TreeBytes(GenericList_Get(list, i));
+        }
+    }
+    return bytes;
+}
+
+void Dedup_Test()
+{
+    s_out("\n\nBegin GenericDedup test\n");
+
+    int count = 20000;
+    GenericTable *root = New_GenericTable();
+    GenericList *records = New_GenericList();
+    for (int i = 0; i < count; i++)
+    {
+        GenericList_Add(records, _BuildRecord(i));
+    }
+    GenericTable_Add(root, "records", records);
+    size_t total = _TreeBytes(GenericTable_GetOrInsert(root, "records", NULL));
+    char *before = JsonSerializer_ToStr(root);
+
+    GenericDedup *dedup = New_GenericDedup();
+    clock_t begin = clock();
+    size_t saved = GenericDedup_Table(dedup, root);
+    s_out_f("dedup %d records took %f milli seconds, %d subtrees shared, %d unique nodes",
+        count, (double) (clock() - begin) / CLOCKS_PER_SEC * 1000, GenericDedup_SharedCount(dedup), GenericDedup_UniqueCount(dedup));
+    s_out_f("saved %zu of %zu bytes, %.1fx smaller", saved, total, (double) total / (total - saved));
+
+    // 內容不變，相同的子樹共用同一個節點
+    char *after = JsonSerializer_ToStr(root);
+    GenericTable *first = GenericType_GetTable(GenericList_At(records, 0));
+    GenericTable *other = GenericType_GetTable(GenericList_At(records, 10));
+    bool correct = strcmp(before, after) == 0 && saved == GenericDedup_BytesSaved(dedup)
+        && GenericTable_Find_Table(first, "config") == GenericTable_Find_Table(other, "config")
+        && GenericTable_Find_Table(first, "address") == GenericTable_Find_Table(other, "address")
+        && GenericTable_Find_Table(first, "address") != GenericTable_Find_Table(GenericType_GetTable(GenericList_At(records, 1)), "address")
+        && GenericTable_Find_Table(first, "config") != NULL && first != other;
+    free(before);
+    free(after);
+
+    // 之後載入的文件與先前的文件共用子樹，整份相同的紀錄直接取代，不必走訪
+    GenericTable *later = New_GenericTable();
+    GenericTable_Add(later, "copy", _BuildRecord(10));
+    GenericTable_Add(later, "new", _BuildRecord(count + 10));
+    correct = correct && GenericDedup_Table(dedup, later) > 0
+        && GenericTable_Find_Table(later, "copy") == other
+        && GenericTable_Find_Table(GenericTable_Find_Table(later, "new"), "config") == GenericTable_Find_Table(first, "config");
+
+    // 再次去重不再省下任何位元組
+    correct = correct && GenericDedup_Table(dedup, root) == 0;
+
+    Delete_GenericDedup(&dedup);
+    Delete_GenericTable(&later);
+    Delete_GenericTable(&root);
+    s_out(correct ? "OK, identical subtrees shared" : "failed, dedup");
+}
+
 int main(int argc, char** argv)
 {
     Time_Test();
     Generic_Test();
     Dynamic_Type();
     NestHybridStructure_Test();
+    Hasher_Test();
+    Incremental_Rehash_Test();
+    RobinHood_Test();
+    FindMany_Test();
+    InlineKey_Test();
+    Arena_Test();
+    Reserve_Test();
+    Sizing_Test();
+    LoadFactor_Test();
+    Ordered_Test();
+    Cursor_Test();
+    Stats_Test();
+    Upsert_Test();
+    Snapshot_Test();
+    SharedSubtree_Test();
+    FromArrays_Test();
+    InternKeys_Test();
+    Equals_Test();
+    Dedup_Test();
 }
 
 
@@ -2,12 +2,21 @@ sudo gcc \
     main.c \
     ../../src/string_builder.c \
     ../../src/number_util.c\
+    ../../src/hash_util.c\
+    ../../src/epoch_util.c\
+    ../../src/cow_util.c\
     ../../src/common_util.c\
+    ../../src/generic_arena.c\
+    ../../src/generic_pool.c\
+    ../../src/generic_string.c\
     ../../src/generic_type.c\
     ../../src/generic_table.c\
+    ../../src/generic_concurrent_table.c\
+    ../../src/generic_read_mostly_table.c\
     ../../src/generic_list.c\
+    ../../src/generic_dedup.c\
     ../../src/json_serializer.c\
     -o\
     test\
-    -lm # 連接數學庫(math.h)
+    -lm -lpthread # 連接數學庫(math.h)、執行緒庫(pthread.h)
 ./test
\ No newline at end of file
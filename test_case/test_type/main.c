@@ -9,6 +9,8 @@
 #include "../../include/generic_type.h"
 #include "../../include/string_builder.h"
 #include "../../include/common_util.h"
+#include "../../include/generic_pool.h"
+#include "../../include/generic_string.h"
 
 void Test_GenericType_Equals()
 {
@@ -40,9 +42,160 @@ void Test_GenericType_Equals()
     {
         s_out("null is not equals null");
     }
+
+    GenericType *long_obj = New_GenericType(5L);
+    GenericType *str1 = New_GenericType("value");
+    GenericType *str2 = New_GenericType("value");
+    if (!GenericType_Equals(obj1, long_obj) && GenericType_Equals(str1, str2) && GenericType_Hash(str1) == GenericType_Hash(str2))
+    {
+        s_out("int is not equals long, equal strings have the same hash");
+    }
+
+    GenericTable *table1 = New_GenericTable();
+    GenericTable *table2 = New_GenericTable();
+    GenericTable_Add(table1, "a", 1);
+    GenericTable_Add(table1, "b", 0.0);
+    GenericTable_Add(table2, "b", -0.0);
+    GenericTable_Add(table2, "a", 1);
+    GenericType *table_obj1 = New_Table_GenericType(table1);
+    GenericType *table_obj2 = New_Table_GenericType(table2);
+    if (GenericType_Equals(table_obj1, table_obj2) && GenericType_Hash(table_obj1) == GenericType_Hash(table_obj2))
+    {
+        s_out("tables with the same items are equal");
+    }
+    GenericTable_Add(table2, "c", "more");
+    if (!GenericType_Equals(table_obj1, table_obj2) && GenericType_Hash(table_obj1) != GenericType_Hash(table_obj2))
+    {
+        s_out("table with one more item is not equal");
+    }
+
+    Delete_GenericType(&obj1);
+    Delete_GenericType(&obj2);
+    Delete_GenericType(&obj3);
+    Delete_GenericType(&long_obj);
+    Delete_GenericType(&str1);
+    Delete_GenericType(&str2);
+    Delete_GenericType(&table_obj1);
+    Delete_GenericType(&table_obj2);
+}
+
+void Test_GenericType_Set()
+{
+    s_out("\n\nBegin GenericType_Set test");
+    GenericType *obj = New_GenericType(5);
+    int *p_int = GenericType_GetInt(obj);
+    GenericType_Set(obj, 6);
+    if (GenericType_GetInt(obj) == p_int && *p_int == 6)
+    {
+        s_out("set integer in place");
+    }
+
+    GenericType_Set(obj, "a long string value");
+    GenericType_Set(obj, "short");
+    GenericType *same = New_GenericType("short");
+    const char *p_str = GenericType_GetStr(obj);
+    if (GenericType_GetStr(same) == p_str && strcmp(p_str, "short") == 0)
+    {
+        s_out("equal strings share one copy");
+    }
+    Delete_GenericType(&same);
+    GenericType_Set(obj, p_str + 1);
+    if (strcmp(GenericType_GetStr(obj), "hort") == 0)
+    {
+        s_out("set string from itself");
+    }
+
+    GenericType_Set(obj, 2.5);
+    if (GenericType_IsType(obj, GEN_TYPE_DOUBLE) && *GenericType_GetDouble(obj) == 2.5)
+    {
+        s_out("change type from string to double");
+    }
+
+    GenericType *null_obj = New_Null_GenericType();
+    if (GenericType_IsType(null_obj, GEN_TYPE_NULL) && !GenericType_GetInt(null_obj))
+    {
+        s_out("null object has no value");
+    }
+    Delete_GenericType(&null_obj);
+    Delete_GenericType(&obj);
+}
+
+void Test_GenericString()
+{
+    s_out("\n\nBegin GenericString test");
+    size_t before = GenericString_InternedCount();
+    char buf[16];
+    strcpy(buf, "enum_value");
+    GenericString *a = GenericString_Intern(buf, strlen(buf));
+    GenericString *b = GenericString_Intern("enum_value_tail", 10);
+    if (a == b && GenericString_Length(a) == 10 && strcmp(GenericString_Chars(a), "enum_value") == 0)
+    {
+        s_out("interned strings compare by pointer");
+    }
+    if (GenericString_Hash(a) == GenericString_HashOf("enum_value", 10))
+    {
+        s_out("hash is cached");
+    }
+
+    GenericType *obj = New_GenericType("enum_value");
+    GenericType *copy = GenericType_Clone(obj);
+    if (GenericType_GetString(copy) == a && GenericString_InternedCount() == before + 1)
+    {
+        s_out("values share the interned string");
+    }
+    GenericType_Set(copy, GenericString_Retain(b));
+    Delete_GenericType(&obj);
+    Delete_GenericType(&copy);
+    Delete_GenericString(&a);
+    Delete_GenericString(&b);
+    if (GenericString_InternedCount() == before)
+    {
+        s_out("released when the last reference is deleted");
+    }
+
+    clock_t start = clock();
+    const char *words[] = {"active", "inactive", "pending", "deleted"};
+    GenericType **objs = (GenericType**) malloc(1000000 * sizeof(GenericType*));
+    for (int i = 0; i < 1000000; i++) objs[i] = New_GenericType(words[i & 3]);
+    for (int i = 0; i < 1000000; i++) Delete_GenericType(&(objs[i]));
+    free(objs);
+    s_out_f("new and delete 1000000 repeated strings: %.3f s", (double) (clock() - start) / CLOCKS_PER_SEC);
+}
+
+void Test_GenericPool()
+{
+    static GenericPool pool = GENERIC_POOL_INIT(40);
+    const int count = 0x1000;
+    void **objects = (void**) malloc(count * sizeof(void*));
+    for (int i = 0; i < count; i++)
+    {
+        objects[i] = GenericPool_Alloc(&pool);
+        memset(objects[i], i & 0xFF, 40);
+    }
+    size_t reserved = GenericPool_BytesReserved(&pool);
+    for (int i = 0; i < count; i++) GenericPool_Free(&pool, objects[i]);
+
+    for (int i = 0; i < count; i++) objects[i] = GenericPool_Alloc(&pool);
+    if (GenericPool_BytesReserved(&pool) == reserved)
+    {
+        s_out("reuse freed objects without new slabs");
+    }
+    for (int i = 0; i < count; i++) GenericPool_Free(&pool, objects[i]);
+    free(objects);
+
+    clock_t start = clock();
+    for (int i = 0; i < 1000000; i++)
+    {
+        GenericType *obj = New_GenericType(i);
+        Delete_GenericType(&obj);
+    }
+    s_out_f("new and delete 1000000 GenericType: %.3f s", (double) (clock() - start) / CLOCKS_PER_SEC);
 }
 
 int main(int argc, char **argv)
 {
     Test_GenericType_Equals();
+    Test_GenericType_Set();
+    Test_GenericString();
+    Test_GenericPool();
 }
\ No newline at end of file